@@ -1,13 +1,21 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
 layout(location = 0) in vec3 fragColor;
 layout(location = 1) in vec3 fragPosWorld;
 layout(location = 2) in vec3 fragNormalWorld;
 layout(location = 3) in vec2 fragUV;
+layout(location = 4) flat in uint fragTextureIndex;
+layout(location = 5) flat in uint fragTextureArrayIndex;
+layout(location = 6) flat in uint fragTextureLayer;
 
 layout(location = 0) out vec4 outColor;
 
+const uint MAX_LIGHTS_PER_CLUSTER = 128;
+const uint NO_TEXTURE_ARRAY = 0xFFFFFFFFu;
+
 struct PointLight {
-    vec4 position; // ignore w
+    vec4 position; // w is range
     vec4 color; // w is intensity
 };
 
@@ -16,16 +24,44 @@ layout(set = 0, binding = 0) uniform GlobalUBO {
     mat4 view;
     mat4 invView;
     vec4 ambientLightColor; // w is intensity
-    PointLight pointLights[10];
-    int numLights;
 } ubo;
 
-layout(set = 0, binding = 1) uniform sampler2D image;
 
-layout(push_constant) uniform Push {
-    mat4 modelMatrix; // projection * view * model
-    mat4 normalMatrix;
-} push;
+layout(set = 2, binding = 0) uniform LightClusterData {
+    mat4 inverseProjection;
+    mat4 view;
+    uvec4 gridSize; // w is the light count
+    vec2 tileScale;
+    float sliceScale;
+    float sliceBias;
+    float near;
+    float far;
+} clusters;
+
+layout(std430, set = 2, binding = 1) readonly buffer LightBuffer {
+    PointLight lights[];
+} lightBuffer;
+
+layout(std430, set = 2, binding = 2) readonly buffer LightGrid {
+    uint counts[];
+} lightGrid;
+
+layout(std430, set = 2, binding = 3) readonly buffer LightIndices {
+    uint indices[];
+} lightIndices;
+
+// Bindless, only the slots the registry has written may be read
+layout(set = 3, binding = 0) uniform sampler2D textures[];
+layout(set = 3, binding = 1) uniform sampler2DArray textureArrays[];
+
+uint getClusterIndex() {
+    float viewDepth = (ubo.view * vec4(fragPosWorld, 1.0)).z;
+    uvec3 cell = uvec3(
+            uvec2(gl_FragCoord.xy * clusters.tileScale),
+            uint(max(log(viewDepth) * clusters.sliceScale + clusters.sliceBias, 0.0)));
+    cell = min(cell, clusters.gridSize.xyz - 1u);
+    return cell.x + cell.y * clusters.gridSize.x + cell.z * clusters.gridSize.x * clusters.gridSize.y;
+}
 
 void main() {
     vec3 diffuseLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
@@ -35,11 +71,20 @@ void main() {
     vec3 cameraPosWorld = ubo.invView[3].xyz;
     vec3 viewDirection = normalize(cameraPosWorld - fragPosWorld);
 
-    for (int i = 0; i < ubo.numLights; i++) {
-        PointLight light = ubo.pointLights[i];
+    // Only the lights binned into this fragment's cluster can reach it
+    uint clusterIndex = getClusterIndex();
+    uint lightCount = min(lightGrid.counts[clusterIndex], MAX_LIGHTS_PER_CLUSTER);
+    uint firstLight = clusterIndex * MAX_LIGHTS_PER_CLUSTER;
+
+    for (uint i = 0; i < lightCount; i++) {
+        PointLight light = lightBuffer.lights[lightIndices.indices[firstLight + i]];
 
         vec3 directionToLight = light.position.xyz - fragPosWorld;
-        float attenuation = 1.0 / dot(directionToLight, directionToLight); //distance^2
+        float distanceSquared = dot(directionToLight, directionToLight);
+        // Fades the inverse square falloff to zero at the light's range, where the clustering cut it off
+        float rangeFactor = distanceSquared / (light.position.w * light.position.w);
+        float window = clamp(1.0 - rangeFactor * rangeFactor, 0.0, 1.0);
+        float attenuation = window * window / distanceSquared;
         directionToLight = normalize(directionToLight);
 
         float cosAngIncidence = max(dot(surfaceNormal, directionToLight), 0);
@@ -55,7 +100,13 @@ void main() {
         specularLight += intensity * blinnTerm;
     }
 
-    vec3 imageColor = texture(image, fragUV).rgb;
+    // Draws of one indirect call can use different textures, so the index isn't uniform
+    vec3 imageColor;
+    if (fragTextureArrayIndex != NO_TEXTURE_ARRAY) {
+        imageColor = texture(textureArrays[nonuniformEXT(fragTextureArrayIndex)], vec3(fragUV, float(fragTextureLayer))).rgb;
+    } else {
+        imageColor = texture(textures[nonuniformEXT(fragTextureIndex)], fragUV).rgb;
+    }
 
     outColor = vec4((diffuseLight * fragColor + specularLight * fragColor) * imageColor, 1.0);
 }
@@ -4,36 +4,46 @@ layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 color;
 layout(location = 2) in vec3 normal;
 layout(location = 3) in vec2 uv;
+layout(location = 4) in uint textureLayer;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
 layout(location = 3) out vec2 fragUV;
-
-struct PointLight {
-    vec4 position; // ignore w
-    vec4 color; // w is intensity
-};
+layout(location = 4) flat out uint fragTextureIndex;
+layout(location = 5) flat out uint fragTextureArrayIndex;
+layout(location = 6) flat out uint fragTextureLayer;
 
 layout(set = 0, binding = 0) uniform GlobalUBO {
     mat4 projection;
     mat4 view;
     mat4 invView;
     vec4 ambientLightColor; // w is intensity
-    PointLight pointLights[10];
-    int numLights;
 } ubo;
 
-layout(push_constant) uniform Push {
+struct ObjectData {
     mat4 modelMatrix;
     mat4 normalMatrix;
-} push;
+    vec4 boundsCenter;
+    vec4 boundsExtent;
+    uint textureIndex;
+    uint textureArrayIndex;
+};
+
+// gl_InstanceIndex includes the firstInstance of the indirect draw, which is the object's slot
+layout(std430, set = 1, binding = 0) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+} objectBuffer;
 
 void main() {
-    vec4 positionWorld = push.modelMatrix * vec4(position, 1.0);
-    gl_Position = ubo.projection * ubo.view * push.modelMatrix * vec4(position, 1.0);
-    fragNormalWorld = normalize(mat3 (push.normalMatrix) * normal);
+    ObjectData object = objectBuffer.objects[gl_InstanceIndex];
+    vec4 positionWorld = object.modelMatrix * vec4(position, 1.0);
+    gl_Position = ubo.projection * ubo.view * positionWorld;
+    fragNormalWorld = normalize(mat3 (object.normalMatrix) * normal);
     fragPosWorld = positionWorld.xyz;
     fragColor = color;
     fragUV = uv;
+    fragTextureIndex = object.textureIndex;
+    fragTextureArrayIndex = object.textureArrayIndex;
+    fragTextureLayer = textureLayer;
 }
@@ -0,0 +1,83 @@
+#version 450
+
+// EngineModel::PackedVoxelFace, one record per quad with no vertex input. Drawn through the face heap's shared
+// index pattern, four corners per face, so gl_VertexIndex / 4 is the face and gl_VertexIndex % 4 the corner.
+// Drawn with simple_shader.frag
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec2 fragUV;
+layout(location = 4) flat out uint fragTextureIndex;
+layout(location = 5) flat out uint fragTextureArrayIndex;
+layout(location = 6) flat out uint fragTextureLayer;
+
+layout(set = 0, binding = 0) uniform GlobalUBO {
+    mat4 projection;
+    mat4 view;
+    mat4 invView;
+    vec4 ambientLightColor; // w is intensity
+} ubo;
+
+struct ObjectData {
+    mat4 modelMatrix;
+    mat4 normalMatrix;
+    vec4 boundsCenter;
+    vec4 boundsExtent;
+    uint textureIndex;
+    uint textureArrayIndex;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+} objectBuffer;
+
+// The whole face heap, the draw's vertexOffset already points gl_VertexIndex at this model's faces
+layout(std430, set = 1, binding = 1) readonly buffer FaceBuffer {
+    uvec2 faces[];
+} faceBuffer;
+
+// ChunkFace order
+const vec3 FACE_NORMALS[6] = vec3[](
+    vec3(-1.0, 0.0, 0.0), vec3(1.0, 0.0, 0.0),
+    vec3(0.0, -1.0, 0.0), vec3(0.0, 1.0, 0.0),
+    vec3(0.0, 0.0, -1.0), vec3(0.0, 0.0, 1.0));
+
+// Corners of the quad in units of its width and height, in the order the index pattern winds them
+const vec2 CORNERS[4] = vec2[](vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0));
+
+void main() {
+    uvec2 packedFace = faceBuffer.faces[gl_VertexIndex >> 2];
+    uint face = (packedFace.x >> 15) & 7u;
+    uint axis = face / 2u;
+    bool positive = (face & 1u) == 1u;
+    vec2 size = vec2(float(((packedFace.x >> 18) & 31u) + 1u), float(((packedFace.x >> 23) & 31u) + 1u));
+
+    // The pattern winds counter clockwise looking down the positive axis, faces looking the other way walk the
+    // corners backwards, the same flip the indexed mesher makes in its index order
+    uint corner = uint(gl_VertexIndex) & 3u;
+    if (!positive)
+        corner = (4u - corner) & 3u;
+
+    vec3 position = vec3(packedFace.x & 31u, (packedFace.x >> 5) & 31u, (packedFace.x >> 10) & 31u);
+    position[axis] += positive ? 1.0 : 0.0;
+    vec2 offset = CORNERS[corner] * size;
+    position[(axis + 1u) % 3u] += offset.x;
+    position[(axis + 2u) % 3u] += offset.y;
+
+    uint tint = packedFace.y >> 16;
+    vec3 color = vec3(float((tint >> 11) & 31u) / 31.0, float((tint >> 5) & 63u) / 63.0, float(tint & 31u) / 31.0);
+
+    ObjectData object = objectBuffer.objects[gl_InstanceIndex];
+    vec4 positionWorld = object.modelMatrix * vec4(position, 1.0);
+    gl_Position = ubo.projection * ubo.view * positionWorld;
+    fragNormalWorld = normalize(mat3(object.normalMatrix) * FACE_NORMALS[face]);
+    fragPosWorld = positionWorld.xyz;
+    // No ambient occlusion, a face record has nothing per corner
+    fragColor = color;
+
+    // Block corners land on whole numbers so the texture repeats once per block across the merged quad
+    fragUV = vec2(position[(axis + 1u) % 3u], position[(axis + 2u) % 3u]);
+    fragTextureIndex = object.textureIndex;
+    fragTextureArrayIndex = object.textureArrayIndex;
+    fragTextureLayer = packedFace.y & 0xFFFFu;
+}
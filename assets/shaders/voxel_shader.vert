@@ -0,0 +1,64 @@
+#version 450
+
+// EngineModel::PackedVoxelVertex, drawn with simple_shader.frag
+layout(location = 0) in uint packedPosition;
+layout(location = 1) in uint packedAttributes;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec2 fragUV;
+layout(location = 4) flat out uint fragTextureIndex;
+layout(location = 5) flat out uint fragTextureArrayIndex;
+layout(location = 6) flat out uint fragTextureLayer;
+
+layout(set = 0, binding = 0) uniform GlobalUBO {
+    mat4 projection;
+    mat4 view;
+    mat4 invView;
+    vec4 ambientLightColor; // w is intensity
+} ubo;
+
+struct ObjectData {
+    mat4 modelMatrix;
+    mat4 normalMatrix;
+    vec4 boundsCenter;
+    vec4 boundsExtent;
+    uint textureIndex;
+    uint textureArrayIndex;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+} objectBuffer;
+
+// ChunkFace order
+const vec3 FACE_NORMALS[6] = vec3[](
+    vec3(-1.0, 0.0, 0.0), vec3(1.0, 0.0, 0.0),
+    vec3(0.0, -1.0, 0.0), vec3(0.0, 1.0, 0.0),
+    vec3(0.0, 0.0, -1.0), vec3(0.0, 0.0, 1.0));
+
+// Ambient occlusion level 0 is the darkest corner, 3 is unoccluded
+const float AMBIENT_OCCLUSION[4] = float[](0.4, 0.6, 0.8, 1.0);
+
+void main() {
+    vec3 position = vec3(packedPosition & 63u, (packedPosition >> 6) & 63u, (packedPosition >> 12) & 63u);
+    uint face = (packedPosition >> 18) & 7u;
+    uint ambientOcclusion = (packedPosition >> 21) & 3u;
+    uint tint = packedAttributes >> 16;
+    vec3 color = vec3(float((tint >> 11) & 31u) / 31.0, float((tint >> 5) & 63u) / 63.0, float(tint & 31u) / 31.0);
+
+    ObjectData object = objectBuffer.objects[gl_InstanceIndex];
+    vec4 positionWorld = object.modelMatrix * vec4(position, 1.0);
+    gl_Position = ubo.projection * ubo.view * positionWorld;
+    fragNormalWorld = normalize(mat3(object.normalMatrix) * FACE_NORMALS[face]);
+    fragPosWorld = positionWorld.xyz;
+    fragColor = color * AMBIENT_OCCLUSION[ambientOcclusion];
+
+    // The two axes the face spans, block corners land on whole numbers so the texture repeats once per block
+    uint axis = face / 2u;
+    fragUV = vec2(position[(axis + 1u) % 3u], position[(axis + 2u) % 3u]);
+    fragTextureIndex = object.textureIndex;
+    fragTextureArrayIndex = object.textureArrayIndex;
+    fragTextureLayer = packedAttributes & 0xFFFFu;
+}
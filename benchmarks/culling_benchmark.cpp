@@ -0,0 +1,113 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+// CPU only benchmark for the SIMD frustum culler, every path the CPU supports is timed on the same random boxes.
+//
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include "../src/engine_camera.hpp"
+#include "../src/math/math_frustum.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace engine;
+using namespace engine::math;
+
+namespace {
+    using Clock = std::chrono::high_resolution_clock;
+
+    constexpr uint32_t BENCHMARK_SEED = 1337;
+    constexpr float WORLD_HALF_SIZE = 500.0f;
+
+    double secondsSince (Clock::time_point start) {
+        return std::chrono::duration<double, std::chrono::seconds::period>(Clock::now() - start).count();
+    }
+
+    // Chunk sized and smaller boxes scattered around the camera, roughly what a loaded world looks like to the culler
+    BoundsArray randomBounds (size_t count) {
+        std::mt19937 random{BENCHMARK_SEED};
+        std::uniform_real_distribution<float> position{-WORLD_HALF_SIZE, WORLD_HALF_SIZE};
+        std::uniform_real_distribution<float> halfSize{0.5f, 16.0f};
+
+        BoundsArray bounds{};
+        bounds.reserve (count);
+        for (size_t i = 0; i < count; i++) {
+            glm::vec3 center{position (random), position (random) * 0.25f, position (random)};
+            glm::vec3 extent{halfSize (random), halfSize (random), halfSize (random)};
+            bounds.add (center - extent, center + extent);
+        }
+        return bounds;
+    }
+
+    // Best of several runs, the first touches the pages and warms the caches
+    double benchmarkPath (CullPath path, const BoundsArray &bounds, const std::array<glm::vec4, 6> &planes, std::vector<uint32_t> &visible, size_t &visibleCount, int iterations) {
+        double best = 0.0;
+        for (int i = 0; i < iterations; i++) {
+            auto start = Clock::now();
+            visibleCount = FrustumCuller::cull (bounds, planes, visible.data(), path);
+            double elapsed = secondsSince (start);
+            if (i == 0 || elapsed < best)
+                best = elapsed;
+        }
+        return best;
+    }
+}
+
+int main (int argc, char *argv[]) {
+    auto consoleSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+    auto logger = std::make_shared<spdlog::logger>("main", consoleSink);
+    logger->set_pattern ("%v");
+    spdlog::register_logger (logger);
+    spdlog::set_default_logger (logger);
+
+    size_t boxCount = argc > 1 ? static_cast<size_t>(std::atoll (argv[1])) : 1000000;
+    int iterations = argc > 2 ? std::atoi (argv[2]) : 20;
+
+    EngineCamera camera{};
+    camera.setPerspectiveProjection (glm::radians (50.0f), 16.0f / 9.0f, 0.1f, 1000.0f);
+    camera.setViewYXZ ({0.0f, 0.0f, 0.0f}, {0.0f, 0.3f, 0.0f});
+    auto planes = camera.getFrustumPlanes();
+
+    BoundsArray bounds = randomBounds (boxCount);
+    std::vector<uint32_t> reference (bounds.size());
+    std::vector<uint32_t> visible (bounds.size());
+
+    auto log = spdlog::get ("main");
+    log->info ("Frustum culling {} boxes, best of {} runs, widest supported path is {}",
+               bounds.size(),
+               iterations,
+               FrustumCuller::pathName (FrustumCuller::bestPath()));
+
+    size_t referenceCount = 0;
+    double scalarTime = benchmarkPath (CullPath::Scalar, bounds, planes, reference, referenceCount, iterations);
+
+    for (CullPath path : {CullPath::Scalar, CullPath::SSE, CullPath::AVX2}) {
+        if (path > FrustumCuller::bestPath())
+            break;
+
+        size_t visibleCount = 0;
+        double elapsed = benchmarkPath (path, bounds, planes, visible, visibleCount, iterations);
+        bool matches = visibleCount == referenceCount && std::equal (visible.begin(), visible.begin() + visibleCount, reference.begin());
+
+        log->info ("  {:>6}: {:>8.3f} ms ({:.3f} ms per 100k), {:.0f}M boxes/s, {:.2f}x scalar, {} visible{}",
+                   FrustumCuller::pathName (path),
+                   elapsed * 1000.0,
+                   elapsed * 1000.0 * 100000.0 / bounds.size(),
+                   bounds.size() / elapsed / 1000000.0,
+                   scalarTime / elapsed,
+                   visibleCount,
+                   matches ? "" : " MISMATCH");
+        if (!matches)
+            return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
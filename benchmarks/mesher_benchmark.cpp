@@ -0,0 +1,258 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+// CPU only benchmark for terrain generation and greedy meshing, no window or vulkan device is created.
+//
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include "../src/voxel/voxel_chunk.hpp"
+#include "../src/voxel/voxel_world.hpp"
+#include "../src/voxel/voxel_generator.hpp"
+#include "../src/voxel/voxel_mesher.hpp"
+#include "../src/voxel/voxel_chunk_builder.hpp"
+#include "../src/engine_job_system.hpp"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+using namespace engine;
+using namespace engine::voxel;
+
+namespace {
+    using Clock = std::chrono::high_resolution_clock;
+
+    constexpr int BENCHMARK_SEED = 1337;
+
+    double secondsSince (Clock::time_point start) {
+        return std::chrono::duration<double, std::chrono::seconds::period>(Clock::now() - start).count();
+    }
+
+    // One quad per exposed block face, what a mesher without any merging would produce
+    uint64_t countVisibleFaces (const VoxelWorld &world, const glm::ivec3 &chunkCoord) {
+        glm::ivec3 origin = VoxelWorld::chunkToWorld (chunkCoord);
+        auto chunk = world.getChunk (chunkCoord);
+        if (chunk == nullptr || chunk->isEmpty())
+            return 0;
+
+        uint64_t faces = 0;
+        for (int y = 0; y < VoxelChunk::SIZE; y++) {
+            for (int z = 0; z < VoxelChunk::SIZE; z++) {
+                for (int x = 0; x < VoxelChunk::SIZE; x++) {
+                    if (chunk->get (x, y, z) == BLOCK_AIR)
+                        continue;
+                    glm::ivec3 position = origin + glm::ivec3{x, y, z};
+                    for (int face = 0; face < 6; face++) {
+                        if (world.getBlock (position + ChunkNeighbourhood::faceOffset (static_cast<ChunkFace>(face))) == BLOCK_AIR)
+                            faces++;
+                    }
+                }
+            }
+        }
+        return faces;
+    }
+
+    void generateWorld (VoxelWorld &world, const VoxelTerrainGenerator &generator, int viewRadius, int verticalChunks) {
+        auto log = spdlog::get ("main");
+        auto start = Clock::now();
+
+        for (int cx = -viewRadius; cx <= viewRadius; cx++) {
+            for (int cz = -viewRadius; cz <= viewRadius; cz++) {
+                for (int cy = -verticalChunks / 2; cy < verticalChunks / 2; cy++) {
+                    glm::ivec3 coord{cx, cy, cz};
+                    generator.generateChunk (coord, *world.getOrCreateChunk (coord));
+                }
+            }
+        }
+
+        double elapsed = secondsSince (start);
+        log->info ("Generated {} chunks (seed {}) in {:.2f}s, {:.0f} chunks/s, {:.2f} MB",
+                   world.chunkCount(),
+                   generator.seed,
+                   elapsed,
+                   world.chunkCount() / elapsed,
+                   world.memoryUsage() / (1024.0 * 1024.0));
+    }
+
+    void benchmarkMeshing (const VoxelWorld &world, int iterations) {
+        auto log = spdlog::get ("main");
+
+        std::vector<ChunkNeighbourhood> neighbourhoods{};
+        for (const auto &[coord, chunk] : world.getChunks()) {
+            neighbourhoods.push_back (ChunkNeighbourhood::gather (world, coord));
+        }
+
+        EngineModel::Builder builder{};
+        uint64_t meshedChunks = 0;
+        uint64_t totalVertices = 0;
+        uint64_t totalTriangles = 0;
+        uint64_t totalIndexBytes = 0;
+
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; i++) {
+            meshedChunks = 0;
+            totalVertices = 0;
+            totalTriangles = 0;
+            totalIndexBytes = 0;
+            for (const auto &neighbourhood : neighbourhoods) {
+                // Indexed vertices so the counts compare with the naive mesh, every quad is also one packed face
+                VoxelMesher::meshChunk (neighbourhood, builder, EngineModel::VertexFormat::PackedVoxel);
+                if (builder.indices.empty())
+                    continue;
+                meshedChunks++;
+                totalVertices += builder.vertexCount();
+                totalTriangles += builder.triangleCount();
+                // Same width the model would pick on upload
+                totalIndexBytes += builder.indices.size() * (builder.indexType() == VK_INDEX_TYPE_UINT16 ? sizeof (uint16_t) : sizeof (uint32_t));
+            }
+        }
+        double elapsed = secondsSince (start);
+
+        uint64_t naiveFaces = 0;
+        for (const auto &[coord, chunk] : world.getChunks()) {
+            naiveFaces += countVisibleFaces (world, coord);
+        }
+        uint64_t naiveTriangles = naiveFaces * 2;
+        uint64_t naiveVertices = naiveFaces * 4;
+
+        double meshesPerSecond = static_cast<double>(neighbourhoods.size()) * iterations / elapsed;
+        log->info ("Greedy meshing: {:.0f} meshes/s ({:.3f} ms/chunk) over {} chunks, {} with visible faces",
+                   meshesPerSecond,
+                   1000.0 / meshesPerSecond,
+                   neighbourhoods.size(),
+                   meshedChunks);
+        if (meshedChunks == 0)
+            return;
+
+        log->info ("  greedy: {:>10.1f} triangles/chunk {:>10.1f} vertices/chunk",
+                   static_cast<double>(totalTriangles) / meshedChunks,
+                   static_cast<double>(totalVertices) / meshedChunks);
+        log->info ("  naive:  {:>10.1f} triangles/chunk {:>10.1f} vertices/chunk",
+                   static_cast<double>(naiveTriangles) / meshedChunks,
+                   static_cast<double>(naiveVertices) / meshedChunks);
+        log->info ("  reduction: {:.1f}x fewer vertices", static_cast<double>(naiveVertices) / totalVertices);
+        log->info ("  vertex memory: {:.1f} KiB/chunk packed, {:.1f} KiB/chunk as EngineModel::Vertex",
+                   static_cast<double>(totalVertices * sizeof (EngineModel::PackedVoxelVertex)) / meshedChunks / 1024.0,
+                   static_cast<double>(totalVertices * sizeof (EngineModel::Vertex)) / meshedChunks / 1024.0);
+        uint64_t totalFaces = totalVertices / 4;
+        log->info ("  mesh memory: {:.1f} KiB/chunk as packed faces, {:.1f} KiB/chunk as indexed packed vertices",
+                   static_cast<double>(totalFaces * sizeof (EngineModel::PackedVoxelFace)) / meshedChunks / 1024.0,
+                   static_cast<double>(totalVertices * sizeof (EngineModel::PackedVoxelVertex) + totalIndexBytes) / meshedChunks / 1024.0);
+    }
+
+    // A lone 3D checkerboard chunk, nothing can merge so every solid block shows all six faces. Far more faces than
+    // one face draw holds, the mesher has to hand back indexed vertices instead
+    bool benchmarkCheckerboardChunk (int iterations) {
+        auto log = spdlog::get ("main");
+
+        VoxelWorld world{};
+        auto chunk = world.getOrCreateChunk ({0, 0, 0});
+        for (int y = 0; y < VoxelChunk::SIZE; y++) {
+            for (int z = 0; z < VoxelChunk::SIZE; z++) {
+                for (int x = 0; x < VoxelChunk::SIZE; x++) {
+                    if ((x + y + z) % 2 == 0)
+                        chunk->set (x, y, z, BLOCK_STONE);
+                }
+            }
+        }
+        ChunkNeighbourhood neighbourhood = ChunkNeighbourhood::gather (world, {0, 0, 0});
+
+        EngineModel::Builder builder{};
+        auto start = Clock::now();
+        for (int i = 0; i < iterations; i++) {
+            VoxelMesher::meshChunk (neighbourhood, builder);
+        }
+        double elapsed = secondsSince (start);
+
+        uint64_t expectedQuads = countVisibleFaces (world, {0, 0, 0});
+        uint64_t quads = builder.triangleCount() / 2;
+        bool fellBack = builder.vertexFormat == EngineModel::VertexFormat::PackedVoxel;
+        log->info ("Checkerboard chunk: {:.3f} ms/chunk, {} quads as {} (face draw limit {})",
+                   1000.0 * elapsed / iterations,
+                   quads,
+                   fellBack ? "packed vertices" : "packed faces",
+                   EngineMeshHeap::MAX_QUADS_PER_DRAW);
+
+        if (quads != expectedQuads || (expectedQuads > EngineMeshHeap::MAX_QUADS_PER_DRAW && !fellBack)) {
+            log->error ("  checkerboard mesh is wrong, expected {} quads as {}", expectedQuads,
+                        expectedQuads > EngineMeshHeap::MAX_QUADS_PER_DRAW ? "packed vertices" : "packed faces");
+            return false;
+        }
+        return true;
+    }
+
+    // Generation plus meshing through the job system, the main thread only drains finished meshes like the renderer does
+    double benchmarkJobSystem (const VoxelTerrainGenerator &generator, uint32_t workerCount, int viewRadius, int verticalChunks) {
+        VoxelWorld world{};
+        EngineJobSystem jobSystem{workerCount};
+        VoxelChunkBuilder chunkBuilder{jobSystem, world, generator};
+
+        auto start = Clock::now();
+        int requested = 0;
+        for (int cx = -viewRadius; cx <= viewRadius; cx++) {
+            for (int cz = -viewRadius; cz <= viewRadius; cz++) {
+                for (int cy = -verticalChunks / 2; cy < verticalChunks / 2; cy++) {
+                    chunkBuilder.requestMesh ({cx, cy, cz});
+                    requested++;
+                }
+            }
+        }
+
+        ChunkMesh mesh{};
+        uint64_t triangles = 0;
+        for (int received = 0; received < requested;) {
+            if (chunkBuilder.popFinishedMesh (mesh)) {
+                triangles += mesh.builder.triangleCount();
+                received++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+        double elapsed = secondsSince (start);
+
+        spdlog::get ("main")->info ("  {:>2} workers: {} meshed chunks ({} generated) in {:.2f}s, {:.0f} chunks/s, {} triangles",
+                                    workerCount,
+                                    requested,
+                                    world.chunkCount(),
+                                    elapsed,
+                                    requested / elapsed,
+                                    triangles);
+        return requested / elapsed;
+    }
+}
+
+int main (int argc, char *argv[]) {
+    auto consoleSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+    auto logger = std::make_shared<spdlog::logger>("main", consoleSink);
+    logger->set_pattern ("%v");
+    spdlog::register_logger (logger);
+    spdlog::set_default_logger (logger);
+
+    int viewRadius = argc > 1 ? std::atoi (argv[1]) : 8;
+    int iterations = argc > 2 ? std::atoi (argv[2]) : 5;
+
+    VoxelTerrainGenerator generator{BENCHMARK_SEED};
+    VoxelWorld world{};
+    generateWorld (world, generator, viewRadius, 4);
+    benchmarkMeshing (world, iterations);
+    if (!benchmarkCheckerboardChunk (iterations))
+        return EXIT_FAILURE;
+
+    spdlog::get ("main")->info ("Job system scaling, generate + mesh:");
+    double singleWorker = 0.0;
+    for (uint32_t workers = 1; workers <= std::max (std::thread::hardware_concurrency(), 1u); workers *= 2) {
+        double chunksPerSecond = benchmarkJobSystem (generator, workers, viewRadius, 4);
+        if (workers == 1)
+            singleWorker = chunksPerSecond;
+        else
+            spdlog::get ("main")->info ("     speedup {:.2f}x", chunksPerSecond / singleWorker);
+    }
+
+    return EXIT_SUCCESS;
+}
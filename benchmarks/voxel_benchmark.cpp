@@ -0,0 +1,157 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+// CPU only benchmark for the voxel storage, no window or vulkan device is created.
+//
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include "../src/voxel/voxel_chunk.hpp"
+#include "../src/voxel/voxel_world.hpp"
+
+// std
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+using namespace engine::voxel;
+
+namespace {
+    using Clock = std::chrono::high_resolution_clock;
+
+    struct XorShift {
+        uint64_t state = 0x9E3779B97F4A7C15ull;
+        uint64_t next () {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state;
+        }
+    };
+
+    double secondsSince (Clock::time_point start) {
+        return std::chrono::duration<double, std::chrono::seconds::period>(Clock::now() - start).count();
+    }
+
+    int terrainHeight (int x, int z) {
+        return 40 + static_cast<int>(12.0 * std::sin (x * 0.05) + 8.0 * std::cos (z * 0.07));
+    }
+
+    // Heightmap terrain so memory numbers reflect the mix of uniform and surface chunks a real world has
+    void generateTerrainChunk (VoxelChunk &chunk, const glm::ivec3 &chunkCoord) {
+        glm::ivec3 origin = VoxelWorld::chunkToWorld (chunkCoord);
+        for (int z = 0; z < VoxelChunk::SIZE; z++) {
+            for (int x = 0; x < VoxelChunk::SIZE; x++) {
+                int height = terrainHeight (origin.x + x, origin.z + z);
+                for (int y = 0; y < VoxelChunk::SIZE; y++) {
+                    int worldY = origin.y + y;
+                    if (worldY > height)
+                        continue;
+                    BlockId block = worldY == height ? BLOCK_GRASS : (worldY > height - 4 ? BLOCK_DIRT : BLOCK_STONE);
+                    chunk.set (x, y, z, block);
+                }
+            }
+        }
+        chunk.compact();
+    }
+
+    void benchmarkChunkMemory () {
+        auto log = spdlog::get ("main");
+
+        VoxelChunk empty{};
+        VoxelChunk solid{BLOCK_STONE};
+        VoxelChunk surface{};
+        generateTerrainChunk (surface, {0, 1, 0});
+
+        XorShift random{};
+        VoxelChunk noisy{};
+        for (int i = 0; i < VoxelChunk::VOLUME; i++) {
+            noisy.set (i % VoxelChunk::SIZE, (i / VoxelChunk::SIZE) % VoxelChunk::SIZE, i / (VoxelChunk::SIZE * VoxelChunk::SIZE),
+                       static_cast<BlockId>(random.next() % 16));
+        }
+
+        size_t rawSize = VoxelChunk::VOLUME * sizeof (BlockId);
+        log->info ("Chunk {}^3, uncompressed size {} bytes", VoxelChunk::SIZE, rawSize);
+        log->info ("  empty chunk:          {:>8} bytes ({} bits/block)", empty.memoryUsage(), empty.getBitsPerIndex());
+        log->info ("  solid chunk:          {:>8} bytes ({} bits/block)", solid.memoryUsage(), solid.getBitsPerIndex());
+        log->info ("  terrain surface:      {:>8} bytes ({} bits/block)", surface.memoryUsage(), surface.getBitsPerIndex());
+        log->info ("  16 random block types:{:>8} bytes ({} bits/block)", noisy.memoryUsage(), noisy.getBitsPerIndex());
+    }
+
+    void benchmarkWorldMemory (int viewRadius, int verticalChunks) {
+        auto log = spdlog::get ("main");
+        auto start = Clock::now();
+
+        VoxelWorld world{};
+        for (int cx = -viewRadius; cx <= viewRadius; cx++) {
+            for (int cz = -viewRadius; cz <= viewRadius; cz++) {
+                for (int cy = 0; cy < verticalChunks; cy++) {
+                    glm::ivec3 coord{cx, cy, cz};
+                    auto chunk = world.getOrCreateChunk (coord);
+                    generateTerrainChunk (*chunk, coord);
+                }
+            }
+        }
+
+        double elapsed = secondsSince (start);
+        size_t rawSize = world.chunkCount() * VoxelChunk::VOLUME * sizeof (BlockId);
+        log->info ("World radius {} x {} chunks high: {} chunks generated in {:.2f}s", viewRadius, verticalChunks, world.chunkCount(), elapsed);
+        log->info ("  palette storage: {:.2f} MB, uncompressed: {:.2f} MB, {:.0f} bytes/chunk",
+                   world.memoryUsage() / (1024.0 * 1024.0),
+                   rawSize / (1024.0 * 1024.0),
+                   static_cast<double>(world.memoryUsage()) / world.chunkCount());
+    }
+
+    void benchmarkRandomAccess (int paletteSize, int operations) {
+        auto log = spdlog::get ("main");
+
+        VoxelChunk chunk{};
+        XorShift random{};
+        for (int i = 0; i < VoxelChunk::VOLUME; i++) {
+            chunk.set (i % VoxelChunk::SIZE, (i / VoxelChunk::SIZE) % VoxelChunk::SIZE, i / (VoxelChunk::SIZE * VoxelChunk::SIZE),
+                       static_cast<BlockId>(random.next() % paletteSize));
+        }
+
+        auto start = Clock::now();
+        uint64_t checksum = 0;
+        for (int i = 0; i < operations; i++) {
+            uint64_t r = random.next();
+            checksum += chunk.get (r & 31, (r >> 5) & 31, (r >> 10) & 31);
+        }
+        double getTime = secondsSince (start);
+
+        start = Clock::now();
+        for (int i = 0; i < operations; i++) {
+            uint64_t r = random.next();
+            chunk.set (r & 31, (r >> 5) & 31, (r >> 10) & 31, static_cast<BlockId>((r >> 15) % paletteSize));
+        }
+        double setTime = secondsSince (start);
+
+        log->info ("Random access, {} block types ({} bits/block): get {:.1f} M/s, set {:.1f} M/s (checksum {})",
+                   paletteSize,
+                   chunk.getBitsPerIndex(),
+                   operations / getTime / 1e6,
+                   operations / setTime / 1e6,
+                   checksum);
+    }
+}
+
+int main (int argc, char *argv[]) {
+    auto consoleSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+    auto logger = std::make_shared<spdlog::logger>("main", consoleSink);
+    logger->set_pattern ("%v");
+    spdlog::register_logger (logger);
+    spdlog::set_default_logger (logger);
+
+    int viewRadius = argc > 1 ? std::atoi (argv[1]) : 16;
+
+    benchmarkChunkMemory();
+    benchmarkWorldMemory (viewRadius, 8);
+    for (int paletteSize : {2, 4, 16, 256}) {
+        benchmarkRandomAccess (paletteSize, 10'000'000);
+    }
+
+    return EXIT_SUCCESS;
+}
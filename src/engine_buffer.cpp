@@ -8,6 +8,7 @@
 #include "engine_buffer.hpp"
 
 // std
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
@@ -34,18 +35,34 @@ namespace engine {
             : engineDevice{device}, instanceSize{instanceSize}, instanceCount{instanceCount}, usageFlags{usageFlags}, memoryPropertyFlags{memoryPropertyFlags} {
         alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
         bufferSize = alignmentSize * instanceCount;
-        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation);
+    }
+
+    EngineBuffer::EngineBuffer(EngineBufferPool &pool, VkDeviceSize bufferOffset, VkDeviceSize instanceSize, uint32_t instanceCount,
+                               VkDeviceSize alignmentSize)
+            : engineDevice{pool.engineDevice}, pool{&pool}, buffer{pool.buffer}, bufferOffset{bufferOffset}, instanceSize{instanceSize},
+              instanceCount{instanceCount}, alignmentSize{alignmentSize}, usageFlags{pool.usageFlags}, memoryPropertyFlags{pool.memoryPropertyFlags} {
+        bufferSize = alignmentSize * instanceCount;
     }
 
     EngineBuffer::~EngineBuffer() {
         unmap();
-        vkDestroyBuffer(engineDevice.device(), buffer, nullptr);
-        vkFreeMemory(engineDevice.device(), memory, nullptr);
+        if (pool != nullptr) {
+            pool->release(bufferOffset, bufferSize);
+        } else {
+            engineDevice.destroyBuffer(buffer, allocation);
+        }
+    }
+
+    const EngineAllocation &EngineBuffer::getAllocation() const {
+        return pool != nullptr ? pool->allocation : allocation;
     }
 
 /**
  * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
  *
+ * @note Host visible memory stays mapped by the allocator, this only hands out a pointer into it
+ *
  * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
  * buffer range.
  * @param offset (Optional) Byte offset from beginning
@@ -53,20 +70,22 @@ namespace engine {
  * @return VkResult of the buffer mapping call
  */
     VkResult EngineBuffer::map(VkDeviceSize size, VkDeviceSize offset) {
-        assert(buffer && memory && "Called map on buffer before create");
-        return vkMapMemory(engineDevice.device(), memory, offset, size, 0, &mapped);
+        assert(buffer && "Called map on buffer before create");
+        const EngineAllocation &memory = getAllocation();
+        if (memory.mapped == nullptr) {
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+        mapped = static_cast<char *>(memory.mapped) + bufferOffset + offset;
+        return VK_SUCCESS;
     }
 
 /**
  * Unmap a mapped memory range
  *
- * @note Does not return a result as vkUnmapMemory can't fail
+ * @note The underlying memory block stays mapped until the allocator frees it
  */
     void EngineBuffer::unmap() {
-        if (mapped) {
-            vkUnmapMemory(engineDevice.device(), memory);
-            mapped = nullptr;
-        }
+        mapped = nullptr;
     }
 
 /**
@@ -102,12 +121,10 @@ namespace engine {
  * @return VkResult of the flush call
  */
     VkResult EngineBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkFlushMappedMemoryRanges(engineDevice.device(), 1, &mappedRange);
+        if (size == VK_WHOLE_SIZE) {
+            size = bufferSize - offset;
+        }
+        return engineDevice.getAllocator().flush(getAllocation(), size, bufferOffset + offset);
     }
 
 /**
@@ -122,12 +139,10 @@ namespace engine {
  * @return VkResult of the invalidate call
  */
     VkResult EngineBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkInvalidateMappedMemoryRanges(engineDevice.device(), 1, &mappedRange);
+        if (size == VK_WHOLE_SIZE) {
+            size = bufferSize - offset;
+        }
+        return engineDevice.getAllocator().invalidate(getAllocation(), size, bufferOffset + offset);
     }
 
 /**
@@ -139,10 +154,11 @@ namespace engine {
  * @return VkDescriptorBufferInfo of specified offset and range
  */
     VkDescriptorBufferInfo EngineBuffer::descriptorInfo(VkDeviceSize size, VkDeviceSize offset) {
+        // VK_WHOLE_SIZE would run on to the end of a shared pool buffer
         return VkDescriptorBufferInfo{
                 buffer,
-                offset,
-                size,
+                bufferOffset + offset,
+                size == VK_WHOLE_SIZE ? bufferSize - offset : size,
         };
     }
 
@@ -189,4 +205,77 @@ namespace engine {
         return invalidate(alignmentSize, index * alignmentSize);
     }
 
+    EngineBufferPool::EngineBufferPool(EngineDevice &device, VkDeviceSize size, VkBufferUsageFlags usageFlags,
+                                       VkMemoryPropertyFlags memoryPropertyFlags)
+            : engineDevice{device}, usageFlags{usageFlags}, memoryPropertyFlags{memoryPropertyFlags}, ranges{size} {
+        // Index buffer offsets have to be a multiple of the index size, 4 covers both index types
+        offsetAlignment = 4;
+        if (usageFlags & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+            offsetAlignment = std::max(offsetAlignment, device.properties.limits.minUniformBufferOffsetAlignment);
+        if (usageFlags & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+            offsetAlignment = std::max(offsetAlignment, device.properties.limits.minStorageBufferOffsetAlignment);
+
+        device.createBuffer(size, usageFlags, memoryPropertyFlags, buffer, allocation);
+    }
+
+    EngineBufferPool::~EngineBufferPool() {
+        assert(ranges.isEmpty() && "Buffer pool destroyed while buffers are still allocated from it");
+        engineDevice.destroyBuffer(buffer, allocation);
+    }
+
+/**
+ * Sub allocate a buffer of instanceCount instances from the pool
+ *
+ * @param instanceSize The size of an instance
+ * @param instanceCount Number of instances
+ * @param minOffsetAlignment (Optional) Alignment of both the instances and the start of the buffer
+ *
+ * @return The buffer, or nullptr if the pool is too full or fragmented
+ */
+    std::unique_ptr<EngineBuffer> EngineBufferPool::allocate(VkDeviceSize instanceSize, uint32_t instanceCount, VkDeviceSize minOffsetAlignment) {
+        VkDeviceSize alignmentSize = EngineBuffer::getAlignment(instanceSize, minOffsetAlignment);
+
+        VkDeviceSize offset;
+        {
+            std::lock_guard<std::mutex> lock{mutex};
+            offset = ranges.allocate(alignmentSize * instanceCount, std::max(minOffsetAlignment, offsetAlignment));
+        }
+        if (offset == EngineRangeAllocator::INVALID_OFFSET) {
+            return nullptr;
+        }
+        return std::unique_ptr<EngineBuffer>(new EngineBuffer(*this, offset, instanceSize, instanceCount, alignmentSize));
+    }
+
+/**
+ * Sub allocate a buffer from the pool, or create a standalone one when the pool can't fit it
+ *
+ * @param instanceSize The size of an instance
+ * @param instanceCount Number of instances
+ * @param minOffsetAlignment (Optional) Alignment of both the instances and the start of the buffer
+ *
+ * @return The buffer, pooled or not
+ */
+    std::unique_ptr<EngineBuffer> EngineBufferPool::allocateOrCreate(VkDeviceSize instanceSize, uint32_t instanceCount, VkDeviceSize minOffsetAlignment) {
+        auto pooled = allocate(instanceSize, instanceCount, minOffsetAlignment);
+        if (pooled != nullptr) {
+            return pooled;
+        }
+        return std::make_unique<EngineBuffer>(engineDevice, instanceSize, instanceCount, usageFlags, memoryPropertyFlags, minOffsetAlignment);
+    }
+
+    VkDeviceSize EngineBufferPool::getFreeBytes() const {
+        std::lock_guard<std::mutex> lock{mutex};
+        return ranges.getFreeBytes();
+    }
+
+    VkDeviceSize EngineBufferPool::getLargestFreeRange() const {
+        std::lock_guard<std::mutex> lock{mutex};
+        return ranges.getLargestFreeRange();
+    }
+
+    void EngineBufferPool::release(VkDeviceSize offset, VkDeviceSize size) {
+        std::lock_guard<std::mutex> lock{mutex};
+        ranges.free(offset, size);
+    }
+
 }  // namespace engine
@@ -7,8 +7,14 @@
 
 #include "engine_device.hpp"
 
+// std
+#include <memory>
+#include <mutex>
+
 namespace engine {
 
+    class EngineBufferPool;
+
     class EngineBuffer {
     public:
         EngineBuffer(
@@ -37,6 +43,8 @@ namespace engine {
         VkResult invalidateIndex(int index);
 
         VkBuffer getBuffer() const { return buffer; }
+        // Where this buffer starts inside getBuffer(), non zero for buffers handed out by an EngineBufferPool
+        VkDeviceSize getBufferOffset() const { return bufferOffset; }
         void* getMappedMemory() const { return mapped; }
         uint32_t getInstanceCount() const { return instanceCount; }
         VkDeviceSize getInstanceSize() const { return instanceSize; }
@@ -46,12 +54,25 @@ namespace engine {
         VkDeviceSize getBufferSize() const { return bufferSize; }
 
     private:
+        friend class EngineBufferPool;
+
+        // A view of bufferSize bytes at bufferOffset inside a pool's buffer
+        EngineBuffer(
+                EngineBufferPool& pool,
+                VkDeviceSize bufferOffset,
+                VkDeviceSize instanceSize,
+                uint32_t instanceCount,
+                VkDeviceSize alignmentSize);
+
         static VkDeviceSize getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
+        const EngineAllocation& getAllocation() const;
 
         EngineDevice& engineDevice;
+        EngineBufferPool* pool = nullptr;
         void* mapped = nullptr;
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize bufferOffset = 0;
+        EngineAllocation allocation{};
 
         VkDeviceSize bufferSize;
         uint32_t instanceCount;
@@ -61,6 +82,51 @@ namespace engine {
         VkMemoryPropertyFlags memoryPropertyFlags;
     };
 
+    /**
+     * One VkBuffer split into many EngineBuffers, each just an offset and size into the shared buffer.
+     * Lets lots of small buffers with the same usage share a single buffer and allocation. Every buffer handed
+     * out starts at an offset that is valid for any descriptor type the pool's usage allows.
+     * The pool must outlive every buffer allocated from it.
+     */
+    class EngineBufferPool {
+    public:
+        EngineBufferPool(
+                EngineDevice& device,
+                VkDeviceSize size,
+                VkBufferUsageFlags usageFlags,
+                VkMemoryPropertyFlags memoryPropertyFlags);
+        ~EngineBufferPool();
+
+        EngineBufferPool(const EngineBufferPool&) = delete;
+        EngineBufferPool& operator=(const EngineBufferPool&) = delete;
+
+        // Returns nullptr when the pool has no free range large enough
+        std::unique_ptr<EngineBuffer> allocate(VkDeviceSize instanceSize, uint32_t instanceCount, VkDeviceSize minOffsetAlignment = 1);
+        // Same as allocate, but falls back to a standalone buffer with the pool's usage and memory when the pool is
+        // full. For buffers that grow with the scene and may outgrow the pool
+        std::unique_ptr<EngineBuffer> allocateOrCreate(VkDeviceSize instanceSize, uint32_t instanceCount, VkDeviceSize minOffsetAlignment = 1);
+
+        VkBuffer getBuffer() const { return buffer; }
+        VkDeviceSize getSize() const { return ranges.getSize(); }
+        VkDeviceSize getFreeBytes() const;
+        VkDeviceSize getLargestFreeRange() const;
+
+    private:
+        friend class EngineBuffer;
+
+        void release(VkDeviceSize offset, VkDeviceSize size);
+
+        EngineDevice& engineDevice;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        EngineAllocation allocation{};
+        VkBufferUsageFlags usageFlags;
+        VkMemoryPropertyFlags memoryPropertyFlags;
+        VkDeviceSize offsetAlignment;
+
+        mutable std::mutex mutex{};
+        EngineRangeAllocator ranges;
+    };
+
 } // engine
 
 #endif //VULKANENGINE_ENGINE_BUFFER_HPP
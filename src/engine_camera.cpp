@@ -16,6 +16,8 @@ void engine::EngineCamera::setOrthographicProjection (float left, float right, f
     projectionMatrix[3][0] = -(right + left) / (right - left);
     projectionMatrix[3][1] = -(bottom + top) / (bottom - top);
     projectionMatrix[3][2] = -near / (far - near);
+    nearPlane = near;
+    farPlane = far;
 }
 
 void engine::EngineCamera::setPerspectiveProjection (float fovY, float aspect, float near, float far) {
@@ -27,6 +29,8 @@ void engine::EngineCamera::setPerspectiveProjection (float fovY, float aspect, f
     projectionMatrix[2][2] = far / (far - near);
     projectionMatrix[2][3] = 1.f;
     projectionMatrix[3][2] = -(far * near) / (far - near);
+    nearPlane = near;
+    farPlane = far;
 }
 
 const glm::mat4 &engine::EngineCamera::getViewMatrix () const {
@@ -112,3 +116,26 @@ void engine::EngineCamera::setViewYXZ (glm::vec3 position, glm::vec3 rotation) {
     inverseViewMatrix[3][1] = position.y;
     inverseViewMatrix[3][2] = position.z;
 }
+
+std::array<glm::vec4, 6> engine::EngineCamera::getFrustumPlanes () const {
+    // Gribb/Hartmann extraction, clip space is -w <= x, y <= w and 0 <= z <= w
+    const glm::mat4 viewProjection = projectionMatrix * viewMatrix;
+    const glm::vec4 row0{viewProjection[0][0], viewProjection[1][0], viewProjection[2][0], viewProjection[3][0]};
+    const glm::vec4 row1{viewProjection[0][1], viewProjection[1][1], viewProjection[2][1], viewProjection[3][1]};
+    const glm::vec4 row2{viewProjection[0][2], viewProjection[1][2], viewProjection[2][2], viewProjection[3][2]};
+    const glm::vec4 row3{viewProjection[0][3], viewProjection[1][3], viewProjection[2][3], viewProjection[3][3]};
+
+    std::array<glm::vec4, 6> planes{
+            row3 + row0,
+            row3 - row0,
+            row3 + row1,
+            row3 - row1,
+            row2,
+            row3 - row2
+    };
+
+    for (auto &plane : planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return planes;
+}
@@ -9,6 +9,9 @@
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
+// std
+#include <array>
+
 namespace engine {
     class EngineCamera {
     public:
@@ -22,11 +25,20 @@ namespace engine {
         [[nodiscard]] const glm::mat4& getProjection() const { return projectionMatrix; }
         [[nodiscard]] const glm::mat4 &getViewMatrix () const;
         [[nodiscard]] const glm::mat4 &getInverseViewMatrix () const { return inverseViewMatrix; }
+        // View space depth of the clip planes of the last projection set
+        [[nodiscard]] float getNear () const { return nearPlane; }
+        [[nodiscard]] float getFar () const { return farPlane; }
+
+        // Left, right, top, bottom, near, far in world space. xyz is the normalised inward normal,
+        // a point is inside a plane when dot(plane.xyz, point) + plane.w >= 0
+        [[nodiscard]] std::array<glm::vec4, 6> getFrustumPlanes () const;
 
     private:
         glm::mat4 projectionMatrix{1.0f};
         glm::mat4 viewMatrix{1.0f};
         glm::mat4 inverseViewMatrix{1.0f};
+        float nearPlane = 0.1f;
+        float farPlane = 100.0f;
     };
 } // engine
 
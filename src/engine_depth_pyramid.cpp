@@ -0,0 +1,288 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "engine_depth_pyramid.hpp"
+
+#include <spdlog/spdlog.h>
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace engine {
+
+    namespace {
+        constexpr uint32_t REDUCE_GROUP_SIZE = 8;
+
+        struct ReducePushConstants {
+            int32_t srcWidth;
+            int32_t srcHeight;
+            int32_t dstWidth;
+            int32_t dstHeight;
+        };
+
+        uint32_t previousPowerOfTwo (uint32_t value) {
+            uint32_t result = 1;
+            while (result * 2 <= value)
+                result *= 2;
+            return result;
+        }
+    }
+
+    EngineDepthPyramid::EngineDepthPyramid (EngineDevice &device, VkExtent2D depthExtent, const std::vector<VkImageView> &depthViews)
+            : engineDevice{device}, depthExtent{depthExtent} {
+        // Rounding down keeps every level an exact halving of the one above, level 0 covers up to 2x2 depth texels
+        extent.width = previousPowerOfTwo (depthExtent.width);
+        extent.height = previousPowerOfTwo (depthExtent.height);
+        levelCount = 1;
+        while ((std::max(extent.width, extent.height) >> levelCount) > 0)
+            levelCount++;
+
+        createImage();
+        createSampler();
+        createPipeline();
+        createDescriptorSets (depthViews);
+    }
+
+    EngineDepthPyramid::~EngineDepthPyramid () {
+        reducePipeline.reset();
+        vkDestroyPipelineLayout (engineDevice.device(), pipelineLayout, nullptr);
+        vkDestroySampler (engineDevice.device(), sampler, nullptr);
+        for (auto levelView : levelViews) {
+            vkDestroyImageView (engineDevice.device(), levelView, nullptr);
+        }
+        vkDestroyImageView (engineDevice.device(), imageView, nullptr);
+        engineDevice.destroyImage (image, imageAllocation);
+    }
+
+    void EngineDepthPyramid::createImage () {
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = extent.width;
+        imageInfo.extent.height = extent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = levelCount;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = VK_FORMAT_R32_SFLOAT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        engineDevice.createImageWithInfo (imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageAllocation);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = VK_FORMAT_R32_SFLOAT;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = levelCount;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView (engineDevice.device(), &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to create depth pyramid image view");
+            throw std::runtime_error ("Failed to create depth pyramid image view!");
+        }
+
+        // Descriptors always say GENERAL, so it has to be in that layout before anything is bound, even if unbuilt
+        VkCommandBuffer commandBuffer = engineDevice.beginSingleTimeCommands();
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange = viewInfo.subresourceRange;
+        vkCmdPipelineBarrier (commandBuffer,
+                              VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              0, 0, nullptr, 0, nullptr, 1, &barrier);
+        engineDevice.endSingleTimeCommands (commandBuffer);
+
+        levelViews.resize (levelCount);
+        for (uint32_t level = 0; level < levelCount; level++) {
+            viewInfo.subresourceRange.baseMipLevel = level;
+            viewInfo.subresourceRange.levelCount = 1;
+            if (vkCreateImageView (engineDevice.device(), &viewInfo, nullptr, &levelViews[level]) != VK_SUCCESS) {
+                spdlog::get ("vulkan")->critical ("Failed to create depth pyramid level view");
+                throw std::runtime_error ("Failed to create depth pyramid level view!");
+            }
+        }
+    }
+
+    void EngineDepthPyramid::createSampler () {
+        // Only ever read with texelFetch, so no filtering
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_NEAREST;
+        samplerInfo.minFilter = VK_FILTER_NEAREST;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+        samplerInfo.minLod = 0.0f;
+        samplerInfo.maxLod = static_cast<float>(levelCount);
+        samplerInfo.anisotropyEnable = VK_FALSE;
+        samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+
+        if (vkCreateSampler (engineDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to create depth pyramid sampler");
+            throw std::runtime_error ("Failed to create depth pyramid sampler!");
+        }
+    }
+
+    void EngineDepthPyramid::createPipeline () {
+        // Cached, so recreating the pyramid with the swap chain reuses the same layout
+        reduceSetLayout = &EngineDescriptorSetLayout::Builder(engineDevice)
+                .addBinding (0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+                .addBinding (1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)
+                .build (engineDevice.getDescriptorLayoutCache());
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof (ReducePushConstants);
+
+        VkDescriptorSetLayout setLayout = reduceSetLayout->getDescriptorSetLayout();
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &setLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if (vkCreatePipelineLayout (engineDevice.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to create depth reduce pipeline layout");
+            throw std::runtime_error ("Failed to create depth reduce pipeline layout!");
+        }
+
+        reducePipeline = std::make_unique<EngineComputePipeline>(engineDevice, "assets/shaders/depth_reduce.comp.spv", pipelineLayout);
+    }
+
+    void EngineDepthPyramid::createDescriptorSets (const std::vector<VkImageView> &depthViews) {
+        auto setCount = static_cast<uint32_t>(depthViews.size() + levelCount - 1);
+        // Its own allocator, the sets go away with the pyramid when the swap chain is recreated
+        reduceDescriptors = EngineDescriptorAllocator::Builder(engineDevice)
+                .setInitialSets (setCount)
+                .addPoolRatio (VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f)
+                .addPoolRatio (VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f)
+                .build();
+
+        VkDescriptorImageInfo dstInfo{};
+        dstInfo.imageView = levelViews[0];
+        dstInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+        depthSets.resize (depthViews.size());
+        for (size_t i = 0; i < depthViews.size(); i++) {
+            VkDescriptorImageInfo srcInfo{};
+            srcInfo.sampler = sampler;
+            srcInfo.imageView = depthViews[i];
+            srcInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
+
+            if (!EngineDescriptorWriter(*reduceSetLayout, *reduceDescriptors)
+                    .writeImage (0, &srcInfo)
+                    .writeImage (1, &dstInfo)
+                    .build (depthSets[i])) {
+                spdlog::get ("vulkan")->critical ("Failed to allocate depth pyramid descriptor set");
+                throw std::runtime_error ("Failed to allocate depth pyramid descriptor set!");
+            }
+        }
+
+        levelSets.resize (levelCount - 1);
+        for (uint32_t level = 1; level < levelCount; level++) {
+            VkDescriptorImageInfo srcInfo{};
+            srcInfo.sampler = sampler;
+            srcInfo.imageView = levelViews[level - 1];
+            srcInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+            VkDescriptorImageInfo levelDstInfo{};
+            levelDstInfo.imageView = levelViews[level];
+            levelDstInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+
+            if (!EngineDescriptorWriter(*reduceSetLayout, *reduceDescriptors)
+                    .writeImage (0, &srcInfo)
+                    .writeImage (1, &levelDstInfo)
+                    .build (levelSets[level - 1])) {
+                spdlog::get ("vulkan")->critical ("Failed to allocate depth pyramid descriptor set");
+                throw std::runtime_error ("Failed to allocate depth pyramid descriptor set!");
+            }
+        }
+    }
+
+    void EngineDepthPyramid::build (VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+        assert(imageIndex < depthSets.size() && "Depth image index out of range");
+
+        // Every level is rewritten, so the old contents can be dropped. Waits for this frame's culling to stop reading it
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = levelCount;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+
+        vkCmdPipelineBarrier (commandBuffer,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        reducePipeline->bind (commandBuffer);
+
+        VkExtent2D srcExtent = depthExtent;
+        for (uint32_t level = 0; level < levelCount; level++) {
+            VkExtent2D dstExtent{std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u)};
+            VkDescriptorSet set = level == 0 ? depthSets[imageIndex] : levelSets[level - 1];
+
+            vkCmdBindDescriptorSets (commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
+
+            ReducePushConstants push{
+                    static_cast<int32_t>(srcExtent.width),
+                    static_cast<int32_t>(srcExtent.height),
+                    static_cast<int32_t>(dstExtent.width),
+                    static_cast<int32_t>(dstExtent.height)};
+            vkCmdPushConstants (commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof (ReducePushConstants), &push);
+
+            vkCmdDispatch (commandBuffer,
+                           (dstExtent.width + REDUCE_GROUP_SIZE - 1) / REDUCE_GROUP_SIZE,
+                           (dstExtent.height + REDUCE_GROUP_SIZE - 1) / REDUCE_GROUP_SIZE,
+                           1);
+
+            // The next level reads this one, the last level is read by the next frame's culling
+            barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            barrier.subresourceRange.baseMipLevel = level;
+            barrier.subresourceRange.levelCount = 1;
+
+            vkCmdPipelineBarrier (commandBuffer,
+                                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                  VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                  0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+            srcExtent = dstExtent;
+        }
+
+        built = true;
+    }
+
+} // engine
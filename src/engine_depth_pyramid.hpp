@@ -0,0 +1,75 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_ENGINE_DEPTH_PYRAMID_HPP
+#define VULKANENGINE_ENGINE_DEPTH_PYRAMID_HPP
+
+#include "engine_device.hpp"
+#include "engine_pipeline.hpp"
+#include "engine_descriptors.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * Hierarchical depth buffer for occlusion culling. Level 0 is the swap chain depth rounded down to a power of two,
+     * every texel of every level holds the farthest depth of the area it covers, so anything nearer than that
+     * value could still be visible. Built with a compute reduction after the main pass and read by the next frame's culling.
+     * Lives in VK_IMAGE_LAYOUT_GENERAL the whole time.
+     */
+    class EngineDepthPyramid {
+    public:
+        // depthViews are the swap chain depth images, one per swap chain image
+        EngineDepthPyramid (EngineDevice &device, VkExtent2D depthExtent, const std::vector<VkImageView> &depthViews);
+        ~EngineDepthPyramid ();
+
+        EngineDepthPyramid (const EngineDepthPyramid &) = delete;
+        EngineDepthPyramid &operator= (const EngineDepthPyramid &) = delete;
+
+        // Records the reduction of the depth image that belongs to imageIndex, outside of any render pass
+        void build (VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
+        // False until the first build has been recorded, culling has nothing to test against before that
+        [[nodiscard]] bool isBuilt () const { return built; }
+
+        [[nodiscard]] VkImageView getImageView () const { return imageView; }
+        [[nodiscard]] VkSampler getSampler () const { return sampler; }
+        [[nodiscard]] VkExtent2D getExtent () const { return extent; }
+        [[nodiscard]] uint32_t getLevelCount () const { return levelCount; }
+
+    private:
+        void createImage ();
+        void createSampler ();
+        void createPipeline ();
+        void createDescriptorSets (const std::vector<VkImageView> &depthViews);
+
+        EngineDevice &engineDevice;
+        VkExtent2D depthExtent;
+        VkExtent2D extent{};
+        uint32_t levelCount = 1;
+        bool built = false;
+
+        VkImage image = VK_NULL_HANDLE;
+        EngineAllocation imageAllocation{};
+        VkImageView imageView = VK_NULL_HANDLE;
+        std::vector<VkImageView> levelViews{};
+        VkSampler sampler = VK_NULL_HANDLE;
+
+        // Owned by the device's layout cache
+        EngineDescriptorSetLayout *reduceSetLayout = nullptr;
+        std::unique_ptr<EngineDescriptorAllocator> reduceDescriptors;
+        // One set per swap chain depth image for level 0, then one per level reading the level above it
+        std::vector<VkDescriptorSet> depthSets{};
+        std::vector<VkDescriptorSet> levelSets{};
+
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        std::unique_ptr<EngineComputePipeline> reducePipeline;
+    };
+
+} // engine
+
+#endif //VULKANENGINE_ENGINE_DEPTH_PYRAMID_HPP
@@ -5,7 +5,9 @@
 #include "engine_descriptors.hpp"
 
 // std
+#include <algorithm>
 #include <cassert>
+#include <functional>
 #include <stdexcept>
 #include <spdlog/spdlog.h>
 
@@ -28,22 +30,50 @@ namespace engine {
         return *this;
     }
 
+    EngineDescriptorSetLayout::Builder &EngineDescriptorSetLayout::Builder::setBindingFlags(
+            uint32_t binding,
+            VkDescriptorBindingFlags flags) {
+        assert(bindings.count(binding) == 1 && "Binding flags set before the binding was added");
+        bindingFlags[binding] = flags;
+        return *this;
+    }
+
     std::unique_ptr<EngineDescriptorSetLayout> EngineDescriptorSetLayout::Builder::build() const {
-        return std::make_unique<EngineDescriptorSetLayout>(engineDevice, bindings);
+        return std::make_unique<EngineDescriptorSetLayout>(engineDevice, bindings, bindingFlags);
+    }
+
+    EngineDescriptorSetLayout &EngineDescriptorSetLayout::Builder::build(EngineDescriptorLayoutCache &cache) const {
+        return cache.getLayout(bindings, bindingFlags);
     }
 
 // *************** Descriptor Set Layout *********************
 
     EngineDescriptorSetLayout::EngineDescriptorSetLayout(
-            EngineDevice &engineDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings)
+            EngineDevice &engineDevice,
+            std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+            const std::unordered_map<uint32_t, VkDescriptorBindingFlags> &bindingFlags)
             : engineDevice{engineDevice}, bindings{bindings} {
         std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
+        std::vector<VkDescriptorBindingFlags> setLayoutBindingFlags{};
+        VkDescriptorSetLayoutCreateFlags layoutFlags = 0;
         for (auto kv : bindings) {
             setLayoutBindings.push_back(kv.second);
+
+            auto flags = bindingFlags.find(kv.first);
+            setLayoutBindingFlags.push_back(flags != bindingFlags.end() ? flags->second : 0);
+            if (setLayoutBindingFlags.back() & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT)
+                layoutFlags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
         }
 
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+        bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        bindingFlagsInfo.bindingCount = static_cast<uint32_t>(setLayoutBindingFlags.size());
+        bindingFlagsInfo.pBindingFlags = setLayoutBindingFlags.data();
+
         VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
         descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        descriptorSetLayoutInfo.pNext = bindingFlags.empty() ? nullptr : &bindingFlagsInfo;
+        descriptorSetLayoutInfo.flags = layoutFlags;
         descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
         descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
 
@@ -116,9 +146,7 @@ namespace engine {
         allocInfo.pSetLayouts = &descriptorSetLayout;
         allocInfo.descriptorSetCount = 1;
 
-        // Might want to create a "DescriptorPoolManager" class that handles this case, and builds
-        // a new pool whenever an old pool fills up. But this is beyond our current scope
-        //TODO Better descriptor set handling https://vkguide.dev/docs/extra-chapter/abstracting_descriptors/
+        // Fixed size, EngineDescriptorAllocator is the one that moves on to a new pool when this happens
         if (vkAllocateDescriptorSets(engineDevice.device(), &allocInfo, &descriptor) != VK_SUCCESS) {
             return false;
         }
@@ -137,10 +165,186 @@ namespace engine {
         vkResetDescriptorPool(engineDevice.device(), descriptorPool, 0);
     }
 
+// *************** Descriptor Allocator Builder *********************
+
+    EngineDescriptorAllocator::Builder &EngineDescriptorAllocator::Builder::addPoolRatio(
+            VkDescriptorType descriptorType, float ratio) {
+        ratios.push_back({descriptorType, ratio});
+        return *this;
+    }
+
+    EngineDescriptorAllocator::Builder &EngineDescriptorAllocator::Builder::setPoolFlags(
+            VkDescriptorPoolCreateFlags flags) {
+        poolFlags = flags;
+        return *this;
+    }
+
+    EngineDescriptorAllocator::Builder &EngineDescriptorAllocator::Builder::setInitialSets(uint32_t count) {
+        initialSets = count;
+        return *this;
+    }
+
+    std::unique_ptr<EngineDescriptorAllocator> EngineDescriptorAllocator::Builder::build() const {
+        if (!ratios.empty())
+            return std::make_unique<EngineDescriptorAllocator>(engineDevice, initialSets, poolFlags, ratios);
+
+        std::vector<PoolSizeRatio> defaultRatios{
+                {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f},
+                {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3.0f},
+                {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1.0f},
+                {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1.0f}};
+        return std::make_unique<EngineDescriptorAllocator>(engineDevice, initialSets, poolFlags, defaultRatios);
+    }
+
+// *************** Descriptor Allocator *********************
+
+    EngineDescriptorAllocator::EngineDescriptorAllocator(
+            EngineDevice &engineDevice,
+            uint32_t initialSets,
+            VkDescriptorPoolCreateFlags poolFlags,
+            const std::vector<PoolSizeRatio> &ratios)
+            : engineDevice{engineDevice}, poolFlags{poolFlags}, ratios{ratios}, setsPerPool{std::max(initialSets, 1u)} {}
+
+    EngineDescriptorAllocator::~EngineDescriptorAllocator() {
+        if (currentPool != VK_NULL_HANDLE)
+            vkDestroyDescriptorPool(engineDevice.device(), currentPool, nullptr);
+        for (auto pool : fullPools)
+            vkDestroyDescriptorPool(engineDevice.device(), pool, nullptr);
+        for (auto pool : readyPools)
+            vkDestroyDescriptorPool(engineDevice.device(), pool, nullptr);
+    }
+
+    VkDescriptorPool EngineDescriptorAllocator::grabPool() {
+        if (!readyPools.empty()) {
+            VkDescriptorPool pool = readyPools.back();
+            readyPools.pop_back();
+            return pool;
+        }
+
+        std::vector<VkDescriptorPoolSize> poolSizes{};
+        poolSizes.reserve(ratios.size());
+        for (auto &ratio : ratios) {
+            auto count = static_cast<uint32_t>(ratio.ratio * static_cast<float>(setsPerPool));
+            poolSizes.push_back({ratio.descriptorType, std::max(count, 1u)});
+        }
+
+        VkDescriptorPoolCreateInfo descriptorPoolInfo{};
+        descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        descriptorPoolInfo.pPoolSizes = poolSizes.data();
+        descriptorPoolInfo.maxSets = setsPerPool;
+        descriptorPoolInfo.flags = poolFlags;
+
+        VkDescriptorPool pool;
+        if (vkCreateDescriptorPool(engineDevice.device(), &descriptorPoolInfo, nullptr, &pool) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to create descriptor pool");
+            throw std::runtime_error("Failed to create descriptor pool!");
+        }
+        spdlog::get ("vulkan")->debug ("Created descriptor pool for {} sets", setsPerPool);
+
+        setsPerPool = std::min(setsPerPool * 2, MAX_SETS_PER_POOL);
+        return pool;
+    }
+
+    bool EngineDescriptorAllocator::allocateDescriptorSet(const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet &descriptor) {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        VkDescriptorSetAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocInfo.pSetLayouts = &descriptorSetLayout;
+        allocInfo.descriptorSetCount = 1;
+
+        if (currentPool != VK_NULL_HANDLE) {
+            allocInfo.descriptorPool = currentPool;
+            // Out of pool memory and fragmented are the usual reasons, without maintenance1 it can be any error
+            if (vkAllocateDescriptorSets(engineDevice.device(), &allocInfo, &descriptor) == VK_SUCCESS)
+                return true;
+            fullPools.push_back(currentPool);
+        }
+
+        currentPool = grabPool();
+        allocInfo.descriptorPool = currentPool;
+        return vkAllocateDescriptorSets(engineDevice.device(), &allocInfo, &descriptor) == VK_SUCCESS;
+    }
+
+    void EngineDescriptorAllocator::resetPools() {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        if (currentPool != VK_NULL_HANDLE) {
+            fullPools.push_back(currentPool);
+            currentPool = VK_NULL_HANDLE;
+        }
+        for (auto pool : fullPools) {
+            vkResetDescriptorPool(engineDevice.device(), pool, 0);
+            readyPools.push_back(pool);
+        }
+        fullPools.clear();
+    }
+
+// *************** Descriptor Layout Cache *********************
+
+    bool EngineDescriptorLayoutCache::LayoutKey::operator==(const LayoutKey &other) const {
+        if (bindings.size() != other.bindings.size())
+            return false;
+
+        for (size_t i = 0; i < bindings.size(); i++) {
+            auto &a = bindings[i];
+            auto &b = other.bindings[i];
+            if (a.binding != b.binding || a.descriptorType != b.descriptorType ||
+                a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags || flags[i] != other.flags[i])
+                return false;
+        }
+        return true;
+    }
+
+    size_t EngineDescriptorLayoutCache::LayoutKeyHash::operator()(const LayoutKey &key) const {
+        size_t result = std::hash<size_t>()(key.bindings.size());
+        for (size_t i = 0; i < key.bindings.size(); i++) {
+            auto &binding = key.bindings[i];
+            // Packs the binding into one 64 bit value, stage and binding flags only use the low bits
+            uint64_t packed = binding.binding | static_cast<uint64_t>(binding.descriptorType) << 8 |
+                              static_cast<uint64_t>(binding.descriptorCount) << 16 |
+                              static_cast<uint64_t>(binding.stageFlags) << 40 |
+                              static_cast<uint64_t>(key.flags[i]) << 56;
+            result ^= std::hash<uint64_t>()(packed) + 0x9e3779b9 + (result << 6) + (result >> 2);
+        }
+        return result;
+    }
+
+    EngineDescriptorSetLayout &EngineDescriptorLayoutCache::getLayout(
+            const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> &bindings,
+            const std::unordered_map<uint32_t, VkDescriptorBindingFlags> &bindingFlags) {
+        LayoutKey key{};
+        key.bindings.reserve(bindings.size());
+        for (auto &kv : bindings) {
+            assert(kv.second.pImmutableSamplers == nullptr && "Immutable samplers aren't part of the cache key");
+            key.bindings.push_back(kv.second);
+        }
+        std::sort(key.bindings.begin(), key.bindings.end(), [] (auto &a, auto &b) { return a.binding < b.binding; });
+        key.flags.reserve(key.bindings.size());
+        for (auto &binding : key.bindings) {
+            auto flags = bindingFlags.find(binding.binding);
+            key.flags.push_back(flags != bindingFlags.end() ? flags->second : 0);
+        }
+
+        std::lock_guard<std::mutex> lock{mutex};
+        auto it = layouts.find(key);
+        if (it != layouts.end())
+            return *it->second;
+
+        auto layout = std::make_unique<EngineDescriptorSetLayout>(engineDevice, bindings, bindingFlags);
+        auto &result = *layout;
+        layouts.emplace(std::move(key), std::move(layout));
+        return result;
+    }
+
 // *************** Descriptor Writer *********************
 
     EngineDescriptorWriter::EngineDescriptorWriter(EngineDescriptorSetLayout &setLayout, EngineDescriptorPool &pool)
-            : setLayout{setLayout}, pool{pool} {}
+            : setLayout{setLayout}, pool{&pool} {}
+
+    EngineDescriptorWriter::EngineDescriptorWriter(EngineDescriptorSetLayout &setLayout, EngineDescriptorAllocator &allocator)
+            : setLayout{setLayout}, allocator{&allocator} {}
 
     EngineDescriptorWriter &EngineDescriptorWriter::writeBuffer(
             uint32_t binding, VkDescriptorBufferInfo *bufferInfo) {
@@ -183,8 +387,30 @@ namespace engine {
         return *this;
     }
 
+    EngineDescriptorWriter &EngineDescriptorWriter::writeImage(
+            uint32_t binding, uint32_t arrayElement, VkDescriptorImageInfo *imageInfo) {
+        assert(setLayout.bindings.count(binding) == 1 && "Layout does not contain specified binding");
+
+        auto &bindingDescription = setLayout.bindings[binding];
+
+        assert(arrayElement < bindingDescription.descriptorCount && "Array element past the end of the binding");
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.descriptorType = bindingDescription.descriptorType;
+        write.dstBinding = binding;
+        write.dstArrayElement = arrayElement;
+        write.pImageInfo = imageInfo;
+        write.descriptorCount = 1;
+
+        writes.push_back(write);
+        return *this;
+    }
+
     bool EngineDescriptorWriter::build(VkDescriptorSet &set) {
-        bool success = pool.allocateDescriptorSet (setLayout.getDescriptorSetLayout (), set);
+        bool success = pool != nullptr
+                ? pool->allocateDescriptorSet (setLayout.getDescriptorSetLayout (), set)
+                : allocator->allocateDescriptorSet (setLayout.getDescriptorSetLayout (), set);
         if (!success) {
             return false;
         }
@@ -196,7 +422,7 @@ namespace engine {
         for (auto &write : writes) {
             write.dstSet = set;
         }
-        vkUpdateDescriptorSets(pool.engineDevice.device(), writes.size(), writes.data(), 0, nullptr);
+        vkUpdateDescriptorSets(setLayout.engineDevice.device(), writes.size(), writes.data(), 0, nullptr);
     }
 
 } // engine
\ No newline at end of file
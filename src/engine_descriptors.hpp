@@ -9,11 +9,14 @@
 
 // std
 #include <memory>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
 namespace engine {
 
+    class EngineDescriptorLayoutCache;
+
     class EngineDescriptorSetLayout {
     public:
         class Builder {
@@ -25,16 +28,24 @@ namespace engine {
                     VkDescriptorType descriptorType,
                     VkShaderStageFlags stageFlags,
                     uint32_t count = 1);
+            // Descriptor indexing flags for a binding already added. UPDATE_AFTER_BIND makes the layout, and any pool
+            // its sets come from, update after bind as well
+            Builder &setBindingFlags (uint32_t binding, VkDescriptorBindingFlags flags);
 
             std::unique_ptr <EngineDescriptorSetLayout> build () const;
+            // Shares the layout with every other builder that described the same bindings, the cache keeps ownership
+            EngineDescriptorSetLayout &build (EngineDescriptorLayoutCache &cache) const;
 
         private:
             EngineDevice &engineDevice;
             std::unordered_map <uint32_t, VkDescriptorSetLayoutBinding> bindings{};
+            std::unordered_map <uint32_t, VkDescriptorBindingFlags> bindingFlags{};
         };
 
         EngineDescriptorSetLayout(
-                EngineDevice &EngineDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+                EngineDevice &EngineDevice,
+                std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+                const std::unordered_map<uint32_t, VkDescriptorBindingFlags> &bindingFlags = {});
         ~EngineDescriptorSetLayout();
         EngineDescriptorSetLayout(const EngineDescriptorSetLayout &) = delete;
         EngineDescriptorSetLayout &operator=(const EngineDescriptorSetLayout &) = delete;
@@ -90,19 +101,121 @@ namespace engine {
         friend class EngineDescriptorWriter;
     };
 
+    /**
+     * Hands out descriptor sets from a growing list of pools. When the current pool runs out another is taken, each new
+     * one twice the size of the last up to MAX_SETS_PER_POOL, so nothing has to be sized for the worst case up front.
+     * resetPools frees every set at once and keeps the pools for reuse, an allocator owned by a frame slot recycles
+     * its pools each time that slot comes around.
+     */
+    class EngineDescriptorAllocator {
+    public:
+        static constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+        // Descriptors of a type each pool holds per set it can allocate
+        struct PoolSizeRatio {
+            VkDescriptorType descriptorType;
+            float ratio;
+        };
+
+        class Builder {
+        public:
+            Builder(EngineDevice &engineDevice) : engineDevice{engineDevice} {}
+
+            Builder &addPoolRatio(VkDescriptorType descriptorType, float ratio);
+            Builder &setPoolFlags(VkDescriptorPoolCreateFlags flags);
+            Builder &setInitialSets(uint32_t count);
+            // Without any ratios the pools are sized for the descriptor types the engine's sets use
+            std::unique_ptr<EngineDescriptorAllocator> build() const;
+
+        private:
+            EngineDevice &engineDevice;
+            std::vector<PoolSizeRatio> ratios{};
+            uint32_t initialSets = 64;
+            VkDescriptorPoolCreateFlags poolFlags = 0;
+        };
+
+        EngineDescriptorAllocator(
+                EngineDevice &engineDevice,
+                uint32_t initialSets,
+                VkDescriptorPoolCreateFlags poolFlags,
+                const std::vector<PoolSizeRatio> &ratios);
+        ~EngineDescriptorAllocator();
+        EngineDescriptorAllocator(const EngineDescriptorAllocator &) = delete;
+        EngineDescriptorAllocator &operator=(const EngineDescriptorAllocator &) = delete;
+
+        // Only fails when a set doesn't fit in an empty pool. Safe to call from any thread
+        bool allocateDescriptorSet(const VkDescriptorSetLayout descriptorSetLayout, VkDescriptorSet &descriptor);
+
+        // Every set allocated so far becomes invalid, none of them may still be in use by the GPU
+        void resetPools();
+
+    private:
+        VkDescriptorPool grabPool();
+
+        EngineDevice &engineDevice;
+        VkDescriptorPoolCreateFlags poolFlags;
+        std::vector<PoolSizeRatio> ratios;
+        uint32_t setsPerPool;
+
+        std::mutex mutex{};
+        VkDescriptorPool currentPool = VK_NULL_HANDLE;
+        // Pools that have run out since the last reset, and reset ones waiting to be reused
+        std::vector<VkDescriptorPool> fullPools{};
+        std::vector<VkDescriptorPool> readyPools{};
+    };
+
+    /**
+     * Owns the descriptor set layouts built through it, keyed by their bindings. Systems that describe the same set
+     * get the same VkDescriptorSetLayout back instead of creating their own copy.
+     */
+    class EngineDescriptorLayoutCache {
+    public:
+        explicit EngineDescriptorLayoutCache(EngineDevice &engineDevice) : engineDevice{engineDevice} {}
+        EngineDescriptorLayoutCache(const EngineDescriptorLayoutCache &) = delete;
+        EngineDescriptorLayoutCache &operator=(const EngineDescriptorLayoutCache &) = delete;
+
+        // Safe to call from any thread
+        EngineDescriptorSetLayout &getLayout(
+                const std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> &bindings,
+                const std::unordered_map<uint32_t, VkDescriptorBindingFlags> &bindingFlags = {});
+
+    private:
+        // The bindings sorted by binding number, so the order they were added in doesn't matter
+        struct LayoutKey {
+            std::vector<VkDescriptorSetLayoutBinding> bindings;
+            // Matching each binding, 0 where none were set
+            std::vector<VkDescriptorBindingFlags> flags;
+
+            bool operator==(const LayoutKey &other) const;
+        };
+
+        struct LayoutKeyHash {
+            size_t operator()(const LayoutKey &key) const;
+        };
+
+        EngineDevice &engineDevice;
+        std::mutex mutex{};
+        std::unordered_map<LayoutKey, std::unique_ptr<EngineDescriptorSetLayout>, LayoutKeyHash> layouts{};
+    };
+
     class EngineDescriptorWriter {
     public:
         EngineDescriptorWriter(EngineDescriptorSetLayout &setLayout, EngineDescriptorPool &pool);
+        EngineDescriptorWriter(EngineDescriptorSetLayout &setLayout, EngineDescriptorAllocator &allocator);
 
         EngineDescriptorWriter &writeBuffer(uint32_t binding, VkDescriptorBufferInfo *bufferInfo);
         EngineDescriptorWriter &writeImage(uint32_t binding, VkDescriptorImageInfo *imageInfo);
+        // One element of an array binding
+        EngineDescriptorWriter &writeImage(uint32_t binding, uint32_t arrayElement, VkDescriptorImageInfo *imageInfo);
 
         bool build(VkDescriptorSet &set);
         void overwrite(VkDescriptorSet &set);
 
     private:
         EngineDescriptorSetLayout &setLayout;
-        EngineDescriptorPool &pool;
+        // Sets are allocated from whichever of these the writer was made with
+        EngineDescriptorPool *pool = nullptr;
+        EngineDescriptorAllocator *allocator = nullptr;
         std::vector<VkWriteDescriptorSet> writes;
     };
 
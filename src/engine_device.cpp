@@ -3,6 +3,12 @@
 //
 
 #include "engine_device.hpp"
+#include "engine_upload_manager.hpp"
+#include "engine_buffer.hpp"
+#include "engine_mesh_heap.hpp"
+#include "engine_model.hpp"
+#include "engine_pipeline_cache.hpp"
+#include "engine_descriptors.hpp"
 
 #include <spdlog/spdlog.h>
 
@@ -58,18 +64,48 @@ namespace engine {
         createSurface();
         pickPhysicalDevice();
         createLogicalDevice();
-        createCommandPool();
+        pipelineCache = std::make_unique<EnginePipelineCache>(device_, properties);
+        allocator = std::make_unique<EngineMemoryAllocator>(physicalDevice, device_);
+        createTransientCommandPool();
+        uploadManager = std::make_unique<EngineUploadManager>(*this);
+        meshHeap = std::make_unique<EngineMeshHeap>(*this, sizeof(EngineModel::Vertex));
+        voxelMeshHeap = std::make_unique<EngineMeshHeap>(*this, sizeof(EngineModel::PackedVoxelVertex), EngineMeshHeap::VOXEL_VERTEX_CAPACITY, EngineMeshHeap::VOXEL_INDEX_CAPACITY);
+        voxelFaceHeap = std::make_unique<EngineMeshHeap>(*this, sizeof(EngineModel::PackedVoxelFace), EngineMeshHeap::VOXEL_FACE_CAPACITY,
+                                                         EngineMeshHeap::MAX_QUADS_PER_DRAW * 6, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT);
+        voxelFaceHeap->writeQuadIndexPattern (*uploadManager);
+        uploadManager->wait (uploadManager->submit());
+        frameBufferPool = std::make_unique<EngineBufferPool>(
+                *this,
+                FRAME_BUFFER_POOL_SIZE,
+                VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+        descriptorAllocator = EngineDescriptorAllocator::Builder(*this).build();
+        descriptorLayoutCache = std::make_unique<EngineDescriptorLayoutCache>(*this);
     }
 
     EngineDevice::~EngineDevice() {
-        vkDestroyCommandPool(device_, commandPool, nullptr);
+        // Waits for outstanding uploads and frees its staging memory through the allocator
+        uploadManager.reset();
+        meshHeap.reset();
+        voxelMeshHeap.reset();
+        voxelFaceHeap.reset();
+        frameBufferPool.reset();
+        descriptorAllocator.reset();
+        descriptorLayoutCache.reset();
+        vkDestroyCommandPool(device_, transientCommandPool, nullptr);
+        allocator->logStats();
+        allocator.reset();
+        // Written back to disk on the way out
+        pipelineCache.reset();
         vkDestroyDevice(device_, nullptr);
 
         if (enableValidationLayers) {
             DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
         }
 
-        vkDestroySurfaceKHR(instance, surface_, nullptr);
+        if (surface_ != VK_NULL_HANDLE) {
+            vkDestroySurfaceKHR(instance, surface_, nullptr);
+        }
         vkDestroyInstance(instance, nullptr);
     }
 
@@ -147,6 +183,9 @@ namespace engine {
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
         std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+        if (indices.transferFamilyHasValue) {
+            uniqueQueueFamilies.insert(indices.transferFamily);
+        }
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -160,16 +199,36 @@ namespace engine {
 
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        // Everything in the mesh heap is drawn with one indirect call, firstInstance indexes the object buffer
+        deviceFeatures.multiDrawIndirect = VK_TRUE;
+        deviceFeatures.drawIndirectFirstInstance = VK_TRUE;
+        // Cooked textures are BC1/BC3/BC7, the feature guarantees every BC format can be sampled
+        deviceFeatures.textureCompressionBC = VK_TRUE;
+
+        // Timeline semaphores are core in 1.2, used to track uploads on the transfer queue.
+        // Draw indirect count lets the cull pass decide how many draws run
+        VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+        vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        vulkan12Features.timelineSemaphore = VK_TRUE;
+        vulkan12Features.drawIndirectCount = VK_TRUE;
+        // Descriptor indexing, also core in 1.2, backs the bindless texture array
+        vulkan12Features.runtimeDescriptorArray = VK_TRUE;
+        vulkan12Features.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        vulkan12Features.descriptorBindingPartiallyBound = VK_TRUE;
+        vulkan12Features.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        vulkan12Features.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.pNext = &vulkan12Features;
 
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        auto extensions = getDeviceExtensions();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -187,32 +246,49 @@ namespace engine {
 
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+
+        graphicsFamily_ = indices.graphicsFamily;
+
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+        timestampValidBits_ = queueFamilies[graphicsFamily_].timestampValidBits;
+
+        transferFamily_ = indices.transferFamilyHasValue ? indices.transferFamily : indices.graphicsFamily;
+        vkGetDeviceQueue(device_, transferFamily_, 0, &transferQueue_);
+        spdlog::get ("vulkan")->info ("Transfer queue family: {}{}", transferFamily_, hasDedicatedTransferQueue() ? " (dedicated)" : "");
     }
 
-    void EngineDevice::createCommandPool() {
+    void EngineDevice::createTransientCommandPool() {
         QueueFamilyIndices queueFamilyIndices = findPhysicalQueueFamilies();
 
+        // Buffers are freed after every submit rather than reset, so no per buffer reset
         VkCommandPoolCreateInfo poolInfo = {};
         poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
         poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
-        poolInfo.flags =
-                VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
 
-        if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
-            spdlog::get ("vulkan")->critical ("Failed to create command pool");
-            throw std::runtime_error("Failed to create command pool!");
+        if (vkCreateCommandPool(device_, &poolInfo, nullptr, &transientCommandPool) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to create transient command pool");
+            throw std::runtime_error("Failed to create transient command pool!");
         }
     }
 
-    void EngineDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+    void EngineDevice::createSurface() {
+        if (isHeadless())
+            return;
+        window.createWindowSurface(instance, &surface_);
+    }
 
     bool EngineDevice::isDeviceSuitable(VkPhysicalDevice device) {
         QueueFamilyIndices indices = findQueueFamilies(device);
 
         bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported) {
+        // Nothing is presented when headless
+        bool swapChainAdequate = isHeadless();
+        if (extensionsSupported && !isHeadless()) {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
         }
@@ -220,7 +296,26 @@ namespace engine {
         VkPhysicalDeviceFeatures supportedFeatures;
         vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
 
-        return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+        // Timeline semaphores need a 1.2 device
+        VkPhysicalDeviceProperties deviceProperties;
+        vkGetPhysicalDeviceProperties(device, &deviceProperties);
+        bool apiSupported = deviceProperties.apiVersion >= VK_API_VERSION_1_2;
+
+        VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+        vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceFeatures2 features2 = {};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &vulkan12Features;
+        if (apiSupported) {
+            vkGetPhysicalDeviceFeatures2(device, &features2);
+        }
+
+        return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy
+               && supportedFeatures.multiDrawIndirect && supportedFeatures.drawIndirectFirstInstance && supportedFeatures.textureCompressionBC && apiSupported
+               && vulkan12Features.timelineSemaphore && vulkan12Features.drawIndirectCount
+               && vulkan12Features.runtimeDescriptorArray && vulkan12Features.shaderSampledImageArrayNonUniformIndexing
+               && vulkan12Features.descriptorBindingPartiallyBound && vulkan12Features.descriptorBindingSampledImageUpdateAfterBind
+               && vulkan12Features.descriptorBindingUpdateUnusedWhilePending;
     }
 
     void EngineDevice::populateDebugMessengerCreateInfo(
@@ -270,11 +365,14 @@ namespace engine {
     }
 
     std::vector<const char *> EngineDevice::getRequiredExtensions() {
-        uint32_t glfwExtensionCount = 0;
-        const char **glfwExtensions;
-        glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-        std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        std::vector<const char *> extensions;
+        // GLFW is never initialized when headless, and no surface extensions are needed
+        if (!isHeadless()) {
+            uint32_t glfwExtensionCount = 0;
+            const char **glfwExtensions;
+            glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+            extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+        }
 
         if (enableValidationLayers) {
             extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -318,7 +416,8 @@ namespace engine {
                 &extensionCount,
                 availableExtensions.data());
 
-        std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+        auto extensions = getDeviceExtensions();
+        std::set<std::string> requiredExtensions(extensions.begin(), extensions.end());
 
         for (const auto &extension : availableExtensions) {
             requiredExtensions.erase(extension.extensionName);
@@ -327,6 +426,16 @@ namespace engine {
         return requiredExtensions.empty();
     }
 
+    std::vector<const char *> EngineDevice::getDeviceExtensions() {
+        std::vector<const char *> extensions;
+        for (const char *extension : deviceExtensions) {
+            if (isHeadless() && strcmp(extension, VK_KHR_SWAPCHAIN_EXTENSION_NAME) == 0)
+                continue;
+            extensions.push_back(extension);
+        }
+        return extensions;
+    }
+
     QueueFamilyIndices EngineDevice::findQueueFamilies(VkPhysicalDevice device) {
         QueueFamilyIndices indices;
 
@@ -338,18 +447,30 @@ namespace engine {
 
         int i = 0;
         for (const auto &queueFamily : queueFamilies) {
-            if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
-                indices.graphicsFamily = i;
-                indices.graphicsFamilyHasValue = true;
-            }
-            VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-            if (queueFamily.queueCount > 0 && presentSupport) {
-                indices.presentFamily = i;
-                indices.presentFamilyHasValue = true;
+            if (!indices.isComplete()) {
+                if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+                    indices.graphicsFamily = i;
+                    indices.graphicsFamilyHasValue = true;
+                }
+                // Without a surface the graphics family stands in for present, nothing is ever queued on it
+                VkBool32 presentSupport = false;
+                if (surface_ != VK_NULL_HANDLE) {
+                    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+                } else {
+                    presentSupport = (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+                }
+                if (queueFamily.queueCount > 0 && presentSupport) {
+                    indices.presentFamily = i;
+                    indices.presentFamilyHasValue = true;
+                }
             }
-            if (indices.isComplete()) {
-                break;
+
+            // Prefer a transfer only family over one that can also do compute
+            bool transferOnly = (queueFamily.queueFlags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)) == 0;
+            if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT &&
+                !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) && (!indices.transferFamilyHasValue || transferOnly)) {
+                indices.transferFamily = i;
+                indices.transferFamilyHasValue = true;
             }
 
             i++;
@@ -384,6 +505,8 @@ namespace engine {
         return details;
     }
 
+    VkPipelineCache EngineDevice::getPipelineCache() { return pipelineCache->getCache(); }
+
     VkFormat EngineDevice::findSupportedFormat(
             const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features) {
         for (VkFormat format : candidates) {
@@ -402,17 +525,7 @@ namespace engine {
     }
 
     uint32_t EngineDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
-        VkPhysicalDeviceMemoryProperties memProperties;
-        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
-            if ((typeFilter & (1 << i)) &&
-                (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-                return i;
-            }
-        }
-
-        spdlog::get ("vulkan")->critical ("Failed to find suitable memory type");
-        throw std::runtime_error("Failed to find suitable memory type!");
+        return allocator->findMemoryType(typeFilter, properties);
     }
 
     void EngineDevice::createBuffer(
@@ -420,13 +533,21 @@ namespace engine {
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer &buffer,
-            VkDeviceMemory &bufferMemory) {
+            EngineAllocation &bufferAllocation) {
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
         bufferInfo.size = size;
         bufferInfo.usage = usage;
         bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+        // Copies may run on the transfer queue, sharing the buffer avoids queue family ownership transfers
+        uint32_t queueFamilies[] = {graphicsFamily_, transferFamily_};
+        if (hasDedicatedTransferQueue() && (usage & (VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT))) {
+            bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            bufferInfo.queueFamilyIndexCount = 2;
+            bufferInfo.pQueueFamilyIndices = queueFamilies;
+        }
+
         if (vkCreateBuffer(device_, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
             spdlog::get ("vulkan")->critical ("Failed to create buffer");
             throw std::runtime_error("Failed to create buffer!");
@@ -435,24 +556,24 @@ namespace engine {
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        bufferAllocation = allocator->allocate(memRequirements, properties, AllocationKind::Linear);
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-            spdlog::get ("vulkan")->critical ("Failed to allocate buffer memory");
-            throw std::runtime_error("Failed to allocate buffer memory!");
+        if (vkBindBufferMemory(device_, buffer, bufferAllocation.memory, bufferAllocation.offset) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to bind buffer memory");
+            throw std::runtime_error("Failed to bind buffer memory!");
         }
+    }
 
-        vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+    void EngineDevice::destroyBuffer(VkBuffer buffer, EngineAllocation &bufferAllocation) {
+        vkDestroyBuffer(device_, buffer, nullptr);
+        allocator->free(bufferAllocation);
     }
 
     VkCommandBuffer EngineDevice::beginSingleTimeCommands() {
         VkCommandBufferAllocateInfo allocInfo{};
         allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = commandPool;
+        allocInfo.commandPool = transientCommandPool;
         allocInfo.commandBufferCount = 1;
 
         VkCommandBuffer commandBuffer;
@@ -474,18 +595,25 @@ namespace engine {
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &commandBuffer;
 
-        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-        vkQueueWaitIdle(graphicsQueue_);
+        // Only wait for this submit, not everything else queued on the graphics queue
+        VkFenceCreateInfo fenceInfo{};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        VkFence fence;
+        vkCreateFence(device_, &fenceInfo, nullptr, &fence);
+
+        vkQueueSubmit(graphicsQueue_, 1, &submitInfo, fence);
+        vkWaitForFences(device_, 1, &fence, VK_TRUE, UINT64_MAX);
 
-        vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+        vkDestroyFence(device_, fence, nullptr);
+        vkFreeCommandBuffers(device_, transientCommandPool, 1, &commandBuffer);
     }
 
-    void EngineDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+    void EngineDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset) {
         VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
         VkBufferCopy copyRegion{};
-        copyRegion.srcOffset = 0;  // Optional
-        copyRegion.dstOffset = 0;  // Optional
+        copyRegion.srcOffset = srcOffset;
+        copyRegion.dstOffset = dstOffset;
         copyRegion.size = size;
         vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
@@ -523,8 +651,17 @@ namespace engine {
             const VkImageCreateInfo &imageInfo,
             VkMemoryPropertyFlags properties,
             VkImage &image,
-            VkDeviceMemory &imageMemory) {
-        if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
+            EngineAllocation &imageAllocation) {
+        VkImageCreateInfo createInfo = imageInfo;
+        uint32_t queueFamilies[] = {graphicsFamily_, transferFamily_};
+        if (hasDedicatedTransferQueue() && createInfo.sharingMode == VK_SHARING_MODE_EXCLUSIVE &&
+            (createInfo.usage & VK_IMAGE_USAGE_TRANSFER_DST_BIT)) {
+            createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+            createInfo.queueFamilyIndexCount = 2;
+            createInfo.pQueueFamilyIndices = queueFamilies;
+        }
+
+        if (vkCreateImage(device_, &createInfo, nullptr, &image) != VK_SUCCESS) {
             spdlog::get ("vulkan")->critical ("Failed to create image");
             throw std::runtime_error("failed to create image!");
         }
@@ -532,20 +669,18 @@ namespace engine {
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+        AllocationKind kind = imageInfo.tiling == VK_IMAGE_TILING_LINEAR ? AllocationKind::Linear : AllocationKind::Optimal;
+        imageAllocation = allocator->allocate(memRequirements, properties, kind);
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-            spdlog::get ("vulkan")->critical ("Failed to allocate image memory");
-            throw std::runtime_error("Failed to allocate image memory!");
-        }
-
-        if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+        if (vkBindImageMemory(device_, image, imageAllocation.memory, imageAllocation.offset) != VK_SUCCESS) {
             spdlog::get ("vulkan")->critical ("Failed to bind image memory");
             throw std::runtime_error("Failed to bind image memory!");
         }
     }
 
+    void EngineDevice::destroyImage(VkImage image, EngineAllocation &imageAllocation) {
+        vkDestroyImage(device_, image, nullptr);
+        allocator->free(imageAllocation);
+    }
+
 }  // namespace engine
\ No newline at end of file
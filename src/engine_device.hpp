@@ -6,13 +6,22 @@
 #define BASIC_TESTS_ENGINE_DEVICE_HPP
 
 #include "engine_window.hpp"
+#include "engine_memory_allocator.hpp"
 
 // std lib headers
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace engine {
 
+    class EngineUploadManager;
+    class EngineBufferPool;
+    class EngineMeshHeap;
+    class EnginePipelineCache;
+    class EngineDescriptorAllocator;
+    class EngineDescriptorLayoutCache;
+
     struct SwapChainSupportDetails {
         VkSurfaceCapabilitiesKHR capabilities;
         std::vector<VkSurfaceFormatKHR> formats;
@@ -22,8 +31,10 @@ namespace engine {
     struct QueueFamilyIndices {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        uint32_t transferFamily;
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
+        bool transferFamilyHasValue = false;    // only set for a transfer family without graphics, usually a DMA engine
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
     };
 
@@ -34,6 +45,8 @@ namespace engine {
 #else
         const bool enableValidationLayers = true;
 #endif
+        // Shared host visible buffer for the small per frame uniform, storage and instance buffers of the systems
+        static constexpr VkDeviceSize FRAME_BUFFER_POOL_SIZE = 4 * 1024 * 1024;
 
         EngineDevice(EngineWindow &window);
         ~EngineDevice();
@@ -44,11 +57,35 @@ namespace engine {
         EngineDevice(EngineDevice &&) = delete;
         EngineDevice &operator=(EngineDevice &&) = delete;
 
-        VkCommandPool getCommandPool() { return commandPool; }
+        // Transient pool for the short lived buffers of beginSingleTimeCommands, frames record from their own pools
+        VkCommandPool getTransientCommandPool() { return transientCommandPool; }
         VkDevice device() { return device_; }
+        // VK_NULL_HANDLE when headless
         VkSurfaceKHR surface() { return surface_; }
+        // No surface or swap chain, frames are rendered to offscreen images. Works on any device including software ones
+        bool isHeadless() { return window.isHeadless(); }
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
+        // The dedicated transfer queue if the device has one, otherwise the graphics queue
+        VkQueue transferQueue() { return transferQueue_; }
+        uint32_t graphicsQueueFamily() { return graphicsFamily_; }
+        uint32_t transferQueueFamily() { return transferFamily_; }
+        bool hasDedicatedTransferQueue() { return transferFamily_ != graphicsFamily_; }
+        // Meaningful bits in graphics queue timestamps, 0 if it can't write them
+        uint32_t getTimestampValidBits() { return timestampValidBits_; }
+        EngineMemoryAllocator &getAllocator() { return *allocator; }
+        EngineUploadManager &getUploadManager() { return *uploadManager; }
+        EngineMeshHeap &getMeshHeap() { return *meshHeap; }
+        // Packed voxel vertices, chunk meshes live here and draw with their own pipeline
+        EngineMeshHeap &getVoxelMeshHeap() { return *voxelMeshHeap; }
+        // Packed voxel faces read by the vertex shader as a storage buffer, indexed through one shared quad pattern
+        EngineMeshHeap &getVoxelFaceHeap() { return *voxelFaceHeap; }
+        EngineBufferPool &getFrameBufferPool() { return *frameBufferPool; }
+        // For sets that live as long as the device, per frame sets come from the renderer's frame allocators
+        EngineDescriptorAllocator &getDescriptorAllocator() { return *descriptorAllocator; }
+        EngineDescriptorLayoutCache &getDescriptorLayoutCache() { return *descriptorLayoutCache; }
+        // Shared by every pipeline, persisted to disk between runs
+        VkPipelineCache getPipelineCache();
 
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -62,10 +99,11 @@ namespace engine {
                 VkBufferUsageFlags usage,
                 VkMemoryPropertyFlags properties,
                 VkBuffer &buffer,
-                VkDeviceMemory &bufferMemory);
+                EngineAllocation &bufferAllocation);
+        void destroyBuffer(VkBuffer buffer, EngineAllocation &bufferAllocation);
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-        void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+        void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
         void copyBufferToImage(
                 VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
@@ -73,7 +111,8 @@ namespace engine {
                 const VkImageCreateInfo &imageInfo,
                 VkMemoryPropertyFlags properties,
                 VkImage &image,
-                VkDeviceMemory &imageMemory);
+                EngineAllocation &imageAllocation);
+        void destroyImage(VkImage image, EngineAllocation &imageAllocation);
 
         VkPhysicalDeviceProperties properties;
 
@@ -83,7 +122,7 @@ namespace engine {
         void createSurface();
         void pickPhysicalDevice();
         void createLogicalDevice();
-        void createCommandPool();
+        void createTransientCommandPool();
 
         // helper functions
         bool isDeviceSuitable(VkPhysicalDevice device);
@@ -93,18 +132,33 @@ namespace engine {
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
         void hasGflwRequiredInstanceExtensions();
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        // deviceExtensions without the swap chain when headless
+        std::vector<const char *> getDeviceExtensions();
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
         VkInstance instance;
         VkDebugUtilsMessengerEXT debugMessenger;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
         EngineWindow &window;
-        VkCommandPool commandPool;
+        VkCommandPool transientCommandPool;
+        std::unique_ptr<EngineMemoryAllocator> allocator;
+        std::unique_ptr<EngineUploadManager> uploadManager;
+        std::unique_ptr<EngineMeshHeap> meshHeap;
+        std::unique_ptr<EngineMeshHeap> voxelMeshHeap;
+        std::unique_ptr<EngineMeshHeap> voxelFaceHeap;
+        std::unique_ptr<EngineBufferPool> frameBufferPool;
+        std::unique_ptr<EngineDescriptorAllocator> descriptorAllocator;
+        std::unique_ptr<EngineDescriptorLayoutCache> descriptorLayoutCache;
+        std::unique_ptr<EnginePipelineCache> pipelineCache;
 
         VkDevice device_;
-        VkSurfaceKHR surface_;
+        VkSurfaceKHR surface_ = VK_NULL_HANDLE;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue transferQueue_;
+        uint32_t graphicsFamily_;
+        uint32_t transferFamily_;
+        uint32_t timestampValidBits_ = 0;
 
         const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
         const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
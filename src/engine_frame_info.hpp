@@ -11,12 +11,14 @@
 // lib
 #include <vulkan/vulkan.h>
 
-#define MAX_LIGHTS 10
-
 namespace engine {
 
+    class EngineGpuProfiler;
+    class EngineDescriptorAllocator;
+
+    // std430 layout of LightBuffer in light_cluster.comp and simple_shader.frag
     struct PointLight {
-        glm::vec4 position{}; // ignore w
+        glm::vec4 position{}; // w is the range, past it the light is cut off
         glm::vec4 color{}; // w is intensity
     };
 
@@ -25,8 +27,6 @@ namespace engine {
         glm::mat4 view{1.0f};
         glm::mat4 inverseView{1.0f};
         glm::vec4 ambientLightColor{1.0f, 1.0f, 1.0f, 0.05f}; // w is light intensity
-        PointLight pointLights[MAX_LIGHTS];
-        int numLights;
     };
 
     struct EngineFrameInfo {
@@ -36,6 +36,10 @@ namespace engine {
         EngineCamera &camera;
         VkDescriptorSet globalDescriptorSet;
         EngineGameObject::Map &gameObjects;
+        // Render systems open a scope for each pass they record
+        EngineGpuProfiler &gpuProfiler;
+        // Sets that only have to last for this frame, recycled once its fence has signalled
+        EngineDescriptorAllocator &frameDescriptors;
     };
 
 } // engine
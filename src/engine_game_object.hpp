@@ -6,11 +6,13 @@
 #define BASIC_TESTS_ENGINE_GAME_OBJECT_HPP
 
 #include "engine_model.hpp"
+#include "engine_texture_registry.hpp"
 
 // libs
 #include <glm/gtc/matrix_transform.hpp>
 
 // std
+#include <cstdint>
 #include <memory>
 #include <unordered_map>
 
@@ -52,6 +54,10 @@ namespace engine {
 
         glm::vec3 color {};
         TransformComponent transform {};
+        // Slot in the bindless texture registry, 0 is its fallback texture
+        uint32_t textureIndex = EngineTextureRegistry::FALLBACK_TEXTURE;
+        // Texture array slot in the registry, sampled at each vertex's layer instead of textureIndex when set
+        uint32_t textureArrayIndex = EngineTextureRegistry::NO_TEXTURE_ARRAY;
 
         // Optional pointer components
         std::shared_ptr<EngineModel> model {};
@@ -0,0 +1,231 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "engine_gpu_profiler.hpp"
+#include "engine_swapchain.hpp"
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+// std
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+
+namespace engine {
+
+    EngineGpuProfiler::Scope::Scope (EngineGpuProfiler &profiler, VkCommandBuffer commandBuffer, const char *name)
+            : profiler{profiler}, commandBuffer{commandBuffer} {
+        scope = profiler.beginScope (commandBuffer, name);
+    }
+
+    EngineGpuProfiler::Scope::~Scope () {
+        profiler.endScope (commandBuffer, scope);
+    }
+
+    EngineGpuProfiler::EngineGpuProfiler (EngineDevice &device) : engineDevice{device} {
+        uint32_t validBits = device.getTimestampValidBits();
+        if (validBits == 0) {
+            spdlog::get ("renderer")->warn ("Graphics queue does not support timestamps, GPU profiling is disabled");
+            return;
+        }
+
+        timestampMask = validBits >= 64 ? UINT64_MAX : (uint64_t{1} << validBits) - 1;
+        timestampPeriod = device.properties.limits.timestampPeriod;
+
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        poolInfo.queryCount = MAX_SCOPES_PER_FRAME * 2;
+
+        frames.resize (EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (auto &frame : frames) {
+            if (vkCreateQueryPool (device.device(), &poolInfo, nullptr, &frame.queryPool) != VK_SUCCESS) {
+                spdlog::get ("vulkan")->critical ("Failed to create timestamp query pool");
+                throw std::runtime_error ("Failed to create timestamp query pool!");
+            }
+        }
+
+        // Every query is followed by its availability
+        results.resize (MAX_SCOPES_PER_FRAME * 2 * 2);
+        enabled = true;
+    }
+
+    EngineGpuProfiler::~EngineGpuProfiler () {
+        for (auto &frame : frames) {
+            vkDestroyQueryPool (engineDevice.device(), frame.queryPool, nullptr);
+        }
+    }
+
+    void EngineGpuProfiler::beginFrame (VkCommandBuffer commandBuffer, int frameIndex) {
+        if (!enabled)
+            return;
+
+        currentFrame = frameIndex;
+        auto &frame = frames[frameIndex];
+        collect (frame);
+
+        frame.scopes.clear();
+        frame.queryCount = 0;
+        vkCmdResetQueryPool (commandBuffer, frame.queryPool, 0, MAX_SCOPES_PER_FRAME * 2);
+        frameScope = beginScope (commandBuffer, "frame");
+    }
+
+    void EngineGpuProfiler::endFrame (VkCommandBuffer commandBuffer) {
+        if (!enabled)
+            return;
+
+        endScope (commandBuffer, frameScope);
+        frameScope = INVALID_SCOPE;
+        currentFrame = -1;
+    }
+
+    uint32_t EngineGpuProfiler::beginScope (VkCommandBuffer commandBuffer, const char *name) {
+        if (!enabled || currentFrame < 0)
+            return INVALID_SCOPE;
+
+        std::lock_guard<std::mutex> lock{scopeMutex};
+        auto &frame = frames[currentFrame];
+        if (frame.queryCount + 2 > MAX_SCOPES_PER_FRAME * 2)
+            return INVALID_SCOPE;
+
+        ScopeRecord record{getNameIndex (name), frame.queryCount};
+        frame.queryCount += 2;
+        vkCmdWriteTimestamp (commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.queryPool, record.firstQuery);
+
+        frame.scopes.push_back (record);
+        return static_cast<uint32_t>(frame.scopes.size() - 1);
+    }
+
+    void EngineGpuProfiler::endScope (VkCommandBuffer commandBuffer, uint32_t scope) {
+        if (!enabled || currentFrame < 0 || scope == INVALID_SCOPE)
+            return;
+
+        std::lock_guard<std::mutex> lock{scopeMutex};
+        auto &frame = frames[currentFrame];
+        vkCmdWriteTimestamp (commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.queryPool, frame.scopes[scope].firstQuery + 1);
+    }
+
+    void EngineGpuProfiler::collect (FrameQueries &frame) {
+        // Nothing recorded yet, the pool hasn't even been reset
+        if (frame.queryCount == 0)
+            return;
+
+        // The frame's fence was waited on before this, so everything should be available. Any scope left open simply has
+        // no availability for its end and is skipped
+        VkResult result = vkGetQueryPoolResults (
+                engineDevice.device(),
+                frame.queryPool,
+                0,
+                frame.queryCount,
+                frame.queryCount * 2 * sizeof (uint64_t),
+                results.data(),
+                2 * sizeof (uint64_t),
+                VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (result != VK_SUCCESS && result != VK_NOT_READY)
+            return;
+
+        // A scope opened several times in one frame counts as one sample of the total
+        std::vector<double> frameTotals (histories.size(), -1.0);
+        for (const auto &scope : frame.scopes) {
+            const uint64_t *begin = &results[scope.firstQuery * 2];
+            const uint64_t *end = &results[(scope.firstQuery + 1) * 2];
+            if (begin[1] == 0 || end[1] == 0)
+                continue;
+
+            uint64_t ticks = (end[0] - begin[0]) & timestampMask;
+            double milliseconds = static_cast<double>(ticks) * timestampPeriod / 1000000.0;
+            frameTotals[scope.nameIndex] = std::max (frameTotals[scope.nameIndex], 0.0) + milliseconds;
+        }
+
+        for (size_t i = 0; i < frameTotals.size(); i++) {
+            if (frameTotals[i] < 0.0)
+                continue;
+
+            auto &history = histories[i];
+            if (history.samples.size() < HISTORY_SIZE) {
+                history.samples.push_back (frameTotals[i]);
+            } else {
+                history.samples[history.next] = frameTotals[i];
+            }
+            history.next = (history.next + 1) % HISTORY_SIZE;
+        }
+
+        collectedFrames++;
+        if (collectedFrames % LOG_INTERVAL == 0)
+            logStats();
+    }
+
+    uint32_t EngineGpuProfiler::getNameIndex (const char *name) {
+        auto found = nameIndices.find (name);
+        if (found != nameIndices.end())
+            return found->second;
+
+        auto index = static_cast<uint32_t>(histories.size());
+        histories.push_back ({name});
+        nameIndices.emplace (name, index);
+        return index;
+    }
+
+    std::vector<EngineGpuProfiler::ScopeStats> EngineGpuProfiler::getStats () const {
+        std::vector<ScopeStats> stats{};
+        std::vector<double> sorted{};
+
+        for (const auto &history : histories) {
+            if (history.samples.empty())
+                continue;
+
+            sorted = history.samples;
+            std::sort (sorted.begin(), sorted.end());
+            size_t p99Index = std::min (sorted.size() - 1, sorted.size() * 99 / 100);
+
+            stats.push_back ({
+                    history.name,
+                    static_cast<uint32_t>(sorted.size()),
+                    sorted.front(),
+                    std::accumulate (sorted.begin(), sorted.end(), 0.0) / static_cast<double>(sorted.size()),
+                    sorted[p99Index]});
+        }
+        return stats;
+    }
+
+    void EngineGpuProfiler::logStats () const {
+        if (!enabled)
+            return;
+
+        auto log = spdlog::get ("renderer");
+        log->info ("GPU times over the last {} frames:", std::min<uint64_t> (collectedFrames, HISTORY_SIZE));
+        for (const auto &stats : getStats()) {
+            log->info ("  {:<16} min {:>8.3f} ms  avg {:>8.3f} ms  p99 {:>8.3f} ms", stats.name, stats.minMs, stats.averageMs, stats.p99Ms);
+        }
+    }
+
+    bool EngineGpuProfiler::writeReport (const std::string &filepath) const {
+        std::ofstream file (filepath);
+        if (!file) {
+            spdlog::get ("renderer")->error ("Failed to open GPU profile report {}", filepath);
+            return false;
+        }
+
+        // Read by tooling, the library takes care of escaping scope and device names
+        nlohmann::json scopes = nlohmann::json::array();
+        for (const auto &stats : getStats()) {
+            scopes.push_back ({
+                    {"name", stats.name},
+                    {"samples", stats.sampleCount},
+                    {"min_ms", stats.minMs},
+                    {"avg_ms", stats.averageMs},
+                    {"p99_ms", stats.p99Ms}});
+        }
+
+        nlohmann::json report{};
+        report["device"] = engineDevice.properties.deviceName;
+        report["frames"] = collectedFrames;
+        report["scopes"] = std::move (scopes);
+        file << report.dump (2) << "\n";
+        return true;
+    }
+
+} // engine
@@ -0,0 +1,120 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_ENGINE_GPU_PROFILER_HPP
+#define VULKANENGINE_ENGINE_GPU_PROFILER_HPP
+
+#include "engine_device.hpp"
+
+// std
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * Timestamp query based GPU timings. Every frame in flight has its own query pool, the timestamps a frame wrote are
+     * read back the next time its slot comes around, after its fence has already been waited on, so reading never stalls.
+     * Each named scope keeps a rolling window of samples for min, average and 99th percentile times.
+     */
+    class EngineGpuProfiler {
+    public:
+        static constexpr uint32_t MAX_SCOPES_PER_FRAME = 64;
+        // Samples kept per scope for the rolling stats
+        static constexpr uint32_t HISTORY_SIZE = 256;
+        // Stats go to the renderer log every this many collected frames
+        static constexpr uint32_t LOG_INTERVAL = 600;
+        static constexpr uint32_t INVALID_SCOPE = UINT32_MAX;
+
+        struct ScopeStats {
+            std::string name;
+            uint32_t sampleCount;
+            double minMs;
+            double averageMs;
+            double p99Ms;
+        };
+
+        // Opens a scope on construction and closes it when it goes out of scope, on the same command buffer
+        class Scope {
+        public:
+            Scope (EngineGpuProfiler &profiler, VkCommandBuffer commandBuffer, const char *name);
+            ~Scope ();
+
+            Scope (const Scope &) = delete;
+            Scope &operator= (const Scope &) = delete;
+
+        private:
+            EngineGpuProfiler &profiler;
+            VkCommandBuffer commandBuffer;
+            uint32_t scope;
+        };
+
+        explicit EngineGpuProfiler (EngineDevice &device);
+        ~EngineGpuProfiler ();
+
+        EngineGpuProfiler (const EngineGpuProfiler &) = delete;
+        EngineGpuProfiler &operator= (const EngineGpuProfiler &) = delete;
+
+        // Collects the results this frame slot wrote last time, resets its queries and opens the "frame" scope.
+        // Has to be recorded first in the command buffer, outside of any render pass
+        void beginFrame (VkCommandBuffer commandBuffer, int frameIndex);
+        // Closes the "frame" scope, recorded last before the command buffer ends
+        void endFrame (VkCommandBuffer commandBuffer);
+
+        // Scopes may nest. Returns INVALID_SCOPE once the frame runs out of queries, endScope ignores it.
+        // Safe to call from the threads recording secondary command buffers of the frame
+        uint32_t beginScope (VkCommandBuffer commandBuffer, const char *name);
+        void endScope (VkCommandBuffer commandBuffer, uint32_t scope);
+
+        [[nodiscard]] bool isEnabled () const { return enabled; }
+        [[nodiscard]] std::vector<ScopeStats> getStats () const;
+        void logStats () const;
+        // JSON with the stats of every scope, for tooling to pick up after a benchmark run
+        bool writeReport (const std::string &filepath) const;
+
+    private:
+        struct ScopeRecord {
+            uint32_t nameIndex;
+            uint32_t firstQuery;
+        };
+
+        struct FrameQueries {
+            VkQueryPool queryPool = VK_NULL_HANDLE;
+            std::vector<ScopeRecord> scopes{};
+            uint32_t queryCount = 0;
+        };
+
+        struct ScopeHistory {
+            std::string name;
+            std::vector<double> samples{};
+            uint32_t next = 0;
+        };
+
+        void collect (FrameQueries &frame);
+        uint32_t getNameIndex (const char *name);
+
+        EngineDevice &engineDevice;
+        bool enabled = false;
+        uint64_t timestampMask = 0;
+        // Nanoseconds per timestamp tick
+        double timestampPeriod = 1.0;
+
+        // Guards the current frame's scopes and the names while secondaries are recorded in parallel
+        std::mutex scopeMutex{};
+        std::vector<FrameQueries> frames{};
+        int currentFrame = -1;
+        uint32_t frameScope = INVALID_SCOPE;
+
+        std::vector<ScopeHistory> histories{};
+        std::unordered_map<std::string, uint32_t> nameIndices{};
+        uint64_t collectedFrames = 0;
+        std::vector<uint64_t> results{};
+    };
+
+} // engine
+
+#endif //VULKANENGINE_ENGINE_GPU_PROFILER_HPP
@@ -0,0 +1,172 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "engine_job_system.hpp"
+
+#include <spdlog/spdlog.h>
+
+// std
+#include <algorithm>
+#include <exception>
+
+namespace engine {
+
+    namespace {
+        // Lets enqueue push to the calling worker's own deque so follow up work stays on a warm cache
+        thread_local const EngineJobSystem *currentSystem = nullptr;
+        thread_local uint32_t currentWorker = 0;
+    }
+
+    EngineJobSystem::EngineJobSystem (uint32_t workerCount) {
+        workerCount = std::max (workerCount, 1u);
+        for (uint32_t i = 0; i < workerCount; i++) {
+            queues.push_back (std::make_unique<WorkerQueue>());
+        }
+        for (uint32_t i = 0; i < workerCount; i++) {
+            workers.emplace_back (&EngineJobSystem::workerLoop, this, i);
+        }
+        spdlog::get ("main")->info ("Job system started with {} worker threads", workerCount);
+    }
+
+    EngineJobSystem::~EngineJobSystem () {
+        {
+            std::lock_guard<std::mutex> lock{sleepMutex};
+            stopping.store (true);
+        }
+        wakeCondition.notify_all();
+        for (auto &worker : workers) {
+            worker.join();
+        }
+    }
+
+    uint32_t EngineJobSystem::defaultWorkerCount () {
+        uint32_t cores = std::thread::hardware_concurrency();
+        return cores > 1 ? cores - 1 : 1;
+    }
+
+    uint32_t EngineJobSystem::getCurrentThreadIndex () const {
+        return currentSystem == this ? currentWorker : getWorkerCount();
+    }
+
+    JobHandle EngineJobSystem::schedule (std::function<void ()> function, JobPriority priority, const std::vector<JobHandle> &dependencies) {
+        auto job = std::make_shared<Job>();
+        job->function = std::move (function);
+        job->priority = priority;
+
+        for (const auto &dependency : dependencies) {
+            if (dependency == nullptr)
+                continue;
+            std::lock_guard<std::mutex> lock{dependency->dependentsMutex};
+            if (dependency->finished.load (std::memory_order_acquire))
+                continue;
+            job->unfinishedDependencies.fetch_add (1, std::memory_order_relaxed);
+            dependency->dependents.push_back (job);
+        }
+
+        // Drop the guard count, whoever brings the counter to zero queues the job
+        if (job->unfinishedDependencies.fetch_sub (1, std::memory_order_acq_rel) == 1) {
+            enqueue (job);
+        }
+        return job;
+    }
+
+    void EngineJobSystem::wait (const JobHandle &job) {
+        bool isWorker = currentSystem == this;
+        uint32_t queueIndex = isWorker ? currentWorker : 0;
+        while (!isFinished (job)) {
+            if (auto other = findJob (queueIndex, isWorker)) {
+                execute (other);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    void EngineJobSystem::workerLoop (uint32_t workerIndex) {
+        currentSystem = this;
+        currentWorker = workerIndex;
+
+        while (true) {
+            if (auto job = findJob (workerIndex, true)) {
+                execute (job);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock{sleepMutex};
+            wakeCondition.wait (lock, [this] { return stopping.load() || queuedJobs.load() > 0; });
+            if (stopping.load())
+                return;
+        }
+    }
+
+    void EngineJobSystem::enqueue (JobHandle job) {
+        uint32_t queueIndex = currentSystem == this
+                              ? currentWorker
+                              : nextQueue.fetch_add (1, std::memory_order_relaxed) % static_cast<uint32_t>(queues.size());
+        auto &queue = *queues[queueIndex];
+        {
+            std::lock_guard<std::mutex> lock{queue.mutex};
+            queue.jobs[static_cast<int>(job->priority)].push_back (std::move (job));
+        }
+        queuedJobs.fetch_add (1);
+
+        // Taking the lock orders this wake up against a worker that is about to sleep
+        { std::lock_guard<std::mutex> lock{sleepMutex}; }
+        wakeCondition.notify_one();
+    }
+
+    JobHandle EngineJobSystem::findJob (uint32_t workerIndex, bool ownsQueue) {
+        const auto queueCount = static_cast<uint32_t>(queues.size());
+        for (int priority = 0; priority < PRIORITY_COUNT; priority++) {
+            if (ownsQueue) {
+                auto &own = *queues[workerIndex];
+                std::lock_guard<std::mutex> lock{own.mutex};
+                auto &jobs = own.jobs[priority];
+                if (!jobs.empty()) {
+                    JobHandle job = std::move (jobs.back());
+                    jobs.pop_back();
+                    queuedJobs.fetch_sub (1);
+                    return job;
+                }
+            }
+
+            for (uint32_t offset = ownsQueue ? 1 : 0; offset < queueCount; offset++) {
+                auto &victim = *queues[(workerIndex + offset) % queueCount];
+                std::lock_guard<std::mutex> lock{victim.mutex};
+                auto &jobs = victim.jobs[priority];
+                if (!jobs.empty()) {
+                    JobHandle job = std::move (jobs.front());
+                    jobs.pop_front();
+                    queuedJobs.fetch_sub (1);
+                    return job;
+                }
+            }
+        }
+        return nullptr;
+    }
+
+    void EngineJobSystem::execute (const JobHandle &job) {
+        try {
+            job->function();
+        } catch (std::exception &e) {
+            spdlog::get ("main")->critical ("Job threw an exception: {}", e.what());
+        } catch (...) {
+            spdlog::get ("main")->critical ("Job threw an exception that is not a std::exception");
+        }
+        job->function = nullptr;
+
+        std::vector<JobHandle> dependents{};
+        {
+            std::lock_guard<std::mutex> lock{job->dependentsMutex};
+            job->finished.store (true, std::memory_order_release);
+            dependents.swap (job->dependents);
+        }
+        for (auto &dependent : dependents) {
+            if (dependent->unfinishedDependencies.fetch_sub (1, std::memory_order_acq_rel) == 1) {
+                enqueue (std::move (dependent));
+            }
+        }
+    }
+
+} // engine
@@ -0,0 +1,95 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_ENGINE_JOB_SYSTEM_HPP
+#define VULKANENGINE_ENGINE_JOB_SYSTEM_HPP
+
+// std
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine {
+
+    enum class JobPriority : int {
+        High = 0,
+        Normal = 1,
+        Low = 2
+    };
+
+    struct Job {
+        std::function<void ()> function{};
+        JobPriority priority = JobPriority::Normal;
+
+        // Starts at one so the job can not run before schedule has finished registering its dependencies
+        std::atomic<int> unfinishedDependencies{1};
+        std::atomic<bool> finished{false};
+
+        std::mutex dependentsMutex{};
+        std::vector<std::shared_ptr<Job>> dependents{};
+    };
+
+    using JobHandle = std::shared_ptr<Job>;
+
+    /**
+     * Work stealing thread pool. Every worker owns one deque per priority, it pops its own work from the back
+     * and steals from the front of other workers when it runs dry. Jobs can depend on other jobs, a job is
+     * only queued once every dependency has finished.
+     */
+    class EngineJobSystem {
+    public:
+        static constexpr int PRIORITY_COUNT = 3;
+
+        explicit EngineJobSystem (uint32_t workerCount = defaultWorkerCount());
+        ~EngineJobSystem ();
+
+        EngineJobSystem (const EngineJobSystem &) = delete;
+        EngineJobSystem &operator= (const EngineJobSystem &) = delete;
+
+        JobHandle schedule (std::function<void ()> function, JobPriority priority = JobPriority::Normal, const std::vector<JobHandle> &dependencies = {});
+
+        // Runs other queued jobs on the calling thread until job has finished
+        void wait (const JobHandle &job);
+
+        static bool isFinished (const JobHandle &job) { return job == nullptr || job->finished.load (std::memory_order_acquire); }
+
+        [[nodiscard]] uint32_t getWorkerCount () const { return static_cast<uint32_t>(workers.size()); }
+        // Index of the worker running the caller, getWorkerCount() for any thread that isn't one of this system's workers.
+        // Lets per thread resources be picked without locking, as long as only one outside thread uses them
+        [[nodiscard]] uint32_t getCurrentThreadIndex () const;
+
+        // One worker per core, minus the core the render thread runs on
+        static uint32_t defaultWorkerCount ();
+
+    private:
+        struct WorkerQueue {
+            std::mutex mutex{};
+            std::array<std::deque<JobHandle>, PRIORITY_COUNT> jobs{};
+        };
+
+        void workerLoop (uint32_t workerIndex);
+        void enqueue (JobHandle job);
+        JobHandle findJob (uint32_t workerIndex, bool ownsQueue);
+        void execute (const JobHandle &job);
+
+        std::vector<std::unique_ptr<WorkerQueue>> queues{};
+        std::vector<std::thread> workers{};
+
+        std::atomic<uint32_t> nextQueue{0};
+        std::atomic<int64_t> queuedJobs{0};
+        std::atomic<bool> stopping{false};
+
+        std::mutex sleepMutex{};
+        std::condition_variable wakeCondition{};
+    };
+
+} // engine
+
+#endif //VULKANENGINE_ENGINE_JOB_SYSTEM_HPP
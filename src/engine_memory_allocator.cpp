@@ -0,0 +1,347 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "engine_memory_allocator.hpp"
+
+#include <spdlog/spdlog.h>
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace engine {
+
+    namespace {
+        constexpr VkDeviceSize MAX_BLOCK_SIZE = 256ull * 1024 * 1024;
+        constexpr VkDeviceSize MIN_BLOCK_SIZE = 16ull * 1024 * 1024;
+
+        VkDeviceSize alignUp (VkDeviceSize value, VkDeviceSize alignment) {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        VkDeviceSize alignDown (VkDeviceSize value, VkDeviceSize alignment) {
+            return value / alignment * alignment;
+        }
+    }
+
+    struct EngineMemoryBlock {
+        EngineMemoryBlock (VkDeviceSize size) : ranges{size} {}
+
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        uint32_t memoryTypeIndex = 0;
+        AllocationKind kind = AllocationKind::Linear;
+        bool dedicated = false;
+        void *mapped = nullptr;
+        uint32_t allocationCount = 0;
+        EngineRangeAllocator ranges;
+    };
+
+    // ---------------------------------------------------------------------------------------------------------------
+    // EngineRangeAllocator
+
+    EngineRangeAllocator::EngineRangeAllocator (VkDeviceSize size) : size{size}, freeBytes{0} {
+        insertFreeRange (0, size);
+    }
+
+    VkDeviceSize EngineRangeAllocator::allocate (VkDeviceSize allocationSize, VkDeviceSize alignment) {
+        assert(allocationSize > 0 && "Cannot allocate an empty range");
+        alignment = std::max<VkDeviceSize> (alignment, 1);
+
+        // Smallest first, a range may still be too small once its start is aligned so keep looking
+        for (auto candidate = freeBySize.lower_bound (allocationSize); candidate != freeBySize.end(); ++candidate) {
+            VkDeviceSize rangeOffset = candidate->second;
+            VkDeviceSize rangeSize = candidate->first;
+            VkDeviceSize alignedOffset = alignUp (rangeOffset, alignment);
+            if (alignedOffset + allocationSize > rangeOffset + rangeSize)
+                continue;
+
+            eraseFreeRange (freeByOffset.find (rangeOffset));
+            // The padding in front and the tail both stay free
+            if (alignedOffset > rangeOffset)
+                insertFreeRange (rangeOffset, alignedOffset - rangeOffset);
+            VkDeviceSize end = alignedOffset + allocationSize;
+            if (end < rangeOffset + rangeSize)
+                insertFreeRange (end, rangeOffset + rangeSize - end);
+            return alignedOffset;
+        }
+        return INVALID_OFFSET;
+    }
+
+    void EngineRangeAllocator::free (VkDeviceSize offset, VkDeviceSize rangeSize) {
+        assert(offset + rangeSize <= size && "Freed range is outside the allocator");
+
+        VkDeviceSize start = offset;
+        VkDeviceSize end = offset + rangeSize;
+
+        auto next = freeByOffset.lower_bound (offset);
+        if (next != freeByOffset.begin()) {
+            auto previous = std::prev (next);
+            assert(previous->first + previous->second <= start && "Range freed twice");
+            if (previous->first + previous->second == start) {
+                start = previous->first;
+                eraseFreeRange (previous);
+            }
+        }
+        if (next != freeByOffset.end() && next->first == end) {
+            end += next->second;
+            eraseFreeRange (next);
+        }
+        insertFreeRange (start, end - start);
+    }
+
+    VkDeviceSize EngineRangeAllocator::getLargestFreeRange () const {
+        return freeBySize.empty() ? 0 : freeBySize.rbegin()->first;
+    }
+
+    void EngineRangeAllocator::insertFreeRange (VkDeviceSize offset, VkDeviceSize rangeSize) {
+        freeByOffset.emplace (offset, rangeSize);
+        freeBySize.emplace (rangeSize, offset);
+        freeBytes += rangeSize;
+    }
+
+    void EngineRangeAllocator::eraseFreeRange (std::map<VkDeviceSize, VkDeviceSize>::iterator range) {
+        auto [first, last] = freeBySize.equal_range (range->second);
+        for (auto it = first; it != last; ++it) {
+            if (it->second == range->first) {
+                freeBySize.erase (it);
+                break;
+            }
+        }
+        freeBytes -= range->second;
+        freeByOffset.erase (range);
+    }
+
+    // ---------------------------------------------------------------------------------------------------------------
+    // EngineMemoryStats
+
+    float EngineMemoryStats::fragmentation () const {
+        VkDeviceSize freeBytes = reservedBytes - usedBytes;
+        if (freeBytes == 0)
+            return 0.0f;
+        return 1.0f - static_cast<float>(contiguousFreeBytes) / static_cast<float>(freeBytes);
+    }
+
+    // ---------------------------------------------------------------------------------------------------------------
+    // EngineMemoryAllocator
+
+    EngineMemoryAllocator::EngineMemoryAllocator (VkPhysicalDevice physicalDevice, VkDevice device) : device{device} {
+        vkGetPhysicalDeviceMemoryProperties (physicalDevice, &memoryProperties);
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties (physicalDevice, &properties);
+        nonCoherentAtomSize = std::max<VkDeviceSize> (properties.limits.nonCoherentAtomSize, 1);
+    }
+
+    EngineMemoryAllocator::~EngineMemoryAllocator () {
+        for (auto &block : blocks) {
+            if (block->allocationCount > 0) {
+                spdlog::get ("vulkan")->warn ("Destroying memory block with {} live allocations", block->allocationCount);
+            }
+            if (block->mapped != nullptr)
+                vkUnmapMemory (device, block->memory);
+            vkFreeMemory (device, block->memory, nullptr);
+        }
+    }
+
+    EngineAllocation EngineMemoryAllocator::allocate (const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties,
+                                                      AllocationKind kind) {
+        uint32_t memoryTypeIndex = findMemoryType (requirements.memoryTypeBits, properties);
+        VkDeviceSize blockSize = preferredBlockSize (memoryTypeIndex);
+
+        std::lock_guard<std::mutex> lock{mutex};
+
+        EngineMemoryBlock *block = nullptr;
+        VkDeviceSize offset = EngineRangeAllocator::INVALID_OFFSET;
+
+        if (requirements.size > blockSize / 2) {
+            block = createBlock (memoryTypeIndex, requirements.size, kind, true);
+        } else {
+            for (auto &candidate : blocks) {
+                if (candidate->dedicated || candidate->memoryTypeIndex != memoryTypeIndex || candidate->kind != kind)
+                    continue;
+                offset = candidate->ranges.allocate (requirements.size, requirements.alignment);
+                if (offset != EngineRangeAllocator::INVALID_OFFSET) {
+                    block = candidate.get();
+                    break;
+                }
+            }
+            if (block == nullptr) {
+                block = createBlock (memoryTypeIndex, blockSize, kind, false);
+                // Heap too full for a whole new block, an exact size allocation may still fit
+                if (block == nullptr)
+                    block = createBlock (memoryTypeIndex, requirements.size, kind, true);
+            }
+        }
+
+        if (block == nullptr) {
+            spdlog::get ("vulkan")->critical ("Failed to allocate {} bytes of device memory", requirements.size);
+            throw std::runtime_error ("Failed to allocate device memory!");
+        }
+        if (offset == EngineRangeAllocator::INVALID_OFFSET) {
+            offset = block->ranges.allocate (requirements.size, requirements.alignment);
+            assert(offset != EngineRangeAllocator::INVALID_OFFSET && "New memory block too small for its first allocation");
+        }
+        block->allocationCount++;
+
+        EngineAllocation allocation{};
+        allocation.memory = block->memory;
+        allocation.offset = offset;
+        allocation.size = requirements.size;
+        allocation.mapped = block->mapped != nullptr ? static_cast<char *>(block->mapped) + offset : nullptr;
+        allocation.memoryTypeIndex = memoryTypeIndex;
+        allocation.block = block;
+        return allocation;
+    }
+
+    void EngineMemoryAllocator::free (EngineAllocation &allocation) {
+        if (!allocation.isValid())
+            return;
+
+        std::lock_guard<std::mutex> lock{mutex};
+
+        EngineMemoryBlock *block = allocation.block;
+        block->ranges.free (allocation.offset, allocation.size);
+        block->allocationCount--;
+        allocation = EngineAllocation{};
+
+        if (block->allocationCount > 0)
+            return;
+        if (block->dedicated) {
+            destroyBlock (block);
+            return;
+        }
+
+        // Keep one empty block per memory type around so a resource being recreated does not hit vkAllocateMemory
+        for (auto &other : blocks) {
+            if (other.get() != block && !other->dedicated && other->allocationCount == 0 &&
+                other->memoryTypeIndex == block->memoryTypeIndex && other->kind == block->kind) {
+                destroyBlock (block);
+                return;
+            }
+        }
+    }
+
+    VkResult EngineMemoryAllocator::flush (const EngineAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) {
+        if ((memoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0)
+            return VK_SUCCESS;
+        VkMappedMemoryRange range = alignedRange (allocation, size, offset);
+        return vkFlushMappedMemoryRanges (device, 1, &range);
+    }
+
+    VkResult EngineMemoryAllocator::invalidate (const EngineAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) {
+        if ((memoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0)
+            return VK_SUCCESS;
+        VkMappedMemoryRange range = alignedRange (allocation, size, offset);
+        return vkInvalidateMappedMemoryRanges (device, 1, &range);
+    }
+
+    uint32_t EngineMemoryAllocator::findMemoryType (uint32_t typeFilter, VkMemoryPropertyFlags properties) const {
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            if ((typeFilter & (1 << i)) &&
+                (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+                return i;
+            }
+        }
+
+        spdlog::get ("vulkan")->critical ("Failed to find suitable memory type");
+        throw std::runtime_error ("Failed to find suitable memory type!");
+    }
+
+    EngineMemoryStats EngineMemoryAllocator::getStats () const {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        EngineMemoryStats stats{};
+        for (const auto &block : blocks) {
+            stats.blockCount++;
+            if (block->dedicated)
+                stats.dedicatedBlockCount++;
+            stats.allocationCount += block->allocationCount;
+            stats.reservedBytes += block->ranges.getSize();
+            stats.usedBytes += block->ranges.getSize() - block->ranges.getFreeBytes();
+            stats.freeRangeCount += block->ranges.getFreeRangeCount();
+            stats.largestFreeRange = std::max (stats.largestFreeRange, block->ranges.getLargestFreeRange());
+            stats.contiguousFreeBytes += block->ranges.getLargestFreeRange();
+        }
+        return stats;
+    }
+
+    void EngineMemoryAllocator::logStats () const {
+        EngineMemoryStats stats = getStats();
+        spdlog::get ("vulkan")->info ("Device memory: {} allocations in {} blocks ({} dedicated), {:.2f} / {:.2f} MB used, "
+                                      "{} free ranges, largest {:.2f} MB, fragmentation {:.2f}",
+                                      stats.allocationCount,
+                                      stats.blockCount,
+                                      stats.dedicatedBlockCount,
+                                      stats.usedBytes / (1024.0 * 1024.0),
+                                      stats.reservedBytes / (1024.0 * 1024.0),
+                                      stats.freeRangeCount,
+                                      stats.largestFreeRange / (1024.0 * 1024.0),
+                                      stats.fragmentation());
+    }
+
+    EngineMemoryBlock *EngineMemoryAllocator::createBlock (uint32_t memoryTypeIndex, VkDeviceSize size, AllocationKind kind, bool dedicated) {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+        VkDeviceMemory memory;
+        if (vkAllocateMemory (device, &allocInfo, nullptr, &memory) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->warn ("vkAllocateMemory of {} bytes from memory type {} failed", size, memoryTypeIndex);
+            return nullptr;
+        }
+
+        auto block = std::make_unique<EngineMemoryBlock>(size);
+        block->memory = memory;
+        block->memoryTypeIndex = memoryTypeIndex;
+        block->kind = kind;
+        block->dedicated = dedicated;
+
+        if ((memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0) {
+            if (vkMapMemory (device, memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS) {
+                vkFreeMemory (device, memory, nullptr);
+                spdlog::get ("vulkan")->critical ("Failed to map memory block");
+                throw std::runtime_error ("Failed to map memory block!");
+            }
+        }
+
+        spdlog::get ("vulkan")->debug ("Allocated {} memory block of {:.2f} MB from memory type {}",
+                                       dedicated ? "dedicated" : "shared", size / (1024.0 * 1024.0), memoryTypeIndex);
+        blocks.push_back (std::move (block));
+        return blocks.back().get();
+    }
+
+    void EngineMemoryAllocator::destroyBlock (EngineMemoryBlock *block) {
+        auto it = std::find_if (blocks.begin(), blocks.end(), [block] (const auto &candidate) { return candidate.get() == block; });
+        assert(it != blocks.end() && "Block not owned by this allocator");
+
+        if (block->mapped != nullptr)
+            vkUnmapMemory (device, block->memory);
+        vkFreeMemory (device, block->memory, nullptr);
+        blocks.erase (it);
+    }
+
+    VkMappedMemoryRange EngineMemoryAllocator::alignedRange (const EngineAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) const {
+        if (size == VK_WHOLE_SIZE)
+            size = allocation.size - offset;
+
+        VkDeviceSize start = alignDown (allocation.offset + offset, nonCoherentAtomSize);
+        VkDeviceSize end = std::min (alignUp (allocation.offset + offset + size, nonCoherentAtomSize), allocation.block->ranges.getSize());
+
+        VkMappedMemoryRange range{};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = allocation.memory;
+        range.offset = start;
+        // Running into the end of the block has to be expressed as VK_WHOLE_SIZE when the block is not atom aligned
+        range.size = end == allocation.block->ranges.getSize() ? VK_WHOLE_SIZE : end - start;
+        return range;
+    }
+
+    VkDeviceSize EngineMemoryAllocator::preferredBlockSize (uint32_t memoryTypeIndex) const {
+        VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+        return std::clamp (heapSize / 8, MIN_BLOCK_SIZE, MAX_BLOCK_SIZE);
+    }
+
+} // engine
@@ -0,0 +1,126 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_ENGINE_MEMORY_ALLOCATOR_HPP
+#define VULKANENGINE_ENGINE_MEMORY_ALLOCATOR_HPP
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * Best fit free list over a range of [0, size). Free ranges are kept sorted by offset to coalesce
+     * neighbours on free, and by size to find the smallest range that fits on allocate.
+     * Not thread safe, the owner is expected to lock around it.
+     */
+    class EngineRangeAllocator {
+    public:
+        static constexpr VkDeviceSize INVALID_OFFSET = std::numeric_limits<VkDeviceSize>::max();
+
+        explicit EngineRangeAllocator (VkDeviceSize size);
+
+        // Returns INVALID_OFFSET when no free range is large enough
+        VkDeviceSize allocate (VkDeviceSize size, VkDeviceSize alignment = 1);
+        void free (VkDeviceSize offset, VkDeviceSize size);
+
+        [[nodiscard]] VkDeviceSize getSize () const { return size; }
+        [[nodiscard]] VkDeviceSize getFreeBytes () const { return freeBytes; }
+        [[nodiscard]] size_t getFreeRangeCount () const { return freeByOffset.size(); }
+        [[nodiscard]] VkDeviceSize getLargestFreeRange () const;
+        [[nodiscard]] bool isEmpty () const { return freeBytes == size; }
+
+    private:
+        void insertFreeRange (VkDeviceSize offset, VkDeviceSize size);
+        void eraseFreeRange (std::map<VkDeviceSize, VkDeviceSize>::iterator range);
+
+        VkDeviceSize size;
+        VkDeviceSize freeBytes;
+        std::map<VkDeviceSize, VkDeviceSize> freeByOffset{};
+        std::multimap<VkDeviceSize, VkDeviceSize> freeBySize{};
+    };
+
+    // Buffers and linear images go in Linear blocks, optimal tiling images in Optimal blocks. Keeping the two
+    // apart means neighbouring allocations never have to be padded out to bufferImageGranularity
+    enum class AllocationKind {
+        Linear,
+        Optimal
+    };
+
+    struct EngineMemoryBlock;
+
+    struct EngineAllocation {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void *mapped = nullptr;         // already offset to this allocation, null unless the memory type is host visible
+        uint32_t memoryTypeIndex = 0;
+        EngineMemoryBlock *block = nullptr;
+
+        [[nodiscard]] bool isValid () const { return memory != VK_NULL_HANDLE; }
+    };
+
+    struct EngineMemoryStats {
+        uint32_t blockCount = 0;
+        uint32_t dedicatedBlockCount = 0;
+        uint32_t allocationCount = 0;
+        VkDeviceSize reservedBytes = 0;     // total size of every VkDeviceMemory
+        VkDeviceSize usedBytes = 0;
+        size_t freeRangeCount = 0;
+        VkDeviceSize largestFreeRange = 0;
+        VkDeviceSize contiguousFreeBytes = 0;   // sum of the largest free range of each block
+
+        // 0 when the free memory of each block is one contiguous range, tends to 1 as it is split into many small holes
+        [[nodiscard]] float fragmentation () const;
+    };
+
+    /**
+     * Hands out ranges of large VkDeviceMemory blocks instead of calling vkAllocateMemory per resource.
+     * Blocks are kept per memory type and allocation kind, host visible blocks stay mapped for their whole life.
+     * Requests bigger than half a block get a dedicated block of their own.
+     */
+    class EngineMemoryAllocator {
+    public:
+        EngineMemoryAllocator (VkPhysicalDevice physicalDevice, VkDevice device);
+        ~EngineMemoryAllocator ();
+
+        EngineMemoryAllocator (const EngineMemoryAllocator &) = delete;
+        EngineMemoryAllocator &operator= (const EngineMemoryAllocator &) = delete;
+
+        EngineAllocation allocate (const VkMemoryRequirements &requirements, VkMemoryPropertyFlags properties, AllocationKind kind);
+        void free (EngineAllocation &allocation);
+
+        // Offsets are relative to the allocation, the range is widened to nonCoherentAtomSize
+        VkResult flush (const EngineAllocation &allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+        VkResult invalidate (const EngineAllocation &allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+        uint32_t findMemoryType (uint32_t typeFilter, VkMemoryPropertyFlags properties) const;
+
+        [[nodiscard]] EngineMemoryStats getStats () const;
+        void logStats () const;
+
+    private:
+        EngineMemoryBlock *createBlock (uint32_t memoryTypeIndex, VkDeviceSize size, AllocationKind kind, bool dedicated);
+        void destroyBlock (EngineMemoryBlock *block);
+        VkMappedMemoryRange alignedRange (const EngineAllocation &allocation, VkDeviceSize size, VkDeviceSize offset) const;
+        VkDeviceSize preferredBlockSize (uint32_t memoryTypeIndex) const;
+
+        VkDevice device;
+        VkPhysicalDeviceMemoryProperties memoryProperties{};
+        VkDeviceSize nonCoherentAtomSize;
+
+        mutable std::mutex mutex{};
+        std::vector<std::unique_ptr<EngineMemoryBlock>> blocks{};
+    };
+
+} // engine
+
+#endif //VULKANENGINE_ENGINE_MEMORY_ALLOCATOR_HPP
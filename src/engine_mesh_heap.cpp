@@ -0,0 +1,122 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "engine_mesh_heap.hpp"
+#include "engine_upload_manager.hpp"
+
+#include <spdlog/spdlog.h>
+
+// std
+#include <cassert>
+#include <stdexcept>
+#include <vector>
+
+namespace engine {
+
+    namespace {
+        VkDeviceSize unitsPerIndex (VkIndexType indexType) {
+            return indexType == VK_INDEX_TYPE_UINT16 ? 1 : 2;
+        }
+    }
+
+    EngineMeshHeap::EngineMeshHeap (EngineDevice &device, VkDeviceSize vertexStride, uint32_t vertexCapacity, uint32_t indexCapacity,
+                                    VkBufferUsageFlags extraVertexUsage)
+            : vertexStride{vertexStride}, vertexRanges{vertexCapacity}, indexRanges{static_cast<VkDeviceSize>(indexCapacity) * 2} {
+        vertexBuffer = std::make_unique<EngineBuffer>(
+                device,
+                vertexStride,
+                vertexCapacity,
+                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | extraVertexUsage,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        indexBuffer = std::make_unique<EngineBuffer>(
+                device,
+                sizeof (uint16_t),
+                static_cast<uint32_t>(indexCapacity) * 2,
+                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        spdlog::get ("renderer")->info ("Mesh heap: {} vertices of {} bytes, {} indices", vertexCapacity, vertexStride, indexCapacity);
+    }
+
+    MeshAllocation EngineMeshHeap::allocate (uint32_t vertexCount, uint32_t indexCount, VkIndexType indexType) {
+        MeshAllocation allocation{};
+
+        VkDeviceSize firstVertex = vertexRanges.allocate (vertexCount);
+        if (firstVertex == EngineRangeAllocator::INVALID_OFFSET) {
+            spdlog::get ("renderer")->critical ("Mesh heap is out of vertex space, {} requested, {} free", vertexCount, getFreeVertices());
+            throw std::runtime_error ("Mesh heap is out of vertex space!");
+        }
+
+        // Aligned to the index size so the range starts on a whole index when the buffer is bound as that type
+        VkDeviceSize units = unitsPerIndex (indexType);
+        VkDeviceSize firstUnit = 0;
+        if (indexCount > 0) {
+            firstUnit = indexRanges.allocate (indexCount * units, units);
+            if (firstUnit == EngineRangeAllocator::INVALID_OFFSET) {
+                vertexRanges.free (firstVertex, vertexCount);
+                spdlog::get ("renderer")->critical ("Mesh heap is out of index space, {} bytes requested, {} free", indexCount * units * sizeof (uint16_t), getFreeIndexBytes());
+                throw std::runtime_error ("Mesh heap is out of index space!");
+            }
+        }
+
+        allocation.firstVertex = static_cast<uint32_t>(firstVertex);
+        allocation.vertexCapacity = vertexCount;
+        allocation.firstIndex = static_cast<uint32_t>(firstUnit / units);
+        allocation.indexCapacity = indexCount;
+        allocation.indexType = indexType;
+        return allocation;
+    }
+
+    void EngineMeshHeap::free (MeshAllocation &allocation) {
+        if (!allocation.isValid())
+            return;
+
+        vertexRanges.free (allocation.firstVertex, allocation.vertexCapacity);
+        if (allocation.indexCapacity > 0) {
+            VkDeviceSize units = unitsPerIndex (allocation.indexType);
+            indexRanges.free (allocation.firstIndex * units, allocation.indexCapacity * units);
+        }
+
+        allocation = MeshAllocation{};
+    }
+
+    void EngineMeshHeap::writeQuadIndexPattern (EngineUploadManager &uploads) {
+        // 32 bit, the pattern reaches well past the last 16 bit index
+        auto indexCount = static_cast<uint32_t>(indexRanges.getSize() / 2);
+        assert(indexCount % 6 == 0 && indexRanges.isEmpty() && "Quad pattern needs a whole, untouched index buffer");
+        VkDeviceSize firstIndex = indexRanges.allocate (indexRanges.getSize(), 2);
+        assert(firstIndex == 0 && "Face draws expect the pattern at the start of the index buffer");
+
+        // Same order as the mesher's indexed quads, faces looking down a negative axis flip their corners in the shader
+        std::vector<uint32_t> indices (indexCount);
+        for (uint32_t quad = 0; quad < indexCount / 6; quad++) {
+            uint32_t base = quad * 4;
+            uint32_t *out = &indices[static_cast<size_t>(quad) * 6];
+            out[0] = base;
+            out[1] = base + 1;
+            out[2] = base + 2;
+            out[3] = base + 2;
+            out[4] = base + 3;
+            out[5] = base;
+        }
+        uploads.uploadToBuffer (indices.data(), sizeof (uint32_t) * indexCount, indexBuffer->getBuffer(), getIndexBufferOffset (static_cast<uint32_t>(firstIndex)));
+    }
+
+    void EngineMeshHeap::bind (VkCommandBuffer commandBuffer, VkIndexType indexType) const {
+        VkBuffer buffers[] = {vertexBuffer->getBuffer()};
+        VkDeviceSize offsets[] = {vertexBuffer->getBufferOffset()};
+        vkCmdBindVertexBuffers (commandBuffer, 0, 1, buffers, offsets);
+        vkCmdBindIndexBuffer (commandBuffer, indexBuffer->getBuffer(), indexBuffer->getBufferOffset(), indexType);
+    }
+
+    VkDeviceSize EngineMeshHeap::getVertexBufferOffset (uint32_t firstVertex) const {
+        return vertexBuffer->getBufferOffset() + static_cast<VkDeviceSize>(firstVertex) * vertexStride;
+    }
+
+    VkDeviceSize EngineMeshHeap::getIndexBufferOffset (uint32_t firstIndex, VkIndexType indexType) const {
+        return indexBuffer->getBufferOffset() + static_cast<VkDeviceSize>(firstIndex) * unitsPerIndex (indexType) * sizeof (uint16_t);
+    }
+
+} // engine
@@ -0,0 +1,94 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_ENGINE_MESH_HEAP_HPP
+#define VULKANENGINE_ENGINE_MESH_HEAP_HPP
+
+#include "engine_device.hpp"
+#include "engine_buffer.hpp"
+#include "engine_memory_allocator.hpp"
+
+// std
+#include <cstdint>
+#include <memory>
+
+namespace engine {
+
+    class EngineUploadManager;
+
+    // Ranges are in elements, not bytes, so they drop straight into vertexOffset and firstIndex of a draw.
+    // The index range counts elements of indexType, the type the heap has to be bound with to draw it
+    struct MeshAllocation {
+        uint32_t firstVertex = 0;
+        uint32_t vertexCapacity = 0;
+        uint32_t firstIndex = 0;
+        uint32_t indexCapacity = 0;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+        [[nodiscard]] bool isValid () const { return vertexCapacity > 0; }
+    };
+
+    /**
+     * One shared vertex buffer and one shared index buffer that every model is sub-allocated from, so a whole
+     * scene draws with a single vertex/index bind. Each heap holds a single vertex format, given by its stride.
+     * 16 and 32 bit indices share the index buffer, which is bound once per index type.
+     * Not thread safe, models are created and destroyed on the render thread.
+     */
+    class EngineMeshHeap {
+    public:
+        static constexpr uint32_t DEFAULT_VERTEX_CAPACITY = 2 * 1024 * 1024;
+        static constexpr uint32_t DEFAULT_INDEX_CAPACITY = 4 * 1024 * 1024;
+        // Chunk meshes are all quads, four vertices to six indices
+        static constexpr uint32_t VOXEL_VERTEX_CAPACITY = 4 * 1024 * 1024;
+        static constexpr uint32_t VOXEL_INDEX_CAPACITY = 6 * 1024 * 1024;
+        // Face records, one per quad, pulled by the vertex shader
+        static constexpr uint32_t VOXEL_FACE_CAPACITY = 4 * 1024 * 1024;
+        // Longest run of the shared quad pattern, so the most faces one face model can hold. A power of two so pooled
+        // models rounded up to one still fit. Terrain chunks stay far below it, the mesher falls back to indexed
+        // packed vertices for the rare chunk that doesn't
+        static constexpr uint32_t MAX_QUADS_PER_DRAW = 64 * 1024;
+
+        // indexCapacity is in 32 bit indices, twice as many 16 bit ones fit.
+        // extraVertexUsage lets the vertex buffer also be read as a storage buffer
+        EngineMeshHeap (EngineDevice &device, VkDeviceSize vertexStride, uint32_t vertexCapacity = DEFAULT_VERTEX_CAPACITY, uint32_t indexCapacity = DEFAULT_INDEX_CAPACITY,
+                        VkBufferUsageFlags extraVertexUsage = 0);
+
+        EngineMeshHeap (const EngineMeshHeap &) = delete;
+        EngineMeshHeap &operator= (const EngineMeshHeap &) = delete;
+
+        // Throws when either buffer has no free range large enough
+        MeshAllocation allocate (uint32_t vertexCount, uint32_t indexCount, VkIndexType indexType = VK_INDEX_TYPE_UINT32);
+        // The caller has to make sure no frame in flight still draws from the ranges
+        void free (MeshAllocation &allocation);
+
+        // For heaps of face records. Takes the whole index buffer for the same two triangles over four corners per quad,
+        // repeated MAX_QUADS_PER_DRAW times. Models allocate no indices of their own and all draw through this pattern
+        void writeQuadIndexPattern (EngineUploadManager &uploads);
+
+        // Only models allocated with indexType can be drawn until the next bind
+        void bind (VkCommandBuffer commandBuffer, VkIndexType indexType = VK_INDEX_TYPE_UINT32) const;
+
+        [[nodiscard]] VkBuffer getVertexBuffer () const { return vertexBuffer->getBuffer(); }
+        [[nodiscard]] VkBuffer getIndexBuffer () const { return indexBuffer->getBuffer(); }
+        [[nodiscard]] VkDeviceSize getVertexBufferOffset (uint32_t firstVertex) const;
+        [[nodiscard]] VkDeviceSize getIndexBufferOffset (uint32_t firstIndex, VkIndexType indexType = VK_INDEX_TYPE_UINT32) const;
+        [[nodiscard]] VkDeviceSize getVertexStride () const { return vertexStride; }
+        [[nodiscard]] VkDescriptorBufferInfo getVertexDescriptorInfo () const { return vertexBuffer->descriptorInfo(); }
+
+        [[nodiscard]] uint32_t getFreeVertices () const { return static_cast<uint32_t>(vertexRanges.getFreeBytes()); }
+        [[nodiscard]] VkDeviceSize getFreeIndexBytes () const { return indexRanges.getFreeBytes() * sizeof (uint16_t); }
+
+    private:
+        VkDeviceSize vertexStride;
+        std::unique_ptr<EngineBuffer> vertexBuffer;
+        std::unique_ptr<EngineBuffer> indexBuffer;
+
+        EngineRangeAllocator vertexRanges;
+        // In 16 bit units, a 32 bit index takes two aligned ones
+        EngineRangeAllocator indexRanges;
+    };
+
+} // engine
+
+#endif //VULKANENGINE_ENGINE_MESH_HEAP_HPP
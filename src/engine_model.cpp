@@ -18,7 +18,10 @@
 #include <FastNoise/FastNoise.h>
 
 //std
+#include <algorithm>
 #include <cassert>
+#include <numeric>
+#include <stdexcept>
 #include <unordered_map>
 
 namespace std {
@@ -26,7 +29,7 @@ namespace std {
     struct hash<engine::EngineModel::Vertex> {
         size_t operator()(engine::EngineModel::Vertex const &vertex) const {
             size_t seed = 0;
-            engine::hashCombine (seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
+            engine::hashCombine (seed, vertex.position, vertex.color, vertex.normal, vertex.uv, vertex.textureLayer);
             return seed;
         }
     };
@@ -49,91 +52,134 @@ namespace engine {
         attributeDescriptions.push_back ({1,0, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(Vertex, color))});
         attributeDescriptions.push_back ({2,0, VK_FORMAT_R32G32B32_SFLOAT, static_cast<uint32_t>(offsetof(Vertex, normal))});
         attributeDescriptions.push_back ({3,0, VK_FORMAT_R32G32_SFLOAT,    static_cast<uint32_t>(offsetof(Vertex, uv))});
+        attributeDescriptions.push_back ({4,0, VK_FORMAT_R32_UINT,         static_cast<uint32_t>(offsetof(Vertex, textureLayer))});
 
         return attributeDescriptions;
     }
 
-    EngineModel::EngineModel (EngineDevice &device, const Builder &builder): engineDevice {device} {
-        createVertexBuffer (builder.vertices);
-        createIndexBuffer (builder.indices);
+    std::vector<VkVertexInputBindingDescription> EngineModel::PackedVoxelVertex::getBindingDescriptions () {
+        auto bindingDescriptions = std::vector<VkVertexInputBindingDescription> (1);
+        bindingDescriptions[0].binding = 0;
+        bindingDescriptions[0].stride = sizeof (PackedVoxelVertex);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+        return bindingDescriptions;
     }
 
-    EngineModel::~EngineModel () = default;
+    std::vector<VkVertexInputAttributeDescription> EngineModel::PackedVoxelVertex::getAttributeDescriptions () {
+        auto attributeDescriptions = std::vector<VkVertexInputAttributeDescription> {};
 
-    void EngineModel::bind (VkCommandBuffer commandBuffer) {
-        VkBuffer buffers[] = {vertexBuffer->getBuffer()};
-        VkDeviceSize offsets[] = {0};
-        vkCmdBindVertexBuffers (commandBuffer, 0, 1, buffers, offsets);
+        attributeDescriptions.push_back ({0,0, VK_FORMAT_R32_UINT, static_cast<uint32_t>(offsetof(PackedVoxelVertex, position))});
+        attributeDescriptions.push_back ({1,0, VK_FORMAT_R32_UINT, static_cast<uint32_t>(offsetof(PackedVoxelVertex, attributes))});
 
-        if (hasIndexBuffer) {
-            vkCmdBindIndexBuffer (commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
-        }
+        return attributeDescriptions;
     }
 
-    void EngineModel::draw (VkCommandBuffer commandBuffer) {
-        if (hasIndexBuffer){
-            vkCmdDrawIndexed (commandBuffer, indexCount, 1, 0 ,0 ,0);
-        } else {
-            vkCmdDraw (commandBuffer, vertexCount, 1, 0, 0);
+    EngineModel::EngineModel (EngineDevice &device, const Builder &builder)
+            : EngineModel (device, static_cast<uint32_t>(builder.vertexCount()), requiredIndexCount (builder), builder.vertexFormat) {
+        update (builder);
 
-        }
+        // Usable as soon as it is constructed, only blocks on the transfer queue rather than the graphics queue
+        auto &uploads = engineDevice.getUploadManager();
+        uploads.wait (uploads.submit());
     }
 
-    void EngineModel::createVertexBuffer (const std::vector<Vertex> &vertices) {
-        vertexCount = static_cast<uint32_t>(vertices.size());
-        assert(vertexCount > 2 && "Vertex count must be at least 3");
-        VkDeviceSize bufferSize = sizeof (vertices[0]) * vertexCount;
-        uint32_t vertexSize = sizeof (vertices[0]);
-
-        EngineBuffer stagingBuffer {
-            engineDevice,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        };
-
-        stagingBuffer.map ();
-        stagingBuffer.writeToBuffer ((void*) vertices.data());
+    EngineModel::EngineModel (EngineDevice &device, uint32_t vertexCapacity, uint32_t indexCapacity, VertexFormat vertexFormat)
+            : engineDevice {device}, vertexFormat {vertexFormat}, vertexCapacity {vertexCapacity}, indexCapacity {indexCapacity} {
+        if (vertexFormat == VertexFormat::VoxelFaces) {
+            // A draw past the end of the quad pattern would read whatever indices follow it
+            if (vertexCapacity == 0 || vertexCapacity > EngineMeshHeap::MAX_QUADS_PER_DRAW) {
+                spdlog::get ("renderer")->critical ("Face model capacity {} is outside the shared quad pattern of {} quads", vertexCapacity, EngineMeshHeap::MAX_QUADS_PER_DRAW);
+                throw std::runtime_error ("Face model capacity outside the shared quad pattern!");
+            }
+            this->indexCapacity = vertexCapacity * 6;
+            meshAllocation = meshHeap().allocate (vertexCapacity, 0);
+            return;
+        }
+        assert(vertexCapacity > 2 && "Vertex capacity must be at least 3");
+        meshAllocation = meshHeap().allocate (vertexCapacity, indexCapacity, indexTypeFor (vertexFormat, vertexCapacity));
+    }
 
-        vertexBuffer = std::make_unique<EngineBuffer>(
-                engineDevice,
-                vertexSize,
-                vertexCount,
-                VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    EngineModel::~EngineModel () {
+        meshHeap().free (meshAllocation);
+    }
 
-        engineDevice.copyBuffer (stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+    void EngineModel::bind (VkCommandBuffer commandBuffer) {
+        meshHeap().bind (commandBuffer, meshAllocation.indexType);
     }
 
-    void EngineModel::createIndexBuffer (const std::vector<uint32_t> &indices) {
-        indexCount = static_cast<uint32_t>(indices.size());
-        hasIndexBuffer = indexCount > 0;
-        if (!hasIndexBuffer)
-            return;
+    void EngineModel::draw (VkCommandBuffer commandBuffer) {
+        vkCmdDrawIndexed (commandBuffer, indexCount, 1, meshAllocation.firstIndex, drawVertexOffset(), 0);
+    }
 
-        VkDeviceSize bufferSize = sizeof (indices[0]) * indexCount;
-        uint32_t indexSize = sizeof (indices[0]);
+    VkDrawIndexedIndirectCommand EngineModel::getDrawCommand (uint32_t firstInstance) const {
+        VkDrawIndexedIndirectCommand command{};
+        command.indexCount = indexCount;
+        command.instanceCount = 1;
+        command.firstIndex = meshAllocation.firstIndex;
+        command.vertexOffset = drawVertexOffset();
+        command.firstInstance = firstInstance;
+        return command;
+    }
 
-        EngineBuffer stagingBuffer {
-            engineDevice,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-        };
+    void EngineModel::update (const Builder &builder) {
+        assert(canFit (builder) && "Builder does not fit in the model ranges");
+        assert((builder.vertexCount() > 2 || (vertexFormat == VertexFormat::VoxelFaces && builder.vertexCount() > 0)) && "Vertex count must be at least 3");
+        auto &heap = meshHeap();
+        auto &uploads = engineDevice.getUploadManager();
+
+        vertexCount = static_cast<uint32_t>(builder.vertexCount());
+        boundsMin = builder.boundsMin;
+        boundsMax = builder.boundsMax;
+        const void *vertexData = nullptr;
+        switch (vertexFormat) {
+            case VertexFormat::PackedVoxel: vertexData = builder.packedVertices.data(); break;
+            case VertexFormat::VoxelFaces: vertexData = builder.faces.data(); break;
+            default: vertexData = builder.vertices.data(); break;
+        }
+        uploads.uploadToBuffer (vertexData, heap.getVertexStride() * vertexCount,
+                                heap.getVertexBuffer(), heap.getVertexBufferOffset (meshAllocation.firstVertex));
+
+        indexCount = requiredIndexCount (builder);
+        VkDeviceSize indexOffset = heap.getIndexBufferOffset (meshAllocation.firstIndex, meshAllocation.indexType);
+        if (vertexFormat == VertexFormat::VoxelFaces) {
+            // Nothing to upload, the heap's quad pattern is already in place
+        } else if (meshAllocation.indexType == VK_INDEX_TYPE_UINT16) {
+            // The capacity keeps every index below 65536, the narrowing is lossless
+            std::vector<uint16_t> indices(indexCount);
+            if (builder.indices.empty())
+                std::iota (indices.begin(), indices.end(), static_cast<uint16_t>(0));
+            else
+                std::transform (builder.indices.begin(), builder.indices.end(), indices.begin(), [] (uint32_t index) { return static_cast<uint16_t>(index); });
+            uploads.uploadToBuffer (indices.data(), sizeof (uint16_t) * indexCount, heap.getIndexBuffer(), indexOffset);
+        } else if (builder.indices.empty()) {
+            std::vector<uint32_t> indices(indexCount);
+            std::iota (indices.begin(), indices.end(), 0u);
+            uploads.uploadToBuffer (indices.data(), sizeof (uint32_t) * indexCount, heap.getIndexBuffer(), indexOffset);
+        } else {
+            uploads.uploadToBuffer (builder.indices.data(), sizeof (uint32_t) * indexCount, heap.getIndexBuffer(), indexOffset);
+        }
+    }
 
-        stagingBuffer.map ();
-        stagingBuffer.writeToBuffer ((void *) indices.data());
+    uint32_t EngineModel::requiredIndexCount (const Builder &builder) {
+        if (builder.vertexFormat == VertexFormat::VoxelFaces)
+            return static_cast<uint32_t>(builder.faces.size() * 6);
+        return static_cast<uint32_t>(builder.indices.empty() ? builder.vertexCount() : builder.indices.size());
+    }
 
-        indexBuffer = std::make_unique<EngineBuffer>(
-                engineDevice,
-                indexSize,
-                indexCount,
-                VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    EngineMeshHeap &EngineModel::meshHeap () const {
+        switch (vertexFormat) {
+            case VertexFormat::PackedVoxel: return engineDevice.getVoxelMeshHeap();
+            case VertexFormat::VoxelFaces: return engineDevice.getVoxelFaceHeap();
+            default: return engineDevice.getMeshHeap();
+        }
+    }
 
-        engineDevice.copyBuffer (stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);
+    int32_t EngineModel::drawVertexOffset () const {
+        // Four corners per face
+        if (vertexFormat == VertexFormat::VoxelFaces)
+            return static_cast<int32_t>(meshAllocation.firstVertex * 4);
+        return static_cast<int32_t>(meshAllocation.firstVertex);
     }
 
     std::unique_ptr<EngineModel> EngineModel::createModelFromFile (EngineDevice &device, const std::string &filepath) {
@@ -204,6 +250,8 @@ namespace engine {
                 indices.push_back (uniqueVerts[vertex]);
             }
         }
+
+        computeBounds();
     }
 
     void EngineModel::Builder::loadNoise (int sizeX, int sizeY) {
@@ -244,5 +292,6 @@ namespace engine {
             }
         }
 
+        computeBounds();
     }
 } // engine
\ No newline at end of file
@@ -7,36 +7,182 @@
 
 #include "engine_device.hpp"
 #include "engine_buffer.hpp"
+#include "engine_upload_manager.hpp"
+#include "engine_mesh_heap.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
 //std
+#include <cassert>
 #include <memory>
 
 namespace engine {
 
     class EngineModel {
     public:
+        // Picks the mesh heap, and with it the pipeline, a model is drawn with
+        enum class VertexFormat {
+            Standard,
+            PackedVoxel,
+            VoxelFaces
+        };
 
         struct Vertex {
             glm::vec3 position{};
             glm::vec3 color{};
             glm::vec3 normal{};
             glm::vec2 uv{};
+            // Layer of the object's texture array, ignored by objects without one
+            uint32_t textureLayer{0};
 
             static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
             static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
 
             bool operator==(const Vertex &other) const {
-                return position == other.position && color == other.color && normal == other.normal && uv == other.uv;
+                return position == other.position && color == other.color && normal == other.normal && uv == other.uv && textureLayer == other.textureLayer;
+            }
+        };
+
+        /**
+         * One corner of a voxel face in 8 bytes instead of the 44 of Vertex. Positions are chunk local block corners,
+         * the normal comes from the face index and the UV from the position, so none of them are stored as floats.
+         * Decoded by voxel_shader.vert.
+         */
+        struct PackedVoxelVertex {
+            static constexpr uint32_t MAX_COORDINATE = 63;
+            static constexpr uint32_t MAX_AMBIENT_OCCLUSION = 3;
+
+            // x, y and z in 6 bits each, the face (ChunkFace order) in 3 and the ambient occlusion level in 2
+            uint32_t position{0};
+            // Texture layer in the low 16 bits, RGB565 tint in the high 16
+            uint32_t attributes{0};
+
+            // Inline so the mesher benchmark can build meshes without linking the rest of the model code
+            static PackedVoxelVertex pack(const glm::uvec3 &corner, uint32_t face, uint32_t ambientOcclusion, uint32_t textureLayer, const glm::vec3 &color) {
+                assert(corner.x <= MAX_COORDINATE && corner.y <= MAX_COORDINATE && corner.z <= MAX_COORDINATE && "Corner out of range of the packed position");
+                assert(face < 6 && ambientOcclusion <= MAX_AMBIENT_OCCLUSION && textureLayer <= 0xFFFF && "Packed voxel attribute out of range");
+
+                auto r = static_cast<uint32_t>(glm::clamp(color.x, 0.0f, 1.0f) * 31.0f + 0.5f);
+                auto g = static_cast<uint32_t>(glm::clamp(color.y, 0.0f, 1.0f) * 63.0f + 0.5f);
+                auto b = static_cast<uint32_t>(glm::clamp(color.z, 0.0f, 1.0f) * 31.0f + 0.5f);
+
+                PackedVoxelVertex vertex{};
+                vertex.position = corner.x | (corner.y << 6) | (corner.z << 12) | (face << 18) | (ambientOcclusion << 21);
+                vertex.attributes = textureLayer | (((r << 11) | (g << 5) | b) << 16);
+                return vertex;
+            }
+            [[nodiscard]] glm::vec3 unpackPosition() const {
+                return {static_cast<float>(position & 63u), static_cast<float>((position >> 6) & 63u), static_cast<float>((position >> 12) & 63u)};
+            }
+
+            static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+            static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+        };
+        static_assert(sizeof(PackedVoxelVertex) == 8, "Packed voxel vertices are two words");
+
+        /**
+         * A whole greedy quad in the 8 bytes a single PackedVoxelVertex takes. There are no vertices, voxel_face.vert
+         * reads the record out of a storage buffer by gl_VertexIndex / 4 and builds the corner from gl_VertexIndex % 4.
+         * The index buffer is the heap's shared quad pattern, so a face mesh has no index data of its own.
+         */
+        struct PackedVoxelFace {
+            static constexpr uint32_t MAX_BLOCK = 31;
+            static constexpr uint32_t MAX_EXTENT = 32;
+
+            // Block x, y and z in 5 bits each, the face (ChunkFace order) in 3, then width - 1 and height - 1 in 5 each.
+            // Width runs along the first axis after the face axis, height along the second
+            uint32_t position{0};
+            // Texture layer in the low 16 bits, RGB565 tint in the high 16, same as PackedVoxelVertex
+            uint32_t attributes{0};
+
+            // Inline for the same reason as PackedVoxelVertex::pack
+            static PackedVoxelFace pack(const glm::uvec3 &block, uint32_t face, uint32_t width, uint32_t height, uint32_t textureLayer, const glm::vec3 &color) {
+                assert(block.x <= MAX_BLOCK && block.y <= MAX_BLOCK && block.z <= MAX_BLOCK && "Block out of range of the packed face");
+                assert(face < 6 && width >= 1 && width <= MAX_EXTENT && height >= 1 && height <= MAX_EXTENT && textureLayer <= 0xFFFF && "Packed face attribute out of range");
+
+                PackedVoxelFace packed{};
+                packed.position = block.x | (block.y << 5) | (block.z << 10) | (face << 15) | ((width - 1) << 18) | ((height - 1) << 23);
+                packed.attributes = PackedVoxelVertex::pack(glm::uvec3{0u}, 0, 0, textureLayer, color).attributes;
+                return packed;
+            }
+
+            // Chunk local corners of the quad, the same positions the shader produces
+            [[nodiscard]] glm::vec3 unpackMin() const {
+                uint32_t axis = face() / 2;
+                glm::vec3 corner{static_cast<float>(position & 31u), static_cast<float>((position >> 5) & 31u), static_cast<float>((position >> 10) & 31u)};
+                corner[static_cast<int>(axis)] += static_cast<float>(face() & 1u);
+                return corner;
             }
+            [[nodiscard]] glm::vec3 unpackMax() const {
+                uint32_t axis = face() / 2;
+                glm::vec3 corner = unpackMin();
+                corner[static_cast<int>((axis + 1) % 3)] += static_cast<float>(((position >> 18) & 31u) + 1);
+                corner[static_cast<int>((axis + 2) % 3)] += static_cast<float>(((position >> 23) & 31u) + 1);
+                return corner;
+            }
+            [[nodiscard]] uint32_t face() const { return (position >> 15) & 7u; }
         };
+        static_assert(sizeof(PackedVoxelFace) == 8, "Packed voxel faces are two words");
 
         struct Builder {
+            VertexFormat vertexFormat = VertexFormat::Standard;
+            // Only the list matching vertexFormat is used
             std::vector<Vertex> vertices{};
+            std::vector<PackedVoxelVertex> packedVertices{};
+            std::vector<PackedVoxelFace> faces{};
+            // Unused by VoxelFaces, every face draws through the shared quad pattern
             std::vector<uint32_t> indices{};
+            // Model space box around every vertex, both zero when there are none
+            glm::vec3 boundsMin{0.0f};
+            glm::vec3 boundsMax{0.0f};
+
+            // Elements of the heap's vertex buffer, for VoxelFaces that is one per face
+            size_t vertexCount() const {
+                switch (vertexFormat) {
+                    case VertexFormat::PackedVoxel: return packedVertices.size();
+                    case VertexFormat::VoxelFaces: return faces.size();
+                    default: return vertices.size();
+                }
+            }
+            // 16 bit whenever every vertex is reachable with one, the model converts the indices when it uploads them
+            VkIndexType indexType() const { return indexTypeFor (vertexFormat, vertexCount()); }
+            size_t triangleCount() const {
+                if (vertexFormat == VertexFormat::VoxelFaces)
+                    return faces.size() * 2;
+                return (indices.empty() ? vertexCount() : indices.size()) / 3;
+            }
+
+            // The loaders and the voxel mesher call this themselves, only needed after filling vertices by hand
+            void computeBounds() {
+                if (vertexCount() == 0) {
+                    boundsMin = boundsMax = glm::vec3{0.0f};
+                    return;
+                }
+                if (vertexFormat == VertexFormat::VoxelFaces) {
+                    boundsMin = faces[0].unpackMin();
+                    boundsMax = faces[0].unpackMax();
+                    for (const auto &face : faces) {
+                        boundsMin = glm::min(boundsMin, face.unpackMin());
+                        boundsMax = glm::max(boundsMax, face.unpackMax());
+                    }
+                    return;
+                }
+                if (vertexFormat == VertexFormat::PackedVoxel) {
+                    boundsMin = boundsMax = packedVertices[0].unpackPosition();
+                    for (const auto &vertex : packedVertices) {
+                        boundsMin = glm::min(boundsMin, vertex.unpackPosition());
+                        boundsMax = glm::max(boundsMax, vertex.unpackPosition());
+                    }
+                    return;
+                }
+                boundsMin = boundsMax = vertices[0].position;
+                for (const auto &vertex : vertices) {
+                    boundsMin = glm::min(boundsMin, vertex.position);
+                    boundsMax = glm::max(boundsMax, vertex.position);
+                }
+            }
 
             void loadModel(const std::string &filepath);
             void loadNoise(int sizeX, int sizeY);
@@ -44,6 +190,9 @@ namespace engine {
         };
 
         EngineModel (EngineDevice &device, const Builder &builder);
+        // Reserves empty space in the mesh heap to be filled later with update, lets models with short lifetimes be recycled.
+        // For VoxelFaces vertexCapacity counts faces and indexCapacity is ignored, no index space is reserved
+        EngineModel (EngineDevice &device, uint32_t vertexCapacity, uint32_t indexCapacity, VertexFormat vertexFormat = VertexFormat::Standard);
         virtual ~EngineModel ();
 
         EngineModel(const EngineModel &) = delete;
@@ -52,21 +201,57 @@ namespace engine {
         static std::unique_ptr<EngineModel> createModelFromFile (EngineDevice &device, const std::string &filepath);
         static std::unique_ptr<EngineModel> createModelFromNoise (EngineDevice &device, int xSize, int zSize);
 
+        // Binds the model's whole mesh heap, the draw picks this model's ranges out of it
         void bind(VkCommandBuffer commandBuffer);
         void draw(VkCommandBuffer commandBuffer);
+        // Same draw as an indirect command, firstInstance is handed to the shader as gl_InstanceIndex
+        VkDrawIndexedIndirectCommand getDrawCommand(uint32_t firstInstance) const;
+
+        // Replaces the model contents in place, the builder has to fit in the existing ranges.
+        // The copies are recorded into the device's open upload batch, don't draw the model until it completes
+        void update(const Builder &builder);
+        bool canFit(const Builder &builder) const {
+            return builder.vertexFormat == vertexFormat && builder.vertexCount() <= vertexCapacity && requiredIndexCount (builder) <= indexCapacity;
+        }
+
+        uint32_t getVertexCapacity() const { return vertexCapacity; }
+        uint32_t getIndexCapacity() const { return indexCapacity; }
+        uint32_t getIndexCount() const { return indexCount; }
+        VertexFormat getVertexFormat() const { return vertexFormat; }
+        VkIndexType getIndexType() const { return meshAllocation.indexType; }
+
+        // Face models always use the heap's 32 bit quad pattern, other models drop to 16 bit indices when their
+        // capacity allows it, so anything that fits a pooled model is always addressable by its indices
+        static VkIndexType indexTypeFor(VertexFormat vertexFormat, size_t vertexCapacity) {
+            return vertexFormat != VertexFormat::VoxelFaces && vertexCapacity <= MAX_SHORT_INDEX_VERTICES ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+        }
+
+        // Model space bounding box of the current contents, used for culling
+        const glm::vec3 &getBoundsMin() const { return boundsMin; }
+        const glm::vec3 &getBoundsMax() const { return boundsMax; }
 
     private:
-        void createVertexBuffer(const std::vector<Vertex> &vertices);
-        void createIndexBuffer(const std::vector<uint32_t> &indices);
+        // Primitive restart is off, so 0xFFFF is an ordinary index
+        static constexpr size_t MAX_SHORT_INDEX_VERTICES = 65536;
+
+        // The heap only draws indexed, builders without indices get a straight 0..n-1 list and faces six per face
+        static uint32_t requiredIndexCount(const Builder &builder);
+        EngineMeshHeap &meshHeap() const;
+        // Face models index the shared pattern from 0, the offset moves it to their first face's corners
+        int32_t drawVertexOffset() const;
 
         EngineDevice &engineDevice;
+        VertexFormat vertexFormat;
+        MeshAllocation meshAllocation{};
+
+        uint32_t vertexCount = 0;
+        uint32_t vertexCapacity = 0;
 
-        std::unique_ptr<EngineBuffer> vertexBuffer;
-        uint32_t vertexCount;
+        uint32_t indexCount = 0;
+        uint32_t indexCapacity = 0;
 
-        bool hasIndexBuffer = false;
-        std::unique_ptr<EngineBuffer> indexBuffer;
-        uint32_t indexCount;
+        glm::vec3 boundsMin{0.0f};
+        glm::vec3 boundsMax{0.0f};
     };
 
 } // engine
@@ -0,0 +1,69 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_ENGINE_MPSC_QUEUE_HPP
+#define VULKANENGINE_ENGINE_MPSC_QUEUE_HPP
+
+// std
+#include <atomic>
+#include <optional>
+#include <utility>
+
+namespace engine {
+
+    /**
+     * Lock free multiple producer, single consumer queue (Vyukov's intrusive node queue).
+     * Any thread may push, only one thread at a time may pop. Pushing never blocks, a pop that races
+     * with a push still in progress may report empty and pick the value up on the next call.
+     */
+    template<typename T>
+    class EngineMpscQueue {
+    public:
+        EngineMpscQueue () {
+            Node *stub = new Node{};
+            head.store (stub, std::memory_order_relaxed);
+            tail = stub;
+        }
+
+        ~EngineMpscQueue () {
+            T discard{};
+            while (tryPop (discard)) {}
+            delete tail;
+        }
+
+        EngineMpscQueue (const EngineMpscQueue &) = delete;
+        EngineMpscQueue &operator= (const EngineMpscQueue &) = delete;
+
+        void push (T value) {
+            Node *node = new Node{};
+            node->value.emplace (std::move (value));
+            Node *previous = head.exchange (node, std::memory_order_acq_rel);
+            previous->next.store (node, std::memory_order_release);
+        }
+
+        bool tryPop (T &out) {
+            Node *next = tail->next.load (std::memory_order_acquire);
+            if (next == nullptr)
+                return false;
+
+            out = std::move (*next->value);
+            next->value.reset();
+            delete tail;
+            tail = next;
+            return true;
+        }
+
+    private:
+        struct Node {
+            std::atomic<Node *> next{nullptr};
+            std::optional<T> value{};
+        };
+
+        std::atomic<Node *> head{};
+        Node *tail;     // only touched by the consumer
+    };
+
+} // engine
+
+#endif //VULKANENGINE_ENGINE_MPSC_QUEUE_HPP
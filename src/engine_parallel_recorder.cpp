@@ -0,0 +1,153 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "engine_parallel_recorder.hpp"
+#include "engine_swapchain.hpp"
+
+#include <spdlog/spdlog.h>
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace engine {
+
+    EngineParallelRecorder::EngineParallelRecorder (EngineDevice &device, EngineJobSystem &jobSystem) : engineDevice{device}, jobSystem{jobSystem} {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = device.graphicsQueueFamily();
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        framePools.resize (EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (auto &pools : framePools) {
+            pools.resize (getThreadCount());
+            for (auto &pool : pools) {
+                if (vkCreateCommandPool (device.device(), &poolInfo, nullptr, &pool.commandPool) != VK_SUCCESS) {
+                    spdlog::get ("vulkan")->critical ("Failed to create secondary command pool");
+                    throw std::runtime_error ("Failed to create secondary command pool!");
+                }
+            }
+        }
+    }
+
+    EngineParallelRecorder::~EngineParallelRecorder () {
+        for (auto &recording : recordings) {
+            jobSystem.wait (recording->job);
+        }
+        // Destroying a pool frees its command buffers
+        for (auto &pools : framePools) {
+            for (auto &pool : pools) {
+                vkDestroyCommandPool (engineDevice.device(), pool.commandPool, nullptr);
+            }
+        }
+    }
+
+    void EngineParallelRecorder::beginFrame (int frameIndex) {
+        assert(recordings.empty() && "Cannot begin a frame while a pass is still being recorded");
+
+        currentFrame = frameIndex;
+        for (auto &pool : framePools[frameIndex]) {
+            vkResetCommandPool (engineDevice.device(), pool.commandPool, 0);
+            pool.usedCount = 0;
+        }
+    }
+
+    void EngineParallelRecorder::beginPass (VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent) {
+        assert(recordings.empty() && "Cannot begin a pass while another is still being recorded");
+
+        inheritanceInfo = {};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = framebuffer;
+        passExtent = extent;
+    }
+
+    VkCommandBuffer EngineParallelRecorder::beginSecondary () {
+        auto &pool = framePools[currentFrame][jobSystem.getCurrentThreadIndex()];
+        if (pool.usedCount == pool.commandBuffers.size()) {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandPool = pool.commandPool;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer;
+            if (vkAllocateCommandBuffers (engineDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+                spdlog::get ("vulkan")->critical ("Failed to allocate secondary command buffer");
+                throw std::runtime_error ("Failed to allocate secondary command buffer!");
+            }
+            pool.commandBuffers.push_back (commandBuffer);
+        }
+        VkCommandBuffer commandBuffer = pool.commandBuffers[pool.usedCount++];
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        if (vkBeginCommandBuffer (commandBuffer, &beginInfo) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to begin recording secondary command buffer");
+            throw std::runtime_error ("Failed to begin recording secondary command buffer!");
+        }
+
+        // Dynamic state isn't inherited from the primary
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(passExtent.width);
+        viewport.height = static_cast<float>(passExtent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        VkRect2D scissor{{0, 0}, passExtent};
+        vkCmdSetViewport (commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor (commandBuffer, 0, 1, &scissor);
+        return commandBuffer;
+    }
+
+    void EngineParallelRecorder::record (const EngineFrameInfo &frameInfo, std::function<void (EngineFrameInfo &)> function) {
+        auto recording = std::make_unique<Recording>();
+        Recording *target = recording.get();
+
+        recording->job = jobSystem.schedule ([this, target, secondaryInfo = frameInfo, function = std::move (function)] () mutable {
+            try {
+                VkCommandBuffer commandBuffer = beginSecondary();
+                secondaryInfo.commandBuffer = commandBuffer;
+                function (secondaryInfo);
+
+                if (vkEndCommandBuffer (commandBuffer) != VK_SUCCESS) {
+                    spdlog::get ("vulkan")->critical ("Failed to record secondary command buffer");
+                    throw std::runtime_error ("Failed to record secondary command buffer!");
+                }
+                target->commandBuffer = commandBuffer;
+            } catch (...) {
+                target->error = std::current_exception();
+            }
+        }, JobPriority::High);
+
+        recordings.push_back (std::move (recording));
+    }
+
+    void EngineParallelRecorder::executePass (VkCommandBuffer primaryCommandBuffer) {
+        std::vector<VkCommandBuffer> commandBuffers{};
+        commandBuffers.reserve (recordings.size());
+
+        // The render thread records too while it waits, with its own pool
+        std::exception_ptr error{};
+        for (auto &recording : recordings) {
+            jobSystem.wait (recording->job);
+            if (recording->error && !error)
+                error = recording->error;
+            if (recording->commandBuffer != VK_NULL_HANDLE)
+                commandBuffers.push_back (recording->commandBuffer);
+        }
+        recordings.clear();
+
+        if (error)
+            std::rethrow_exception (error);
+        if (!commandBuffers.empty())
+            vkCmdExecuteCommands (primaryCommandBuffer, static_cast<uint32_t>(commandBuffers.size()), commandBuffers.data());
+    }
+
+} // engine
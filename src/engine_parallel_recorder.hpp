@@ -0,0 +1,80 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_ENGINE_PARALLEL_RECORDER_HPP
+#define VULKANENGINE_ENGINE_PARALLEL_RECORDER_HPP
+
+#include "engine_device.hpp"
+#include "engine_job_system.hpp"
+#include "engine_frame_info.hpp"
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * Records the contents of a render pass on the job system. Every recording gets its own secondary command buffer,
+     * allocated from a pool owned by whichever thread runs it, so nothing is locked while recording. Each frame in flight
+     * has its own set of pools, reset as a whole once that frame's fence has signalled. The primary command buffer then
+     * executes the secondaries in the order they were added.
+     */
+    class EngineParallelRecorder {
+    public:
+        EngineParallelRecorder (EngineDevice &device, EngineJobSystem &jobSystem);
+        ~EngineParallelRecorder ();
+
+        EngineParallelRecorder (const EngineParallelRecorder &) = delete;
+        EngineParallelRecorder &operator= (const EngineParallelRecorder &) = delete;
+
+        // Resets the pools of this frame slot, its fence has to have been waited on already
+        void beginFrame (int frameIndex);
+        // Starts collecting recordings for one render pass instance, they inherit its render pass and framebuffer
+        void beginPass (VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent);
+        // Runs function on a worker with frameInfo.commandBuffer swapped for a secondary command buffer that continues the
+        // pass, with viewport and scissor already set. Anything function touches must stay alive until executePass
+        void record (const EngineFrameInfo &frameInfo, std::function<void (EngineFrameInfo &)> function);
+        // Waits for every recording of the pass and executes them in order. The pass must have been begun with
+        // VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS on primaryCommandBuffer
+        void executePass (VkCommandBuffer primaryCommandBuffer);
+
+        // Threads that may record at once, the workers and the render thread
+        [[nodiscard]] uint32_t getThreadCount () const { return jobSystem.getWorkerCount() + 1; }
+
+    private:
+        struct ThreadPool {
+            VkCommandPool commandPool = VK_NULL_HANDLE;
+            std::vector<VkCommandBuffer> commandBuffers{};
+            uint32_t usedCount = 0;
+        };
+
+        struct Recording {
+            JobHandle job{};
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            std::exception_ptr error{};
+        };
+
+        VkCommandBuffer beginSecondary ();
+
+        EngineDevice &engineDevice;
+        EngineJobSystem &jobSystem;
+
+        // One pool per thread for every frame in flight
+        std::vector<std::vector<ThreadPool>> framePools{};
+        int currentFrame = 0;
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        VkExtent2D passExtent{};
+        // Filled in by the recording jobs, each only writes its own entry
+        std::vector<std::unique_ptr<Recording>> recordings{};
+    };
+
+} // engine
+
+#endif //VULKANENGINE_ENGINE_PARALLEL_RECORDER_HPP
@@ -10,8 +10,11 @@
 
 namespace engine {
 
-    EnginePipeline::EnginePipeline (EngineDevice &device, const std::string &vertexFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo) : engineDevice{device} {
-        createGraphicsPipeline (vertexFilepath, fragFilepath, configInfo);
+    EnginePipeline::EnginePipeline (EngineDevice &device, const std::string &vertexFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo)
+            : EnginePipeline (device, readFile (vertexFilepath), readFile (fragFilepath), configInfo) {}
+
+    EnginePipeline::EnginePipeline (EngineDevice &device, const std::vector<char> &vertCode, const std::vector<char> &fragCode, const PipelineConfigInfo &configInfo) : engineDevice{device} {
+        createGraphicsPipeline (vertCode, fragCode, configInfo);
     }
 
     EnginePipeline::~EnginePipeline () {
@@ -38,7 +41,7 @@ namespace engine {
         return buffer;
     }
 
-    void EnginePipeline::createGraphicsPipeline (const std::string &vertexFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo) {
+    void EnginePipeline::createGraphicsPipeline (const std::vector<char> &vertCode, const std::vector<char> &fragCode, const PipelineConfigInfo &configInfo) {
         assert(
                 configInfo.pipelineLayout != VK_NULL_HANDLE &&
                 "Cannot create graphics pipeline: no pipelineLayout provided in configInfo");
@@ -46,9 +49,6 @@ namespace engine {
                 configInfo.renderPass != VK_NULL_HANDLE &&
                 "Cannot create graphics pipeline: no renderPass provided in configInfo");
 
-        auto vertCode = readFile (vertexFilepath);
-        auto fragCode = readFile (fragFilepath);
-
         createShaderModule (vertCode, &vertShaderModule);
         createShaderModule (fragCode, &fragShaderModule);
 
@@ -98,7 +98,7 @@ namespace engine {
         pipelineInfo.basePipelineIndex = -1;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-        if (vkCreateGraphicsPipelines (engineDevice.device(), VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
+        if (vkCreateGraphicsPipelines (engineDevice.device(), engineDevice.getPipelineCache(), 1, &pipelineInfo, nullptr, &graphicsPipeline) != VK_SUCCESS) {
             spdlog::get("vulkan")->critical("Failed to create graphics pipeline");
             throw std::runtime_error ("Failed to create graphics pipeline");
         }
@@ -121,6 +121,47 @@ namespace engine {
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
     }
 
+    EngineComputePipeline::EngineComputePipeline (EngineDevice &device, const std::string &computeFilepath, VkPipelineLayout pipelineLayout)
+            : EngineComputePipeline (device, EnginePipeline::readFile (computeFilepath), pipelineLayout) {}
+
+    EngineComputePipeline::EngineComputePipeline (EngineDevice &device, const std::vector<char> &computeCode, VkPipelineLayout pipelineLayout) : engineDevice{device} {
+        assert(pipelineLayout != VK_NULL_HANDLE && "Cannot create compute pipeline: no pipelineLayout provided");
+
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = computeCode.size();
+        moduleInfo.pCode = reinterpret_cast<const uint32_t*>(computeCode.data());
+
+        if (vkCreateShaderModule (engineDevice.device(), &moduleInfo, nullptr, &computeShaderModule) != VK_SUCCESS) {
+            spdlog::get("vulkan")->critical("Failed to create shader module");
+            throw std::runtime_error("Failed to create shader module");
+        }
+
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = computeShaderModule;
+        pipelineInfo.stage.pName = "main";
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+        pipelineInfo.basePipelineIndex = -1;
+
+        if (vkCreateComputePipelines (engineDevice.device(), engineDevice.getPipelineCache(), 1, &pipelineInfo, nullptr, &computePipeline) != VK_SUCCESS) {
+            spdlog::get("vulkan")->critical("Failed to create compute pipeline");
+            throw std::runtime_error ("Failed to create compute pipeline");
+        }
+    }
+
+    EngineComputePipeline::~EngineComputePipeline () {
+        vkDestroyShaderModule (engineDevice.device(), computeShaderModule, nullptr);
+        vkDestroyPipeline (engineDevice.device(), computePipeline, nullptr);
+    }
+
+    void EngineComputePipeline::bind (VkCommandBuffer commandBuffer) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+    }
+
     void EnginePipeline::defaultPipelineConfigInfo (PipelineConfigInfo &configInfo) {
         configInfo.inputAssemblyInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
         configInfo.inputAssemblyInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
@@ -35,6 +35,8 @@ namespace engine {
     class EnginePipeline {
     public:
         EnginePipeline (EngineDevice &device, const std::string &vertexFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo);
+        // From SPIR-V already in memory, used by EnginePipelineBuilder which loads the files on other threads
+        EnginePipeline (EngineDevice &device, const std::vector<char> &vertCode, const std::vector<char> &fragCode, const PipelineConfigInfo &configInfo);
         ~EnginePipeline();
 
         EnginePipeline(const EnginePipeline &) = delete;
@@ -43,10 +45,11 @@ namespace engine {
         void bind(VkCommandBuffer commandBuffer);
         static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);
 
-    private:
         static std::vector<char> readFile(const std::string& filepath);
 
-        void createGraphicsPipeline (const std::string &vertexFilepath, const std::string &fragFilepath, const PipelineConfigInfo &configInfo);
+    private:
+
+        void createGraphicsPipeline (const std::vector<char> &vertCode, const std::vector<char> &fragCode, const PipelineConfigInfo &configInfo);
 
         void createShaderModule(const std::vector<char> &code, VkShaderModule *shaderModule);
 
@@ -55,6 +58,23 @@ namespace engine {
         VkShaderModule vertShaderModule;
         VkShaderModule fragShaderModule;
     };
+
+    class EngineComputePipeline {
+    public:
+        EngineComputePipeline (EngineDevice &device, const std::string &computeFilepath, VkPipelineLayout pipelineLayout);
+        EngineComputePipeline (EngineDevice &device, const std::vector<char> &computeCode, VkPipelineLayout pipelineLayout);
+        ~EngineComputePipeline();
+
+        EngineComputePipeline(const EngineComputePipeline &) = delete;
+        EngineComputePipeline &operator=(const EngineComputePipeline &) = delete;
+
+        void bind(VkCommandBuffer commandBuffer);
+
+    private:
+        EngineDevice &engineDevice;
+        VkPipeline computePipeline;
+        VkShaderModule computeShaderModule;
+    };
 }
 
 #endif //BASIC_TESTS_ENGINE_PIPELINE_HPP
@@ -0,0 +1,98 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "engine_pipeline_builder.hpp"
+
+#include <spdlog/spdlog.h>
+
+// std
+#include <chrono>
+
+namespace engine {
+
+    EnginePipelineBuilder::EnginePipelineBuilder (EngineDevice &device, EngineJobSystem &jobSystem) : engineDevice{device}, jobSystem{jobSystem} {}
+
+    EnginePipelineBuilder::~EnginePipelineBuilder () {
+        waitAll();
+    }
+
+    void EnginePipelineBuilder::waitAll () {
+        for (auto &job : pipelineJobs) {
+            jobSystem.wait (job);
+        }
+        pipelineJobs.clear();
+    }
+
+    const EnginePipelineBuilder::ShaderLoad &EnginePipelineBuilder::loadShader (const std::string &filepath) {
+        auto found = shaders.find (filepath);
+        if (found != shaders.end())
+            return found->second;
+
+        auto shader = std::make_shared<ShaderCode>();
+        // Shader reads go first, every pipeline job is waiting on them
+        auto job = jobSystem.schedule ([shader, filepath] {
+            try {
+                shader->code = EnginePipeline::readFile (filepath);
+            } catch (...) {
+                shader->error = std::current_exception();
+            }
+        }, JobPriority::High);
+
+        return shaders.emplace (filepath, ShaderLoad{std::move (job), std::move (shader)}).first->second;
+    }
+
+    EnginePendingPipeline<EnginePipeline> EnginePipelineBuilder::addGraphics (const std::string &vertexFilepath, const std::string &fragFilepath, std::unique_ptr<PipelineConfigInfo> configInfo) {
+        const auto &vertLoad = loadShader (vertexFilepath);
+        const auto &fragLoad = loadShader (fragFilepath);
+
+        using Pending = EnginePendingPipeline<EnginePipeline>;
+        auto state = std::make_shared<Pending::State>();
+
+        // std::function has to be copyable, so the config is shared rather than moved into the job
+        std::shared_ptr<PipelineConfigInfo> config{std::move (configInfo)};
+        state->job = jobSystem.schedule ([this, state, config, vert = vertLoad.shader, frag = fragLoad.shader, name = vertexFilepath] {
+            try {
+                if (vert->error)
+                    std::rethrow_exception (vert->error);
+                if (frag->error)
+                    std::rethrow_exception (frag->error);
+
+                auto start = std::chrono::high_resolution_clock::now();
+                state->pipeline = std::make_unique<EnginePipeline>(engineDevice, vert->code, frag->code, *config);
+                auto time = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - start).count();
+                spdlog::get ("vulkan")->debug ("Built graphics pipeline for {} in {:.2f} ms", name, time);
+            } catch (...) {
+                state->error = std::current_exception();
+            }
+        }, JobPriority::High, {vertLoad.job, fragLoad.job});
+
+        pipelineJobs.push_back (state->job);
+        return Pending{jobSystem, std::move (state)};
+    }
+
+    EnginePendingPipeline<EngineComputePipeline> EnginePipelineBuilder::addCompute (const std::string &computeFilepath, VkPipelineLayout pipelineLayout) {
+        const auto &computeLoad = loadShader (computeFilepath);
+
+        using Pending = EnginePendingPipeline<EngineComputePipeline>;
+        auto state = std::make_shared<Pending::State>();
+
+        state->job = jobSystem.schedule ([this, state, pipelineLayout, compute = computeLoad.shader, name = computeFilepath] {
+            try {
+                if (compute->error)
+                    std::rethrow_exception (compute->error);
+
+                auto start = std::chrono::high_resolution_clock::now();
+                state->pipeline = std::make_unique<EngineComputePipeline>(engineDevice, compute->code, pipelineLayout);
+                auto time = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::high_resolution_clock::now() - start).count();
+                spdlog::get ("vulkan")->debug ("Built compute pipeline for {} in {:.2f} ms", name, time);
+            } catch (...) {
+                state->error = std::current_exception();
+            }
+        }, JobPriority::High, {computeLoad.job});
+
+        pipelineJobs.push_back (state->job);
+        return Pending{jobSystem, std::move (state)};
+    }
+
+} // engine
@@ -0,0 +1,123 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_ENGINE_PIPELINE_BUILDER_HPP
+#define VULKANENGINE_ENGINE_PIPELINE_BUILDER_HPP
+
+#include "engine_device.hpp"
+#include "engine_job_system.hpp"
+#include "engine_pipeline.hpp"
+
+// std
+#include <cassert>
+#include <exception>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+
+    class EnginePipelineBuilder;
+
+    /**
+     * A pipeline that is still being built on the job system. get hands over the pipeline, waiting for it first if the
+     * job hasn't finished yet, so systems only stall the first time they actually bind it. Can only be taken once.
+     * A build that was never taken is waited for on destruction, it still uses the owner's pipeline layout.
+     */
+    template<typename T>
+    class EnginePendingPipeline {
+    public:
+        EnginePendingPipeline () = default;
+        ~EnginePendingPipeline () { waitForBuild(); }
+
+        EnginePendingPipeline (const EnginePendingPipeline &) = delete;
+        EnginePendingPipeline &operator= (const EnginePendingPipeline &) = delete;
+        EnginePendingPipeline (EnginePendingPipeline &&other) noexcept = default;
+        EnginePendingPipeline &operator= (EnginePendingPipeline &&other) noexcept {
+            if (this != &other) {
+                waitForBuild();
+                jobSystem = other.jobSystem;
+                state = std::move (other.state);
+            }
+            return *this;
+        }
+
+        [[nodiscard]] bool valid () const { return state != nullptr; }
+        [[nodiscard]] bool isReady () const { return state != nullptr && EngineJobSystem::isFinished (state->job); }
+
+        // Runs other queued jobs while waiting. Rethrows whatever the build threw
+        std::unique_ptr<T> get () {
+            assert(state != nullptr && "Pending pipeline was already taken or never scheduled");
+
+            jobSystem->wait (state->job);
+            auto finished = std::move (state);
+            if (finished->error)
+                std::rethrow_exception (finished->error);
+            return std::move (finished->pipeline);
+        }
+
+    private:
+        friend class EnginePipelineBuilder;
+
+        struct State {
+            JobHandle job{};
+            std::unique_ptr<T> pipeline{};
+            std::exception_ptr error{};
+        };
+
+        EnginePendingPipeline (EngineJobSystem &jobSystem, std::shared_ptr<State> state) : jobSystem{&jobSystem}, state{std::move (state)} {}
+
+        void waitForBuild () {
+            if (state != nullptr)
+                jobSystem->wait (state->job);
+        }
+
+        EngineJobSystem *jobSystem = nullptr;
+        std::shared_ptr<State> state{};
+    };
+
+    /**
+     * Builds pipelines on the job system. Every shader file is read once by its own job no matter how many pipelines use
+     * it, each pipeline then gets a job of its own that waits on its shaders and creates the modules and the pipeline
+     * against the device's shared pipeline cache. Only meant to be used from the render thread.
+     */
+    class EnginePipelineBuilder {
+    public:
+        EnginePipelineBuilder (EngineDevice &device, EngineJobSystem &jobSystem);
+        // Waits for every build still running, they reference the device
+        ~EnginePipelineBuilder ();
+
+        EnginePipelineBuilder (const EnginePipelineBuilder &) = delete;
+        EnginePipelineBuilder &operator= (const EnginePipelineBuilder &) = delete;
+
+        // The config is kept alive until the build finishes, its create infos point into itself so it can't be copied
+        EnginePendingPipeline<EnginePipeline> addGraphics (const std::string &vertexFilepath, const std::string &fragFilepath, std::unique_ptr<PipelineConfigInfo> configInfo);
+        EnginePendingPipeline<EngineComputePipeline> addCompute (const std::string &computeFilepath, VkPipelineLayout pipelineLayout);
+
+        void waitAll ();
+
+    private:
+        struct ShaderCode {
+            std::vector<char> code{};
+            std::exception_ptr error{};
+        };
+
+        struct ShaderLoad {
+            JobHandle job{};
+            std::shared_ptr<ShaderCode> shader{};
+        };
+
+        const ShaderLoad &loadShader (const std::string &filepath);
+
+        EngineDevice &engineDevice;
+        EngineJobSystem &jobSystem;
+
+        std::unordered_map<std::string, ShaderLoad> shaders{};
+        std::vector<JobHandle> pipelineJobs{};
+    };
+
+} // engine
+
+#endif //VULKANENGINE_ENGINE_PIPELINE_BUILDER_HPP
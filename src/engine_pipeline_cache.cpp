@@ -0,0 +1,104 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "engine_pipeline_cache.hpp"
+
+#include <spdlog/spdlog.h>
+
+// std
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace engine {
+
+    EnginePipelineCache::EnginePipelineCache (VkDevice device, const VkPhysicalDeviceProperties &properties)
+            : device{device}, properties{properties} {
+        filepath = fmt::format ("{}/pipeline_cache_{:04x}_{:04x}.bin", CACHE_DIRECTORY, properties.vendorID, properties.deviceID);
+
+        std::vector<uint8_t> data = loadFile();
+        if (!data.empty() && !isCompatible (data)) {
+            spdlog::get ("vulkan")->info ("Pipeline cache {} is from another device or driver, starting empty", filepath);
+            data.clear();
+        }
+
+        VkPipelineCacheCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        createInfo.initialDataSize = data.size();
+        createInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+        if (vkCreatePipelineCache (device, &createInfo, nullptr, &pipelineCache) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to create pipeline cache");
+            throw std::runtime_error ("Failed to create pipeline cache!");
+        }
+
+        if (!data.empty())
+            spdlog::get ("vulkan")->info ("Loaded pipeline cache {} ({} KB)", filepath, data.size() / 1024);
+    }
+
+    EnginePipelineCache::~EnginePipelineCache () {
+        save();
+        vkDestroyPipelineCache (device, pipelineCache, nullptr);
+    }
+
+    bool EnginePipelineCache::save () {
+        size_t size = 0;
+        if (vkGetPipelineCacheData (device, pipelineCache, &size, nullptr) != VK_SUCCESS || size == 0)
+            return false;
+
+        std::vector<uint8_t> data (size);
+        if (vkGetPipelineCacheData (device, pipelineCache, &size, data.data()) != VK_SUCCESS)
+            return false;
+
+        // Written next to the old file and renamed over it, a crash half way through never leaves a truncated cache behind
+        std::error_code error;
+        std::filesystem::create_directories (CACHE_DIRECTORY, error);
+        std::string tempFilepath = filepath + ".tmp";
+        {
+            std::ofstream file (tempFilepath, std::ios::binary | std::ios::trunc);
+            if (!file || !file.write (reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(size))) {
+                spdlog::get ("vulkan")->warn ("Failed to write pipeline cache {}", tempFilepath);
+                return false;
+            }
+        }
+
+        std::filesystem::rename (tempFilepath, filepath, error);
+        if (error) {
+            spdlog::get ("vulkan")->warn ("Failed to replace pipeline cache {}: {}", filepath, error.message());
+            return false;
+        }
+
+        spdlog::get ("vulkan")->info ("Saved pipeline cache {} ({} KB)", filepath, size / 1024);
+        return true;
+    }
+
+    std::vector<uint8_t> EnginePipelineCache::loadFile () const {
+        std::ifstream file (filepath, std::ios::binary | std::ios::ate);
+        if (!file)
+            return {};
+
+        auto size = static_cast<size_t>(file.tellg());
+        std::vector<uint8_t> data (size);
+        file.seekg (0);
+        if (!file.read (reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(size)))
+            return {};
+        return data;
+    }
+
+    // The driver checks this too, but some are known to crash on caches from other hardware rather than reject them
+    bool EnginePipelineCache::isCompatible (const std::vector<uint8_t> &data) const {
+        VkPipelineCacheHeaderVersionOne header{};
+        if (data.size() < sizeof (header))
+            return false;
+
+        std::memcpy (&header, data.data(), sizeof (header));
+        return header.headerSize >= sizeof (header)
+               && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+               && header.vendorID == properties.vendorID
+               && header.deviceID == properties.deviceID
+               && std::memcmp (header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+} // engine
@@ -0,0 +1,48 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_ENGINE_PIPELINE_CACHE_HPP
+#define VULKANENGINE_ENGINE_PIPELINE_CACHE_HPP
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * VkPipelineCache shared by every pipeline the device creates, loaded from disk when the device starts and written
+     * back when it is destroyed. One file per vendor and device ID. Data whose header doesn't match this device's vendor,
+     * device and pipeline cache UUID (a different GPU or driver) is thrown away and the cache starts out empty.
+     */
+    class EnginePipelineCache {
+    public:
+        static constexpr const char *CACHE_DIRECTORY = "cache";
+
+        EnginePipelineCache (VkDevice device, const VkPhysicalDeviceProperties &properties);
+        // Saves the cache before destroying it
+        ~EnginePipelineCache ();
+
+        EnginePipelineCache (const EnginePipelineCache &) = delete;
+        EnginePipelineCache &operator= (const EnginePipelineCache &) = delete;
+
+        [[nodiscard]] VkPipelineCache getCache () const { return pipelineCache; }
+        bool save ();
+
+    private:
+        std::vector<uint8_t> loadFile () const;
+        bool isCompatible (const std::vector<uint8_t> &data) const;
+
+        VkDevice device;
+        VkPhysicalDeviceProperties properties;
+        std::string filepath;
+        VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+    };
+
+} // engine
+
+#endif //VULKANENGINE_ENGINE_PIPELINE_CACHE_HPP
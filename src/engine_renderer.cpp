@@ -9,34 +9,52 @@
 namespace engine {
     EngineRenderer::EngineRenderer (EngineWindow &window, EngineDevice &device): engineWindow{window}, engineDevice{device} {
         recreateSwapChain();
-        createCommandBuffers();
+        createFrameCommandPools();
+        for (int i = 0; i < EngineSwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+            frameDescriptorAllocators.push_back (EngineDescriptorAllocator::Builder(engineDevice).build());
+        }
+        gpuProfiler = std::make_unique<EngineGpuProfiler>(engineDevice);
     }
 
     EngineRenderer::~EngineRenderer () {
-        freeCommandBuffers();
+        destroyFrameCommandPools();
     }
 
-    void EngineRenderer::createCommandBuffers () {
+    void EngineRenderer::createFrameCommandPools () {
+        frameCommandPools.resize (EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
         commandBuffers.resize (EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
 
-        VkCommandBufferAllocateInfo allocInfo {};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = engineDevice.getCommandPool();
-        allocInfo.commandBufferCount = static_cast<uint32_t> (commandBuffers.size());
+        // Buffers are never reset one at a time, the whole pool is reset when its frame slot comes around again
+        VkCommandPoolCreateInfo poolInfo {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = engineDevice.graphicsQueueFamily();
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+        for (size_t i = 0; i < frameCommandPools.size(); i++) {
+            if (vkCreateCommandPool (engineDevice.device(), &poolInfo, nullptr, &frameCommandPools[i]) != VK_SUCCESS) {
+                spdlog::get ("vulkan")->critical ("Failed to create frame command pool");
+                throw std::runtime_error("Failed to create frame command pool");
+            }
 
-        if (vkAllocateCommandBuffers (engineDevice.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS) {
-            spdlog::get ("vulkan")->critical ("Failed to allocate command buffers");
-            throw std::runtime_error("Failed to allocate command buffers");
+            VkCommandBufferAllocateInfo allocInfo {};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = frameCommandPools[i];
+            allocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers (engineDevice.device(), &allocInfo, &commandBuffers[i]) != VK_SUCCESS) {
+                spdlog::get ("vulkan")->critical ("Failed to allocate command buffers");
+                throw std::runtime_error("Failed to allocate command buffers");
+            }
         }
     }
 
-    void EngineRenderer::freeCommandBuffers() {
-        vkFreeCommandBuffers(
-                engineDevice.device(),
-                engineDevice.getCommandPool(),
-                static_cast<uint32_t>(commandBuffers.size()),
-                commandBuffers.data());
+    void EngineRenderer::destroyFrameCommandPools() {
+        // Destroying a pool frees its command buffers
+        for (auto pool : frameCommandPools) {
+            vkDestroyCommandPool (engineDevice.device(), pool, nullptr);
+        }
+        frameCommandPools.clear();
         commandBuffers.clear();
     }
 
@@ -61,6 +79,10 @@ namespace engine {
                 throw std::runtime_error ("Swap chain image (or depth) format has changed!");
             }
         }
+
+        // Sized from the new depth images, starts out unbuilt so the first frame after a resize skips occlusion
+        depthPyramid.reset();
+        depthPyramid = std::make_unique<EngineDepthPyramid>(engineDevice, engineSwapChain->getSwapChainExtent(), engineSwapChain->getDepthImageViews());
         spdlog::get ("vulkan")->trace ("Finished: RecreateSwapChain");
     }
 
@@ -81,27 +103,40 @@ namespace engine {
 
         isFrameStarted = true;
 
+        // acquireNextImage waited on this frame slot's fence, nothing recorded from its pool is still in use
+        if (vkResetCommandPool (engineDevice.device(), frameCommandPools[currentFrameIndex], 0) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to reset frame command pool");
+            throw std::runtime_error ("Failed to reset frame command pool");
+        }
+        frameDescriptorAllocators[currentFrameIndex]->resetPools();
+
         auto commandBuffer = getCurrentCommandBuffer();
         VkCommandBufferBeginInfo beginInfo {};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
         if (vkBeginCommandBuffer (commandBuffer, &beginInfo) != VK_SUCCESS) {
             spdlog::critical ("Failed to begin recording command buffer");
             throw std::runtime_error ("Failed to begin recording command buffer");
         }
+        // This frame slot's fence was waited on in acquireNextImage, its old timestamps are ready to read
+        gpuProfiler->beginFrame (commandBuffer, currentFrameIndex);
         return commandBuffer;
     }
 
     void EngineRenderer::endFrame () {
         assert(isFrameStarted && "Can't call endFrame when frame is not in progress");
         auto commandBuffer = getCurrentCommandBuffer();
+        gpuProfiler->endFrame (commandBuffer);
 
         if (vkEndCommandBuffer (commandBuffer) != VK_SUCCESS) {
             spdlog::get ("renderer")->critical ("Failed to record command buffer");
             throw std::runtime_error("Failed to record command buffer!");
         }
 
-        auto result = engineSwapChain->submitCommandBuffers (&commandBuffer, &currentImageIndex);
+        lastImageIndex = currentImageIndex;
+        auto result = engineSwapChain->submitCommandBuffers (&commandBuffer, &currentImageIndex, uploadSemaphore, uploadWaitValue);
+        uploadSemaphore = VK_NULL_HANDLE;
         if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || engineWindow.wasWindowResized()) {
             engineWindow.resetWindowResizedFlag();
             recreateSwapChain();
@@ -113,7 +148,13 @@ namespace engine {
         currentFrameIndex = (currentFrameIndex + 1) % EngineSwapChain::MAX_FRAMES_IN_FLIGHT;
     }
 
-    void EngineRenderer::beginSwapChainRenderPass (VkCommandBuffer commandBuffer) {
+    void EngineRenderer::waitForUploads (VkSemaphore semaphore, uint64_t value) {
+        assert(isFrameStarted && "Can't call waitForUploads when frame is not in progress");
+        uploadSemaphore = semaphore;
+        uploadWaitValue = value;
+    }
+
+    void EngineRenderer::beginSwapChainRenderPass (VkCommandBuffer commandBuffer, VkSubpassContents contents) {
         assert(isFrameStarted && "Can't call beginSwapChainRenderPass when frame is not in progress");
         assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on a command buffer from a different frame");
 
@@ -131,7 +172,10 @@ namespace engine {
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues =  clearValues.data();
 
-        vkCmdBeginRenderPass (commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        renderPassScope = gpuProfiler->beginScope (commandBuffer, "main_pass");
+        vkCmdBeginRenderPass (commandBuffer, &renderPassInfo, contents);
+        if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+            return;
 
         VkViewport viewport{};
         viewport.x = 0.0f;
@@ -150,6 +194,22 @@ namespace engine {
         assert(commandBuffer == getCurrentCommandBuffer() && "Can't end render pass on a command buffer from a different frame");
 
         vkCmdEndRenderPass (commandBuffer);
+        gpuProfiler->endScope (commandBuffer, renderPassScope);
+    }
+
+    void EngineRenderer::buildDepthPyramid (VkCommandBuffer commandBuffer) {
+        assert(isFrameStarted && "Can't call buildDepthPyramid when frame is not in progress");
+        assert(commandBuffer == getCurrentCommandBuffer() && "Can't build depth pyramid on a command buffer from a different frame");
+
+        EngineGpuProfiler::Scope scope{*gpuProfiler, commandBuffer, "depth_pyramid"};
+        depthPyramid->build (commandBuffer, currentImageIndex);
+    }
+
+    bool EngineRenderer::saveFrame (const std::string &filepath) {
+        assert(!isFrameStarted && "Can't call saveFrame while a frame is in progress");
+        assert(engineDevice.isHeadless() && "Only headless frames can be saved");
+
+        return engineSwapChain->saveImage (lastImageIndex, filepath);
     }
 
 } // engine
\ No newline at end of file
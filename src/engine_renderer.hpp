@@ -8,11 +8,15 @@
 #include "engine_window.hpp"
 #include "engine_device.hpp"
 #include "engine_swapchain.hpp"
+#include "engine_depth_pyramid.hpp"
+#include "engine_gpu_profiler.hpp"
+#include "engine_descriptors.hpp"
 
 // std
 #include <cassert>
 #include <memory>
 #include <chrono>
+#include <string>
 
 namespace engine {
     class EngineRenderer {
@@ -25,6 +29,11 @@ namespace engine {
 
         VkRenderPass getSwapchainRenderpass() const { return engineSwapChain->getRenderPass(); }
         float getAspectRatio() const { return engineSwapChain->extentAspectRatio(); }
+        VkExtent2D getSwapchainExtent() const { return engineSwapChain->getSwapChainExtent(); }
+        VkFramebuffer getCurrentFramebuffer() const {
+            assert(isFrameStarted && "Cannot get framebuffer when frame not in progress");
+            return engineSwapChain->getFrameBuffer(currentImageIndex);
+        }
         bool isFrameInProgress() const { return isFrameStarted; }
 
         VkCommandBuffer getCurrentCommandBuffer() const {
@@ -37,22 +46,49 @@ namespace engine {
             return currentFrameIndex;
         }
 
+        // Sets allocated from it are freed when this frame slot comes around again
+        EngineDescriptorAllocator &getFrameDescriptorAllocator() const {
+            assert(isFrameStarted && "Cannot get frame descriptor allocator when frame not in progress");
+            return *frameDescriptorAllocators[currentFrameIndex];
+        }
+
         VkCommandBuffer beginFrame();
         void endFrame();
-        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // The frame being recorded won't read vertex or shader data on the GPU until the timeline semaphore reaches value
+        void waitForUploads(VkSemaphore semaphore, uint64_t value);
+        // With VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the pass may only execute secondaries, which set their own viewport
+        void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
+        // Reduces this frame's depth into the pyramid for the next frame's occlusion culling, call after the render pass
+        void buildDepthPyramid(VkCommandBuffer commandBuffer);
+        EngineDepthPyramid &getDepthPyramid() const { return *depthPyramid; }
+        // Already inside a "frame" scope between beginFrame and endFrame, the swap chain render pass is its own scope
+        EngineGpuProfiler &getGpuProfiler() const { return *gpuProfiler; }
+        // Writes the last submitted frame to a PNG, stalls until the GPU has finished it. Headless only
+        bool saveFrame(const std::string &filepath);
 
     private:
-        void createCommandBuffers();
-        void freeCommandBuffers();
+        void createFrameCommandPools();
+        void destroyFrameCommandPools();
         void recreateSwapChain();
 
         EngineWindow& engineWindow;
         EngineDevice& engineDevice;
         std::unique_ptr<EngineSwapChain> engineSwapChain;
+        std::unique_ptr<EngineDepthPyramid> depthPyramid;
+        std::unique_ptr<EngineGpuProfiler> gpuProfiler;
+        uint32_t renderPassScope{EngineGpuProfiler::INVALID_SCOPE};
+        // One pool per frame in flight, reset as a whole once that frame's fence has signalled
+        std::vector<VkCommandPool> frameCommandPools;
         std::vector<VkCommandBuffer> commandBuffers;
+        // Reset with the command pool of the same frame slot, sets from them only last for the frame they were made in
+        std::vector<std::unique_ptr<EngineDescriptorAllocator>> frameDescriptorAllocators;
+
+        VkSemaphore uploadSemaphore{VK_NULL_HANDLE};
+        uint64_t uploadWaitValue{0};
 
         uint32_t currentImageIndex{0};
+        uint32_t lastImageIndex{0};
         int currentFrameIndex{0};
         bool isFrameStarted{false};
     };
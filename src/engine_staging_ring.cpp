@@ -0,0 +1,47 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "engine_staging_ring.hpp"
+
+// std
+#include <cassert>
+
+namespace engine {
+
+    EngineStagingRing::EngineStagingRing (EngineDevice &device, VkDeviceSize partitionSize, uint32_t partitionCount)
+            : partitionSize{partitionSize}, releaseValues(partitionCount, 0) {
+        assert(partitionCount > 0 && "Staging ring needs at least one partition");
+        buffer = std::make_unique<EngineBuffer>(
+                device,
+                partitionSize,
+                partitionCount,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        buffer->map();
+    }
+
+    bool EngineStagingRing::allocate (VkDeviceSize size, VkDeviceSize alignment, StagingAllocation &allocation) {
+        VkDeviceSize offset = (head + alignment - 1) / alignment * alignment;
+        if (offset + size > partitionSize)
+            return false;
+
+        head = offset + size;
+
+        VkDeviceSize bufferOffset = currentPartition * partitionSize + offset;
+        allocation.buffer = buffer->getBuffer();
+        allocation.offset = buffer->getBufferOffset() + bufferOffset;
+        allocation.mapped = static_cast<char *>(buffer->getMappedMemory()) + bufferOffset;
+        return true;
+    }
+
+    uint64_t EngineStagingRing::advance (uint64_t releaseValue) {
+        if (head > 0)
+            releaseValues[currentPartition] = releaseValue;
+
+        currentPartition = (currentPartition + 1) % static_cast<uint32_t>(releaseValues.size());
+        head = 0;
+        return releaseValues[currentPartition];
+    }
+
+} // engine
@@ -0,0 +1,55 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_ENGINE_STAGING_RING_HPP
+#define VULKANENGINE_ENGINE_STAGING_RING_HPP
+
+#include "engine_device.hpp"
+#include "engine_buffer.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace engine {
+
+    struct StagingAllocation {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        void *mapped = nullptr;
+    };
+
+    /**
+     * One persistently mapped host visible buffer split into equal partitions, one per frame in flight.
+     * Allocations bump a pointer through the current partition and are never freed individually,
+     * the whole partition is reused once the upload value it was tagged with has completed.
+     */
+    class EngineStagingRing {
+    public:
+        EngineStagingRing (EngineDevice &device, VkDeviceSize partitionSize, uint32_t partitionCount);
+
+        EngineStagingRing (const EngineStagingRing &) = delete;
+        EngineStagingRing &operator= (const EngineStagingRing &) = delete;
+
+        // Returns false when the request does not fit in what is left of the current partition
+        bool allocate (VkDeviceSize size, VkDeviceSize alignment, StagingAllocation &allocation);
+
+        // Tags the current partition with the upload value that last reads from it and moves on to the next one.
+        // Returns the value that has to complete before the new partition can be written to
+        uint64_t advance (uint64_t releaseValue);
+
+        [[nodiscard]] VkDeviceSize getPartitionSize () const { return partitionSize; }
+        [[nodiscard]] VkDeviceSize getPartitionUsed () const { return head; }
+
+    private:
+        VkDeviceSize partitionSize;
+        uint32_t currentPartition = 0;
+        VkDeviceSize head = 0;
+        std::vector<uint64_t> releaseValues;
+        std::unique_ptr<EngineBuffer> buffer;
+    };
+
+} // engine
+
+#endif //VULKANENGINE_ENGINE_STAGING_RING_HPP
@@ -3,10 +3,15 @@
 //
 
 #include "engine_swapchain.hpp"
+#include "engine_buffer.hpp"
 #include <spdlog/spdlog.h>
 
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
 // std
 #include <array>
+#include <cassert>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -16,18 +21,23 @@
 
 namespace engine {
 
-    EngineSwapChain::EngineSwapChain(EngineDevice &deviceRef, VkExtent2D extent) : device{deviceRef}, windowExtent{extent} {
+    EngineSwapChain::EngineSwapChain(EngineDevice &deviceRef, VkExtent2D extent)
+            : device{deviceRef}, windowExtent{extent}, headless{deviceRef.isHeadless()} {
         init();
     }
 
     EngineSwapChain::EngineSwapChain(EngineDevice &deviceRef, VkExtent2D extent, std::shared_ptr<EngineSwapChain> previous)
-            : device{deviceRef}, windowExtent{extent}, oldSwapChain{previous} {
+            : device{deviceRef}, windowExtent{extent}, headless{deviceRef.isHeadless()}, oldSwapChain{previous} {
         init();
         oldSwapChain = nullptr;
     }
 
     void EngineSwapChain::init() {
-        createSwapChain();
+        if (headless) {
+            createOffscreenImages();
+        } else {
+            createSwapChain();
+        }
         createImageViews();
         createRenderPass();
         createDepthResources();
@@ -41,6 +51,10 @@ namespace engine {
         }
         swapChainImageViews.clear();
 
+        for (size_t i = 0; i < offscreenImageAllocations.size(); i++) {
+            device.destroyImage(swapChainImages[i], offscreenImageAllocations[i]);
+        }
+
         if (swapChain != nullptr) {
             vkDestroySwapchainKHR(device.device(), swapChain, nullptr);
             swapChain = nullptr;
@@ -48,8 +62,7 @@ namespace engine {
 
         for (int i = 0; i < depthImages.size(); i++) {
             vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-            vkDestroyImage(device.device(), depthImages[i], nullptr);
-            vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+            device.destroyImage(depthImages[i], depthImageAllocations[i]);
         }
 
         for (auto framebuffer : swapChainFramebuffers) {
@@ -74,6 +87,12 @@ namespace engine {
                 VK_TRUE,
                 std::numeric_limits<uint64_t>::max());
 
+        if (headless) {
+            *imageIndex = nextOffscreenImage;
+            nextOffscreenImage = (nextOffscreenImage + 1) % static_cast<uint32_t>(swapChainImages.size());
+            return VK_SUCCESS;
+        }
+
         VkResult result = vkAcquireNextImageKHR(
                 device.device(),
                 swapChain,
@@ -86,7 +105,7 @@ namespace engine {
     }
 
     VkResult EngineSwapChain::submitCommandBuffers(
-            const VkCommandBuffer *buffers, uint32_t *imageIndex) {
+            const VkCommandBuffer *buffers, uint32_t *imageIndex, VkSemaphore uploadSemaphore, uint64_t uploadValue) {
         if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
             vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
         }
@@ -95,17 +114,31 @@ namespace engine {
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-        VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
-        VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-        submitInfo.waitSemaphoreCount = 1;
-        submitInfo.pWaitSemaphores = waitSemaphores;
-        submitInfo.pWaitDstStageMask = waitStages;
+        // Offscreen images are never acquired, so there is no image available semaphore to wait on
+        uint32_t firstWait = headless ? 1 : 0;
+        VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame], uploadSemaphore};
+        VkPipelineStageFlags waitStages[] = {
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT};
+        submitInfo.waitSemaphoreCount = (uploadSemaphore != VK_NULL_HANDLE ? 2 : 1) - firstWait;
+        submitInfo.pWaitSemaphores = waitSemaphores + firstWait;
+        submitInfo.pWaitDstStageMask = waitStages + firstWait;
+
+        // Values for binary semaphores are ignored
+        uint64_t waitValues[] = {0, uploadValue};
+        VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.waitSemaphoreValueCount = submitInfo.waitSemaphoreCount;
+        timelineInfo.pWaitSemaphoreValues = waitValues + firstWait;
+        if (uploadSemaphore != VK_NULL_HANDLE) {
+            submitInfo.pNext = &timelineInfo;
+        }
 
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = buffers;
 
         VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.signalSemaphoreCount = headless ? 0 : 1;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
         vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
@@ -115,6 +148,11 @@ namespace engine {
             throw std::runtime_error("Failed to submit draw command buffer!");
         }
 
+        if (headless) {
+            currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+            return VK_SUCCESS;
+        }
+
         VkPresentInfoKHR presentInfo = {};
         presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -196,6 +234,105 @@ namespace engine {
         swapChainExtent = extent;
     }
 
+    void EngineSwapChain::createOffscreenImages() {
+        swapChainImageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+        swapChainExtent = windowExtent;
+
+        // Nothing holds on to the images the way a presentation engine does, one per frame in flight is enough
+        swapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+        offscreenImageAllocations.resize(MAX_FRAMES_IN_FLIGHT);
+        for (size_t i = 0; i < swapChainImages.size(); i++) {
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.extent.width = swapChainExtent.width;
+            imageInfo.extent.height = swapChainExtent.height;
+            imageInfo.extent.depth = 1;
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.format = swapChainImageFormat;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+            device.createImageWithInfo(
+                    imageInfo,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                    swapChainImages[i],
+                    offscreenImageAllocations[i]);
+        }
+        spdlog::info ("Offscreen images: {} at {}x{}", swapChainImages.size(), swapChainExtent.width, swapChainExtent.height);
+    }
+
+    bool EngineSwapChain::saveImage(uint32_t imageIndex, const std::string &filepath) {
+        assert(headless && "Only offscreen images can be saved");
+
+        uint32_t pixelCount = swapChainExtent.width * swapChainExtent.height;
+        EngineBuffer readbackBuffer{
+                device,
+                4,
+                pixelCount,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT};
+
+        VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+
+        // Already in TRANSFER_SRC_OPTIMAL from the render pass, this only waits for and makes visible the color writes
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = swapChainImages[imageIndex];
+        barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+        barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = readbackBuffer.getBufferOffset();
+        region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+        region.imageExtent = {swapChainExtent.width, swapChainExtent.height, 1};
+        vkCmdCopyImageToBuffer(commandBuffer,
+                               swapChainImages[imageIndex],
+                               VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                               readbackBuffer.getBuffer(),
+                               1,
+                               &region);
+
+        VkMemoryBarrier hostBarrier{};
+        hostBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        hostBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        hostBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_HOST_BIT,
+                             0, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+
+        device.endSingleTimeCommands(commandBuffer);
+
+        readbackBuffer.map();
+        readbackBuffer.invalidate();
+        int written = stbi_write_png(
+                filepath.c_str(),
+                static_cast<int>(swapChainExtent.width),
+                static_cast<int>(swapChainExtent.height),
+                4,
+                readbackBuffer.getMappedMemory(),
+                static_cast<int>(swapChainExtent.width * 4));
+        if (written == 0) {
+            spdlog::get ("renderer")->error ("Failed to write frame to {}", filepath);
+            return false;
+        }
+        return true;
+    }
+
     void EngineSwapChain::createImageViews() {
         swapChainImageViews.resize(swapChainImages.size());
         for (size_t i = 0; i < swapChainImages.size(); i++) {
@@ -223,11 +360,12 @@ namespace engine {
         depthAttachment.format = findDepthFormat();
         depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
         depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        // Kept and left readable so the depth pyramid can be built from it after the pass
+        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
         depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 
         VkAttachmentReference depthAttachmentRef{};
         depthAttachmentRef.attachment = 1;
@@ -241,7 +379,8 @@ namespace engine {
         colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        // Offscreen images are only ever read back
+        colorAttachment.finalLayout = headless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
         VkAttachmentReference colorAttachmentRef = {};
         colorAttachmentRef.attachment = 0;
@@ -253,17 +392,27 @@ namespace engine {
         subpass.pColorAttachments = &colorAttachmentRef;
         subpass.pDepthStencilAttachment = &depthAttachmentRef;
 
+        // Compute is in the source stages because the last frame's depth pyramid build reads the depth image
         VkSubpassDependency dependency = {};
         dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
         dependency.srcAccessMask = 0;
         dependency.srcStageMask =
-                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+                VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
         dependency.dstSubpass = 0;
         dependency.dstStageMask =
                 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
         dependency.dstAccessMask =
                 VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
+        VkSubpassDependency depthReadDependency = {};
+        depthReadDependency.srcSubpass = 0;
+        depthReadDependency.srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+        depthReadDependency.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        depthReadDependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+        depthReadDependency.dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        depthReadDependency.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        std::array<VkSubpassDependency, 2> dependencies = {dependency, depthReadDependency};
         std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
         VkRenderPassCreateInfo renderPassInfo = {};
         renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -271,8 +420,8 @@ namespace engine {
         renderPassInfo.pAttachments = attachments.data();
         renderPassInfo.subpassCount = 1;
         renderPassInfo.pSubpasses = &subpass;
-        renderPassInfo.dependencyCount = 1;
-        renderPassInfo.pDependencies = &dependency;
+        renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+        renderPassInfo.pDependencies = dependencies.data();
 
         if (vkCreateRenderPass(device.device(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
             spdlog::get ("vulkan")->trace ("Failed to create render pass");
@@ -312,7 +461,7 @@ namespace engine {
         VkExtent2D swapChainExtent = getSwapChainExtent();
 
         depthImages.resize(imageCount());
-        depthImageMemorys.resize(imageCount());
+        depthImageAllocations.resize(imageCount());
         depthImageViews.resize(imageCount());
 
         for (int i = 0; i < depthImages.size(); i++) {
@@ -327,7 +476,7 @@ namespace engine {
             imageInfo.format = depthFormat;
             imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
             imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
             imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
             imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
             imageInfo.flags = 0;
@@ -336,7 +485,7 @@ namespace engine {
                     imageInfo,
                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                     depthImages[i],
-                    depthImageMemorys[i]);
+                    depthImageAllocations[i]);
 
             VkImageViewCreateInfo viewInfo{};
             viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -433,7 +582,7 @@ namespace engine {
         return device.findSupportedFormat(
                 {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
                 VK_IMAGE_TILING_OPTIMAL,
-                VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+                VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
     }
 
 }  // namespace engine
\ No newline at end of file
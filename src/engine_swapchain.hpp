@@ -17,6 +17,10 @@
 
 namespace engine {
 
+    /**
+     * When the device is headless there is no VkSwapchainKHR, the images are plain offscreen color images handed out in
+     * turn by acquireNextImage and left in TRANSFER_SRC_OPTIMAL so they can be read back. Nothing is presented.
+     */
     class EngineSwapChain {
     public:
         static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
@@ -31,6 +35,8 @@ namespace engine {
         VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
         VkRenderPass getRenderPass() { return renderPass; }
         VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+        // Left in DEPTH_STENCIL_READ_ONLY_OPTIMAL at the end of the render pass
+        const std::vector<VkImageView> &getDepthImageViews() { return depthImageViews; }
         size_t imageCount() { return swapChainImages.size(); }
         VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
         VkExtent2D getSwapChainExtent() { return swapChainExtent; }
@@ -43,7 +49,12 @@ namespace engine {
         VkFormat findDepthFormat();
 
         VkResult acquireNextImage(uint32_t *imageIndex);
-        VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
+        // uploadSemaphore is an optional timeline semaphore the frame waits to reach uploadValue before reading vertex or shader data
+        VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex,
+                                      VkSemaphore uploadSemaphore = VK_NULL_HANDLE, uint64_t uploadValue = 0);
+
+        // Copies a submitted offscreen image to a PNG, waits for the GPU to finish it first. Headless only
+        bool saveImage(uint32_t imageIndex, const std::string &filepath);
 
         bool compareSwapFormats(const EngineSwapChain& swapChain) const {
             return swapChain.swapChainDepthFormat == swapChainDepthFormat &&
@@ -53,6 +64,7 @@ namespace engine {
     private:
         void init();
         void createSwapChain();
+        void createOffscreenImages();
         void createImageViews();
         void createDepthResources();
         void createRenderPass();
@@ -74,15 +86,19 @@ namespace engine {
         VkRenderPass renderPass;
 
         std::vector<VkImage> depthImages;
-        std::vector<VkDeviceMemory> depthImageMemorys;
+        std::vector<EngineAllocation> depthImageAllocations;
         std::vector<VkImageView> depthImageViews;
         std::vector<VkImage> swapChainImages;
         std::vector<VkImageView> swapChainImageViews;
+        // Only used when headless, the swap chain owns its own images
+        std::vector<EngineAllocation> offscreenImageAllocations;
+        uint32_t nextOffscreenImage = 0;
 
         EngineDevice &device;
         VkExtent2D windowExtent;
+        bool headless;
 
-        VkSwapchainKHR swapChain;
+        VkSwapchainKHR swapChain = VK_NULL_HANDLE;
         std::shared_ptr<EngineSwapChain> oldSwapChain;
 
         std::vector<VkSemaphore> imageAvailableSemaphores;
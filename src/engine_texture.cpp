@@ -3,50 +3,25 @@
 //
 
 #include "engine_texture.hpp"
-#include "engine_buffer.hpp"
+#include "engine_texture_file.hpp"
+#include "engine_upload_manager.hpp"
 #include <spdlog/spdlog.h>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <stdexcept>
+#include <vector>
 
 engine::EngineTexture::EngineTexture (engine::EngineDevice &device, const std::string &filepath): device{device} {
-    int width, height, channels, bytesPerPixel;
-
-    stbi_uc* data = stbi_load (filepath.c_str(), &width, &height, &bytesPerPixel, 4);
-
-    EngineBuffer stagingBuffer(device, 4,
-                               static_cast<uint32_t> (width * height),
-                               VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-    stagingBuffer.map ();
-    stagingBuffer.writeToBuffer (data);
-
-    imageFormat = VK_FORMAT_R8G8B8A8_SRGB;
-    VkImageCreateInfo imageInfo{};
-
-    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-    imageInfo.imageType = VK_IMAGE_TYPE_2D;
-    imageInfo.format = imageFormat;
-    imageInfo.mipLevels = 1;
-    imageInfo.arrayLayers = 1;
-    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
-    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
-    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    imageInfo.extent = {static_cast<uint32_t> (width), static_cast<uint32_t>(height), 1};
-    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-
-    device.createImageWithInfo (imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageMemory);
-
-    transitionImageLayout (VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-    device.copyBufferToImage (stagingBuffer.getBuffer(), image, static_cast<uint32_t> (width), static_cast<uint32_t>(height), 1);
-
-    transitionImageLayout (VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-
-    imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    if (std::filesystem::path (filepath).extension() == ".vtex")
+        loadCooked (filepath);
+    else
+        loadImage (filepath);
 
     VkSamplerCreateInfo samplerInfo {};
     samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
@@ -59,7 +34,7 @@ engine::EngineTexture::EngineTexture (engine::EngineDevice &device, const std::s
     samplerInfo.mipLodBias = 0.0f;
     samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
     samplerInfo.minLod = 0.0f;
-    samplerInfo.maxLod = 0.0f;
+    samplerInfo.maxLod = static_cast<float>(mipLevels);
     samplerInfo.maxAnisotropy = 0.0f;
     samplerInfo.anisotropyEnable = VK_FALSE;
     samplerInfo. borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
@@ -75,56 +50,143 @@ engine::EngineTexture::EngineTexture (engine::EngineDevice &device, const std::s
     imageViewInfo.subresourceRange.baseMipLevel = 0;
     imageViewInfo.subresourceRange.baseArrayLayer = 0;
     imageViewInfo.subresourceRange.layerCount = 1;
-    imageViewInfo.subresourceRange.levelCount = 1;
+    imageViewInfo.subresourceRange.levelCount = mipLevels;
     imageViewInfo.image = image;
 
     vkCreateImageView (device.device(), &imageViewInfo, nullptr, &imageView);
-    stbi_image_free (data);
 }
 
 engine::EngineTexture::~EngineTexture () {
-    vkDestroyImage (device.device(), image, nullptr);
-    vkFreeMemory (device.device(), imageMemory, nullptr);
+    device.destroyImage (image, imageAllocation);
     vkDestroyImageView (device.device(), imageView, nullptr);
     vkDestroySampler (device.device(), sampler, nullptr);
 }
 
-void engine::EngineTexture::transitionImageLayout (VkImageLayout oldLayout, VkImageLayout newLayout) {
-    VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
-    VkImageMemoryBarrier barrier {};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = oldLayout;
-    barrier.newLayout = newLayout;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = image;
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-
-    VkPipelineStageFlags sourceStage;
-    VkPipelineStageFlags destinationStage;
-
-    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    } else {
-        spdlog::get ("vulkan")->critical ("Unsupported layout transition from {} to {}");//, VkImageLayout(oldLayout), VkImageLayout(newLayout));
-        throw std::runtime_error ("unsupported layout transition");
+void engine::EngineTexture::loadCooked (const std::string &filepath) {
+    std::ifstream file(filepath, std::ios::ate | std::ios::binary);
+    if (!file.is_open()) {
+        spdlog::get ("assets")->critical ("Failed to open cooked texture {}", filepath);
+        throw std::runtime_error ("Failed to open cooked texture " + filepath);
+    }
+    auto fileSize = static_cast<size_t>(file.tellg());
+    std::vector<char> contents(fileSize);
+    file.seekg (0);
+    file.read (contents.data(), static_cast<std::streamsize>(fileSize));
+
+    texture_file::Header header{};
+    if (fileSize >= sizeof(header))
+        std::memcpy (&header, contents.data(), sizeof(header));
+    if (fileSize < sizeof(header) || header.magic != texture_file::MAGIC || header.version != texture_file::VERSION || header.mipLevels == 0) {
+        spdlog::get ("assets")->critical ("{} is not a version {} cooked texture", filepath, texture_file::VERSION);
+        throw std::runtime_error ("Invalid cooked texture " + filepath);
     }
 
-    vkCmdPipelineBarrier (commandBuffer, sourceStage, destinationStage, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    size_t dataOffset = sizeof(header) + header.mipLevels * sizeof(texture_file::MipLevel);
+    if (fileSize < dataOffset) {
+        spdlog::get ("assets")->critical ("Cooked texture {} is truncated", filepath);
+        throw std::runtime_error ("Truncated cooked texture " + filepath);
+    }
+    std::vector<texture_file::MipLevel> levels(header.mipLevels);
+    std::memcpy (levels.data(), contents.data() + sizeof(header), header.mipLevels * sizeof(texture_file::MipLevel));
+
+    bool srgb = (header.flags & texture_file::FLAG_SRGB) != 0;
+    switch (header.format) {
+        case texture_file::Format::BC1:
+            imageFormat = srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+            break;
+        case texture_file::Format::BC3:
+            imageFormat = srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+            break;
+        case texture_file::Format::BC7:
+            imageFormat = srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+            break;
+        default:
+            spdlog::get ("assets")->critical ("Cooked texture {} has unknown format {}", filepath, static_cast<uint32_t>(header.format));
+            throw std::runtime_error ("Unknown cooked texture format in " + filepath);
+    }
+
+    // One region per level, the blocks are already laid out the way the copy reads them. Each level has to be the
+    // next step of the full chain, the image is created from the header's size and would not match the copies otherwise
+    auto fullChainLevels = static_cast<uint32_t>(std::bit_width (std::max (header.width, header.height)));
+    std::vector<VkBufferImageCopy> regions{};
+    regions.reserve (header.mipLevels);
+    for (uint32_t level = 0; level < header.mipLevels; level++) {
+        const auto &mip = levels[level];
+        if (level >= fullChainLevels
+                || mip.width != std::max (header.width >> level, 1u)
+                || mip.height != std::max (header.height >> level, 1u)
+                || mip.size != texture_file::levelSize (header.format, mip.width, mip.height)
+                || dataOffset + mip.offset + mip.size > fileSize) {
+            spdlog::get ("assets")->critical ("Cooked texture {} has a bad mip {}", filepath, level);
+            throw std::runtime_error ("Bad mip level in cooked texture " + filepath);
+        }
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = mip.offset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {mip.width, mip.height, 1};
+        regions.push_back (region);
+    }
+    mipLevels = header.mipLevels;
 
-    device.endSingleTimeCommands (commandBuffer);
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = imageFormat;
+    imageInfo.mipLevels = mipLevels;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.extent = {header.width, header.height, 1};
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    device.createImageWithInfo (imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageAllocation);
+
+    // Every level in one staged copy, no decoding on the way
+    auto &uploads = device.getUploadManager();
+    uploads.uploadToImage (contents.data() + dataOffset, static_cast<VkDeviceSize>(fileSize - dataOffset), image, regions,
+                           VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    uploads.wait (uploads.submit());
+
+    imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+void engine::EngineTexture::loadImage (const std::string &filepath) {
+    int width, height, channels, bytesPerPixel;
+
+    stbi_uc* data = stbi_load (filepath.c_str(), &width, &height, &bytesPerPixel, 4);
+
+    imageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+    VkImageCreateInfo imageInfo{};
+
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = imageFormat;
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.extent = {static_cast<uint32_t> (width), static_cast<uint32_t>(height), 1};
+    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+    device.createImageWithInfo (imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageAllocation);
+
+    // Transitions, copy and the final transition all go in one upload batch
+    auto &uploads = device.getUploadManager();
+    uploads.uploadToImage (data, static_cast<VkDeviceSize>(width) * height * 4, image, static_cast<uint32_t> (width), static_cast<uint32_t>(height), 1,
+                           VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    uploads.wait (uploads.submit());
+
+    imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    stbi_image_free (data);
 }
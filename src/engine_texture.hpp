@@ -8,6 +8,8 @@
 #include "engine_device.hpp"
 
 namespace engine {
+    // Cooked .vtex files are block compressed with their mips already built and are copied straight into the image.
+    // Anything else is decoded with stb and uploaded as uncompressed RGBA8 with a single level
     class EngineTexture {
     public:
         EngineTexture(EngineDevice &device, const std::string &filepath);
@@ -24,16 +26,17 @@ namespace engine {
         EngineTexture &operator=(EngineTexture &&) = delete;
 
     private:
-
-        void transitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout);
+        void loadCooked(const std::string &filepath);
+        void loadImage(const std::string &filepath);
 
         EngineDevice &device;
         VkImage image;
-        VkDeviceMemory  imageMemory;
+        EngineAllocation imageAllocation;
         VkImageView imageView;
         VkSampler sampler;
         VkFormat imageFormat;
         VkImageLayout imageLayout;
+        uint32_t mipLevels = 1;
     };
 }
 
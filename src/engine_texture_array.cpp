@@ -0,0 +1,216 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "engine_texture_array.hpp"
+#include "engine_upload_manager.hpp"
+
+#include <spdlog/spdlog.h>
+#include <stb_image.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cctype>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+namespace engine {
+
+    namespace {
+        bool isImageFile (const std::filesystem::path &path) {
+            auto extension = path.extension().string();
+            std::transform (extension.begin(), extension.end(), extension.begin(), [] (unsigned char c) { return std::tolower (c); });
+            return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".tga" || extension == ".bmp";
+        }
+    }
+
+    EngineTextureArray::EngineTextureArray (EngineDevice &device, const std::string &directory) : engineDevice{device} {
+        std::vector<std::filesystem::path> tiles{};
+        if (std::filesystem::is_directory (directory)) {
+            for (const auto &entry : std::filesystem::directory_iterator (directory)) {
+                if (entry.is_regular_file() && isImageFile (entry.path()))
+                    tiles.push_back (entry.path());
+            }
+        }
+        if (tiles.empty()) {
+            spdlog::get ("assets")->critical ("No texture tiles found in {}", directory);
+            throw std::runtime_error ("No texture tiles found in " + directory);
+        }
+        // Layer order is filename order, directory iteration order isn't specified
+        std::sort (tiles.begin(), tiles.end());
+
+        int width = 0, height = 0;
+        std::vector<stbi_uc> pixels{};
+        for (const auto &tile : tiles) {
+            int tileWidth, tileHeight, channels;
+            stbi_uc *data = stbi_load (tile.string().c_str(), &tileWidth, &tileHeight, &channels, 4);
+            if (data == nullptr) {
+                spdlog::get ("assets")->critical ("Failed to load texture tile {}: {}", tile.string(), stbi_failure_reason());
+                throw std::runtime_error ("Failed to load texture tile " + tile.string());
+            }
+            if (pixels.empty()) {
+                width = tileWidth;
+                height = tileHeight;
+                pixels.reserve (static_cast<size_t>(width) * height * 4 * tiles.size());
+            } else if (tileWidth != width || tileHeight != height) {
+                stbi_image_free (data);
+                spdlog::get ("assets")->critical ("Texture tile {} is {}x{}, the array is {}x{}", tile.string(), tileWidth, tileHeight, width, height);
+                throw std::runtime_error ("Texture tile " + tile.string() + " doesn't match the size of the array");
+            }
+            pixels.insert (pixels.end(), data, data + static_cast<size_t>(width) * height * 4);
+            stbi_image_free (data);
+        }
+
+        layerCount = static_cast<uint32_t>(tiles.size());
+        mipLevels = static_cast<uint32_t>(std::floor (std::log2 (std::max (width, height)))) + 1;
+
+        // R8G8B8A8_SRGB is required to support linear blits, so the chain can always be generated
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.format = imageFormat;
+        imageInfo.mipLevels = mipLevels;
+        imageInfo.arrayLayers = layerCount;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.extent = {static_cast<uint32_t>(width), static_cast<uint32_t>(height), 1};
+        imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+        device.createImageWithInfo (imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageAllocation);
+
+        // Mip 0 of every layer in one copy, every level is left as a transfer destination for the blits
+        auto &uploads = device.getUploadManager();
+        uploads.uploadToImage (pixels.data(), static_cast<VkDeviceSize>(pixels.size()), image, static_cast<uint32_t>(width),
+                               static_cast<uint32_t>(height), layerCount, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        uploads.wait (uploads.submit());
+
+        generateMipmaps (static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+        createImageView();
+        createSampler();
+
+        spdlog::get ("assets")->info ("Loaded {} texture tiles of {}x{} from {}, {} mip levels", layerCount, width, height, directory, mipLevels);
+    }
+
+    EngineTextureArray::~EngineTextureArray () {
+        vkDestroySampler (engineDevice.device(), sampler, nullptr);
+        vkDestroyImageView (engineDevice.device(), imageView, nullptr);
+        engineDevice.destroyImage (image, imageAllocation);
+    }
+
+    void EngineTextureArray::generateMipmaps (uint32_t width, uint32_t height) {
+        VkCommandBuffer commandBuffer = engineDevice.beginSingleTimeCommands();
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = layerCount;
+        barrier.subresourceRange.levelCount = 1;
+
+        auto mipWidth = static_cast<int32_t>(width);
+        auto mipHeight = static_cast<int32_t>(height);
+        for (uint32_t level = 1; level < mipLevels; level++) {
+            // The level above has been written, by the upload or the previous blit, and becomes the source
+            barrier.subresourceRange.baseMipLevel = level - 1;
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            vkCmdPipelineBarrier (commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+            int32_t nextWidth = std::max (mipWidth / 2, 1);
+            int32_t nextHeight = std::max (mipHeight / 2, 1);
+
+            // All layers in one blit
+            VkImageBlit blit{};
+            blit.srcOffsets[0] = {0, 0, 0};
+            blit.srcOffsets[1] = {mipWidth, mipHeight, 1};
+            blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            blit.srcSubresource.mipLevel = level - 1;
+            blit.srcSubresource.baseArrayLayer = 0;
+            blit.srcSubresource.layerCount = layerCount;
+            blit.dstOffsets[0] = {0, 0, 0};
+            blit.dstOffsets[1] = {nextWidth, nextHeight, 1};
+            blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            blit.dstSubresource.mipLevel = level;
+            blit.dstSubresource.baseArrayLayer = 0;
+            blit.dstSubresource.layerCount = layerCount;
+            vkCmdBlitImage (commandBuffer,
+                            image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                            image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                            1, &blit, VK_FILTER_LINEAR);
+
+            // Done as a source, nothing writes it again
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+            barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            vkCmdPipelineBarrier (commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+            mipWidth = nextWidth;
+            mipHeight = nextHeight;
+        }
+
+        // The smallest level was only ever a destination
+        barrier.subresourceRange.baseMipLevel = mipLevels - 1;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier (commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        engineDevice.endSingleTimeCommands (commandBuffer);
+        imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+
+    void EngineTextureArray::createImageView () {
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        viewInfo.format = imageFormat;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = mipLevels;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = layerCount;
+
+        if (vkCreateImageView (engineDevice.device(), &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to create texture array image view");
+            throw std::runtime_error ("Failed to create texture array image view!");
+        }
+    }
+
+    void EngineTextureArray::createSampler () {
+        // Trilinear, and anisotropic so faces seen at a grazing angle don't drop to a blurry mip
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_LINEAR;
+        samplerInfo.minFilter = VK_FILTER_LINEAR;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.mipLodBias = 0.0f;
+        samplerInfo.anisotropyEnable = VK_TRUE;
+        samplerInfo.maxAnisotropy = std::min (16.0f, engineDevice.properties.limits.maxSamplerAnisotropy);
+        samplerInfo.compareEnable = VK_FALSE;
+        samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+        samplerInfo.minLod = 0.0f;
+        samplerInfo.maxLod = static_cast<float>(mipLevels);
+        samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+
+        if (vkCreateSampler (engineDevice.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to create texture array sampler");
+            throw std::runtime_error ("Failed to create texture array sampler!");
+        }
+    }
+
+} // engine
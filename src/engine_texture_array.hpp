@@ -0,0 +1,56 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_ENGINE_TEXTURE_ARRAY_HPP
+#define VULKANENGINE_ENGINE_TEXTURE_ARRAY_HPP
+
+#include "engine_device.hpp"
+
+// std
+#include <string>
+
+namespace engine {
+
+    /**
+     * A 2D array texture with one layer per tile, for the faces of voxel blocks. Every image in a directory becomes a
+     * layer, in filename order, and all of them have to be the same size. The full mip chain is generated on the GPU by
+     * blitting each level down from the one above it, and the sampler is trilinear with anisotropic filtering, so far
+     * away terrain samples small mips instead of aliasing across the full size tiles.
+     */
+    class EngineTextureArray {
+    public:
+        EngineTextureArray (EngineDevice &device, const std::string &directory);
+        ~EngineTextureArray ();
+
+        EngineTextureArray (const EngineTextureArray &) = delete;
+        EngineTextureArray &operator= (const EngineTextureArray &) = delete;
+        EngineTextureArray (EngineTextureArray &&) = delete;
+        EngineTextureArray &operator= (EngineTextureArray &&) = delete;
+
+        [[nodiscard]] VkSampler getSampler () const { return sampler; }
+        [[nodiscard]] VkImageView getImageView () const { return imageView; }
+        [[nodiscard]] VkImageLayout getImageLayout () const { return imageLayout; }
+        [[nodiscard]] uint32_t getLayerCount () const { return layerCount; }
+        [[nodiscard]] uint32_t getMipLevels () const { return mipLevels; }
+
+    private:
+        // Records every level's blit into one command buffer, leaves the whole image shader readable
+        void generateMipmaps (uint32_t width, uint32_t height);
+        void createImageView ();
+        void createSampler ();
+
+        EngineDevice &engineDevice;
+        VkImage image = VK_NULL_HANDLE;
+        EngineAllocation imageAllocation{};
+        VkImageView imageView = VK_NULL_HANDLE;
+        VkSampler sampler = VK_NULL_HANDLE;
+        VkFormat imageFormat = VK_FORMAT_R8G8B8A8_SRGB;
+        VkImageLayout imageLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        uint32_t layerCount = 0;
+        uint32_t mipLevels = 1;
+    };
+
+} // engine
+
+#endif //VULKANENGINE_ENGINE_TEXTURE_ARRAY_HPP
@@ -0,0 +1,72 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_ENGINE_TEXTURE_FILE_HPP
+#define VULKANENGINE_ENGINE_TEXTURE_FILE_HPP
+
+// std
+#include <cstdint>
+
+namespace engine {
+
+    /**
+     * Layout of the .vtex files written by the texture cooker and read by EngineTexture. A header, one entry per
+     * mip level, then the block compressed data of every level from largest to smallest. The data is already in the
+     * layout vkCmdCopyBufferToImage expects, so loading is a read and a copy with no decoding.
+     * Kept free of vulkan so the cooker doesn't need it.
+     */
+    namespace texture_file {
+        // "VTEX", little endian
+        constexpr uint32_t MAGIC = 0x58455456;
+        constexpr uint32_t VERSION = 1;
+
+        enum class Format : uint32_t {
+            BC1 = 1, // RGB, 8 bytes per block, alpha is dropped
+            BC3 = 3, // RGBA, 16 bytes per block, BC1 colour plus a separate alpha block
+            BC7 = 7, // RGBA, 16 bytes per block, best quality of the three
+        };
+
+        enum Flags : uint32_t {
+            // Colour data, sampled through an sRGB format. Unset for data textures such as normal maps
+            FLAG_SRGB = 1u << 0,
+        };
+
+        constexpr uint32_t BLOCK_DIMENSION = 4;
+
+        struct Header {
+            uint32_t magic = MAGIC;
+            uint32_t version = VERSION;
+            Format format = Format::BC7;
+            uint32_t flags = 0;
+            uint32_t width = 0;
+            uint32_t height = 0;
+            uint32_t mipLevels = 0;
+            uint32_t reserved = 0;
+        };
+
+        struct MipLevel {
+            // From the start of the data, which follows the last entry
+            uint64_t offset = 0;
+            uint64_t size = 0;
+            uint32_t width = 0;
+            uint32_t height = 0;
+        };
+
+        static_assert(sizeof(Header) == 32 && sizeof(MipLevel) == 24, "Texture file structs are written to disk as they are");
+
+        constexpr uint32_t bytesPerBlock (Format format) {
+            return format == Format::BC1 ? 8 : 16;
+        }
+
+        // Partial blocks at the edge of small mips still take a whole block
+        constexpr uint64_t levelSize (Format format, uint32_t width, uint32_t height) {
+            uint64_t blocksWide = (width + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+            uint64_t blocksHigh = (height + BLOCK_DIMENSION - 1) / BLOCK_DIMENSION;
+            return blocksWide * blocksHigh * bytesPerBlock (format);
+        }
+    }
+
+} // engine
+
+#endif //VULKANENGINE_ENGINE_TEXTURE_FILE_HPP
@@ -0,0 +1,118 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "engine_texture_registry.hpp"
+#include "engine_swapchain.hpp"
+
+#include <spdlog/spdlog.h>
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace engine {
+
+    EngineTextureRegistry::EngineTextureRegistry (EngineDevice &device, EngineTexture &fallback) : engineDevice{device} {
+        // Partially bound, slots that were never written are fine as long as nothing indexes them
+        VkDescriptorBindingFlags bindlessFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT
+                                                 | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+                                                 | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        textureSetLayout = &EngineDescriptorSetLayout::Builder(engineDevice)
+                .addBinding (0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, MAX_TEXTURES)
+                .addBinding (1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, MAX_TEXTURE_ARRAYS)
+                .setBindingFlags (0, bindlessFlags)
+                .setBindingFlags (1, bindlessFlags)
+                .build (engineDevice.getDescriptorLayoutCache());
+
+        textureDescriptors = EngineDescriptorAllocator::Builder(engineDevice)
+                .setInitialSets (1)
+                .setPoolFlags (VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+                .addPoolRatio (VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, static_cast<float>(MAX_TEXTURES + MAX_TEXTURE_ARRAYS))
+                .build();
+
+        if (!textureDescriptors->allocateDescriptorSet (textureSetLayout->getDescriptorSetLayout(), textureSet)) {
+            spdlog::get ("vulkan")->critical ("Failed to allocate bindless texture descriptor set");
+            throw std::runtime_error ("Failed to allocate bindless texture descriptor set!");
+        }
+
+        textureSlots.capacity = MAX_TEXTURES;
+        textureSlots.releasedIndices.resize (EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
+        textureArraySlots.capacity = MAX_TEXTURE_ARRAYS;
+        textureArraySlots.releasedIndices.resize (EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
+
+        uint32_t fallbackIndex = registerTexture (fallback);
+        assert(fallbackIndex == FALLBACK_TEXTURE && "Fallback texture has to take the first slot");
+    }
+
+    EngineTextureRegistry::~EngineTextureRegistry () = default;
+
+    uint32_t EngineTextureRegistry::SlotList::acquire () {
+        if (!freeIndices.empty()) {
+            uint32_t index = freeIndices.back();
+            freeIndices.pop_back();
+            return index;
+        }
+        if (nextIndex < capacity)
+            return nextIndex++;
+
+        spdlog::get ("vulkan")->critical ("Bindless texture binding is full, {} slots registered", capacity);
+        throw std::runtime_error ("Bindless texture binding is full!");
+    }
+
+    uint32_t EngineTextureRegistry::registerTexture (EngineTexture &texture) {
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.sampler = texture.getSampler();
+        imageInfo.imageView = texture.getImageView();
+        imageInfo.imageLayout = texture.getImageLayout();
+
+        std::lock_guard<std::mutex> lock{mutex};
+        uint32_t index = textureSlots.acquire();
+        writeSlot (0, index, imageInfo);
+        return index;
+    }
+
+    uint32_t EngineTextureRegistry::registerTextureArray (EngineTextureArray &textureArray) {
+        VkDescriptorImageInfo imageInfo{};
+        imageInfo.sampler = textureArray.getSampler();
+        imageInfo.imageView = textureArray.getImageView();
+        imageInfo.imageLayout = textureArray.getImageLayout();
+
+        std::lock_guard<std::mutex> lock{mutex};
+        uint32_t index = textureArraySlots.acquire();
+        writeSlot (1, index, imageInfo);
+        return index;
+    }
+
+    void EngineTextureRegistry::releaseTexture (uint32_t index) {
+        std::lock_guard<std::mutex> lock{mutex};
+        assert(index != FALLBACK_TEXTURE && "The fallback texture can't be released");
+        assert(index < textureSlots.nextIndex && "Releasing a texture that was never registered");
+        textureSlots.releasedIndices[currentFrame].push_back (index);
+    }
+
+    void EngineTextureRegistry::releaseTextureArray (uint32_t index) {
+        std::lock_guard<std::mutex> lock{mutex};
+        assert(index < textureArraySlots.nextIndex && "Releasing a texture array that was never registered");
+        textureArraySlots.releasedIndices[currentFrame].push_back (index);
+    }
+
+    void EngineTextureRegistry::beginFrame (int frameIndex) {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        currentFrame = frameIndex;
+        for (SlotList *slots : {&textureSlots, &textureArraySlots}) {
+            auto &released = slots->releasedIndices[frameIndex];
+            slots->freeIndices.insert (slots->freeIndices.end(), released.begin(), released.end());
+            released.clear();
+        }
+    }
+
+    void EngineTextureRegistry::writeSlot (uint32_t binding, uint32_t index, VkDescriptorImageInfo &imageInfo) {
+        // The slot is unused by every pending frame, update unused while pending allows writing it under them
+        EngineDescriptorWriter(*textureSetLayout, *textureDescriptors)
+                .writeImage (binding, index, &imageInfo)
+                .overwrite (textureSet);
+    }
+
+} // engine
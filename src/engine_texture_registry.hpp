@@ -0,0 +1,82 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_ENGINE_TEXTURE_REGISTRY_HPP
+#define VULKANENGINE_ENGINE_TEXTURE_REGISTRY_HPP
+
+#include "engine_device.hpp"
+#include "engine_descriptors.hpp"
+#include "engine_texture.hpp"
+#include "engine_texture_array.hpp"
+
+// std
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * Bindless textures. Every registered texture takes one slot of a single large sampler array, which is written with
+     * update after bind so textures can be added while earlier frames are still in flight. Objects carry the slot index
+     * and shaders pick their texture from the array, so drawing many materials never rebinds a descriptor set.
+     * Array textures get slots of their own in a second, smaller binding.
+     */
+    class EngineTextureRegistry {
+    public:
+        static constexpr uint32_t MAX_TEXTURES = 4096;
+        // Written with the fallback texture, the index anything without its own texture uses
+        static constexpr uint32_t FALLBACK_TEXTURE = 0;
+        static constexpr uint32_t MAX_TEXTURE_ARRAYS = 64;
+        // Array slot of objects that only sample their 2D texture
+        static constexpr uint32_t NO_TEXTURE_ARRAY = UINT32_MAX;
+
+        EngineTextureRegistry (EngineDevice &device, EngineTexture &fallback);
+        ~EngineTextureRegistry ();
+
+        EngineTextureRegistry (const EngineTextureRegistry &) = delete;
+        EngineTextureRegistry &operator= (const EngineTextureRegistry &) = delete;
+
+        // The texture has to outlive its registration. Safe to call from any thread
+        uint32_t registerTexture (EngineTexture &texture);
+        uint32_t registerTextureArray (EngineTextureArray &textureArray);
+        // Frames already recorded may still sample it, the slot is only reused once they have finished
+        void releaseTexture (uint32_t index);
+        void releaseTextureArray (uint32_t index);
+        // Slots released the last time this frame slot was recorded can be handed out again, its fence has signalled
+        void beginFrame (int frameIndex);
+
+        [[nodiscard]] VkDescriptorSetLayout getDescriptorSetLayout () const { return textureSetLayout->getDescriptorSetLayout(); }
+        [[nodiscard]] VkDescriptorSet getDescriptorSet () const { return textureSet; }
+
+    private:
+        // Hands out the slots of one binding
+        struct SlotList {
+            uint32_t capacity = 0;
+            uint32_t nextIndex = 0;
+            std::vector<uint32_t> freeIndices{};
+            // Released while each frame slot was being recorded
+            std::vector<std::vector<uint32_t>> releasedIndices{};
+
+            uint32_t acquire ();
+        };
+
+        void writeSlot (uint32_t binding, uint32_t index, VkDescriptorImageInfo &imageInfo);
+
+        EngineDevice &engineDevice;
+
+        // Owned by the device's layout cache, the one set comes from an update after bind allocator of its own
+        EngineDescriptorSetLayout *textureSetLayout = nullptr;
+        std::unique_ptr<EngineDescriptorAllocator> textureDescriptors;
+        VkDescriptorSet textureSet = VK_NULL_HANDLE;
+
+        std::mutex mutex{};
+        SlotList textureSlots{};
+        SlotList textureArraySlots{};
+        int currentFrame = 0;
+    };
+
+} // engine
+
+#endif //VULKANENGINE_ENGINE_TEXTURE_REGISTRY_HPP
@@ -0,0 +1,269 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "engine_upload_manager.hpp"
+#include "engine_swapchain.hpp"
+
+#include <spdlog/spdlog.h>
+
+// std
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace engine {
+
+    namespace {
+        // Covers the texel size, compressed block sizes and the multiple of 4 buffer to image copies need
+        constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+    }
+
+    EngineUploadManager::EngineUploadManager (EngineDevice &device)
+            : engineDevice{device}, stagingRing{device, STAGING_PARTITION_SIZE, EngineSwapChain::MAX_FRAMES_IN_FLIGHT} {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = device.transferQueueFamily();
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        if (vkCreateCommandPool (device.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to create upload command pool");
+            throw std::runtime_error ("Failed to create upload command pool!");
+        }
+
+        VkSemaphoreTypeCreateInfo typeInfo{};
+        typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+        typeInfo.initialValue = 0;
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        semaphoreInfo.pNext = &typeInfo;
+
+        if (vkCreateSemaphore (device.device(), &semaphoreInfo, nullptr, &timelineSemaphore) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to create upload timeline semaphore");
+            throw std::runtime_error ("Failed to create upload timeline semaphore!");
+        }
+    }
+
+    EngineUploadManager::~EngineUploadManager () {
+        if (batchHasWork) {
+            submit();
+        }
+        wait (nextValue - 1);
+
+        vkDestroySemaphore (engineDevice.device(), timelineSemaphore, nullptr);
+        // Frees every command buffer allocated from it
+        vkDestroyCommandPool (engineDevice.device(), commandPool, nullptr);
+    }
+
+    void EngineUploadManager::beginFrame () {
+        update();
+
+        // Everything staged in the partition being left is read by the open batch at the latest
+        uint64_t lastReader = batchHasWork ? nextValue : nextValue - 1;
+        uint64_t waitValue = stagingRing.advance (lastReader);
+        if (!isComplete (waitValue)) {
+            spdlog::get ("vulkan")->debug ("Staging ring full, waiting for upload {}", waitValue);
+            wait (waitValue);
+        }
+    }
+
+    void EngineUploadManager::uploadToBuffer (const void *data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset) {
+        StagingAllocation staging = stage (data, size);
+        copyBuffer (staging.buffer, dstBuffer, size, staging.offset, dstOffset);
+    }
+
+    void EngineUploadManager::uploadToImage (const void *data, VkDeviceSize size, VkImage image, uint32_t width, uint32_t height,
+                                             uint32_t layerCount, VkImageLayout finalLayout) {
+        StagingAllocation staging = stage (data, size);
+        copyBufferToImage (staging.buffer, image, width, height, layerCount, finalLayout, staging.offset);
+    }
+
+    void EngineUploadManager::copyBuffer (VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset) {
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = srcOffset;
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = size;
+        vkCmdCopyBuffer (getBatchCommandBuffer(), srcBuffer, dstBuffer, 1, &copyRegion);
+    }
+
+    void EngineUploadManager::uploadToImage (const void *data, VkDeviceSize size, VkImage image, std::vector<VkBufferImageCopy> regions,
+                                             VkImageLayout finalLayout) {
+        StagingAllocation staging = stage (data, size);
+        for (auto &region : regions)
+            region.bufferOffset += staging.offset;
+        copyBufferToImage (staging.buffer, image, regions, finalLayout);
+    }
+
+    void EngineUploadManager::copyBufferToImage (VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount,
+                                                 VkImageLayout finalLayout, VkDeviceSize bufferOffset) {
+        VkBufferImageCopy region{};
+        region.bufferOffset = bufferOffset;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = layerCount;
+        region.imageOffset = {0, 0, 0};
+        region.imageExtent = {width, height, 1};
+        copyBufferToImage (buffer, image, {region}, finalLayout);
+    }
+
+    void EngineUploadManager::copyBufferToImage (VkBuffer buffer, VkImage image, const std::vector<VkBufferImageCopy> &regions,
+                                                 VkImageLayout finalLayout) {
+        VkCommandBuffer commandBuffer = getBatchCommandBuffer();
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        vkCmdPipelineBarrier (commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        vkCmdCopyBufferToImage (commandBuffer, buffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32_t>(regions.size()), regions.data());
+
+        // The transfer queue can't name shader stages, the graphics side waits on the timeline semaphore before reading
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = finalLayout;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = 0;
+        vkCmdPipelineBarrier (commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    void EngineUploadManager::releaseAfterUpload (std::unique_ptr<EngineBuffer> buffer) {
+        openBatch.stagingBuffers.push_back (std::move (buffer));
+    }
+
+    uint64_t EngineUploadManager::submit () {
+        if (!batchHasWork) {
+            // Staging buffers handed over without any copies can go straight away
+            openBatch.stagingBuffers.clear();
+            return nextValue - 1;
+        }
+
+        if (vkEndCommandBuffer (openBatch.commandBuffer) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to record upload command buffer");
+            throw std::runtime_error ("Failed to record upload command buffer!");
+        }
+
+        openBatch.signalValue = nextValue++;
+
+        VkTimelineSemaphoreSubmitInfo timelineInfo{};
+        timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+        timelineInfo.signalSemaphoreValueCount = 1;
+        timelineInfo.pSignalSemaphoreValues = &openBatch.signalValue;
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.pNext = &timelineInfo;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &openBatch.commandBuffer;
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &timelineSemaphore;
+
+        if (vkQueueSubmit (engineDevice.transferQueue(), 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to submit upload command buffer");
+            throw std::runtime_error ("Failed to submit upload command buffer!");
+        }
+
+        uint64_t signalValue = openBatch.signalValue;
+        submittedBatches.push_back (std::move (openBatch));
+        openBatch = Batch{};
+        batchHasWork = false;
+        return signalValue;
+    }
+
+    void EngineUploadManager::update () {
+        vkGetSemaphoreCounterValue (engineDevice.device(), timelineSemaphore, &completedValue);
+        recycleFinishedBatches();
+    }
+
+    void EngineUploadManager::wait (uint64_t value) {
+        if (value >= nextValue && batchHasWork) {
+            submit();
+        }
+        assert(value < nextValue && "Waiting on an upload that was never recorded");
+
+        if (value > completedValue) {
+            VkSemaphoreWaitInfo waitInfo{};
+            waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            waitInfo.semaphoreCount = 1;
+            waitInfo.pSemaphores = &timelineSemaphore;
+            waitInfo.pValues = &value;
+            vkWaitSemaphores (engineDevice.device(), &waitInfo, UINT64_MAX);
+        }
+        update();
+    }
+
+    VkCommandBuffer EngineUploadManager::getBatchCommandBuffer () {
+        if (batchHasWork)
+            return openBatch.commandBuffer;
+
+        if (freeCommandBuffers.empty()) {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = commandPool;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer;
+            if (vkAllocateCommandBuffers (engineDevice.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+                spdlog::get ("vulkan")->critical ("Failed to allocate upload command buffer");
+                throw std::runtime_error ("Failed to allocate upload command buffer!");
+            }
+            freeCommandBuffers.push_back (commandBuffer);
+        }
+
+        openBatch.commandBuffer = freeCommandBuffers.back();
+        freeCommandBuffers.pop_back();
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        vkBeginCommandBuffer (openBatch.commandBuffer, &beginInfo);
+
+        batchHasWork = true;
+        return openBatch.commandBuffer;
+    }
+
+    StagingAllocation EngineUploadManager::stage (const void *data, VkDeviceSize size) {
+        StagingAllocation staging{};
+        if (!stagingRing.allocate (size, STAGING_ALIGNMENT, staging)) {
+            auto buffer = std::make_unique<EngineBuffer>(
+                    engineDevice,
+                    size,
+                    1,
+                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            buffer->map();
+            staging.buffer = buffer->getBuffer();
+            staging.offset = buffer->getBufferOffset();
+            staging.mapped = buffer->getMappedMemory();
+            releaseAfterUpload (std::move (buffer));
+        }
+
+        std::memcpy (staging.mapped, data, size);
+        return staging;
+    }
+
+    void EngineUploadManager::recycleFinishedBatches () {
+        while (!submittedBatches.empty() && submittedBatches.front().signalValue <= completedValue) {
+            Batch &batch = submittedBatches.front();
+            vkResetCommandBuffer (batch.commandBuffer, 0);
+            freeCommandBuffers.push_back (batch.commandBuffer);
+            submittedBatches.pop_front();
+        }
+    }
+
+} // engine
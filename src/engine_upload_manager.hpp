@@ -0,0 +1,109 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_ENGINE_UPLOAD_MANAGER_HPP
+#define VULKANENGINE_ENGINE_UPLOAD_MANAGER_HPP
+
+#include "engine_device.hpp"
+#include "engine_buffer.hpp"
+#include "engine_staging_ring.hpp"
+
+// std
+#include <deque>
+#include <memory>
+#include <vector>
+
+namespace engine {
+
+    /**
+     * Records copies into a batch on the transfer queue (the graphics queue when the device has no dedicated one)
+     * and submits the whole batch at once. Each submit signals a timeline semaphore with an increasing value,
+     * callers hold on to the value and poll isComplete instead of waiting on the queue.
+     * Data is staged through a ring with one partition per frame in flight, uploads too big for a partition
+     * get a staging buffer of their own.
+     *
+     * Not thread safe, meant to be used from the render thread.
+     */
+    class EngineUploadManager {
+    public:
+        static constexpr VkDeviceSize STAGING_PARTITION_SIZE = 8 * 1024 * 1024;
+
+        explicit EngineUploadManager (EngineDevice &device);
+        ~EngineUploadManager ();
+
+        EngineUploadManager (const EngineUploadManager &) = delete;
+        EngineUploadManager &operator= (const EngineUploadManager &) = delete;
+
+        // Call once per frame. Polls for finished uploads and moves the staging ring on to the next partition,
+        // only blocks when the transfer queue has fallen a whole ring behind
+        void beginFrame ();
+
+        // Copies data into staging memory and records the copy into the open batch
+        void uploadToBuffer (const void *data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+        // Tightly packed mip 0 of every layer
+        void uploadToImage (const void *data, VkDeviceSize size, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount,
+                            VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        // Several mips or layers from one block of data, region buffer offsets are relative to the start of data
+        void uploadToImage (const void *data, VkDeviceSize size, VkImage image, std::vector<VkBufferImageCopy> regions,
+                            VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+        // Copies are recorded into the open batch, nothing runs until submit
+        void copyBuffer (VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
+        // Transitions the whole image from undefined, copies mip 0 and leaves it in finalLayout
+        void copyBufferToImage (VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount,
+                                VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VkDeviceSize bufferOffset = 0);
+        // Transitions every mip and layer from undefined, copies the regions and leaves the image in finalLayout
+        void copyBufferToImage (VkBuffer buffer, VkImage image, const std::vector<VkBufferImageCopy> &regions,
+                                VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+        // Keeps a staging buffer alive until the batch it was used in has finished on the GPU
+        void releaseAfterUpload (std::unique_ptr<EngineBuffer> buffer);
+
+        // Value the open batch will signal once submitted
+        [[nodiscard]] uint64_t getBatchValue () const { return nextValue; }
+
+        // Submits the open batch, returns the value to wait for. Returns the last submitted value if the batch is empty
+        uint64_t submit ();
+
+        // Polls the semaphore, recycles finished command buffers and frees their staging buffers
+        void update ();
+
+        [[nodiscard]] bool isComplete (uint64_t value) const { return value <= completedValue; }
+        // Blocks the calling thread, submits first if value belongs to the open batch
+        void wait (uint64_t value);
+
+        [[nodiscard]] VkSemaphore getSemaphore () const { return timelineSemaphore; }
+        // Highest value seen by the last update or wait
+        [[nodiscard]] uint64_t getCompletedValue () const { return completedValue; }
+
+    private:
+        struct Batch {
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+            uint64_t signalValue = 0;
+            std::vector<std::unique_ptr<EngineBuffer>> stagingBuffers{};
+        };
+
+        VkCommandBuffer getBatchCommandBuffer ();
+        // Ring memory when it fits, otherwise a staging buffer released with the batch
+        StagingAllocation stage (const void *data, VkDeviceSize size);
+        void recycleFinishedBatches ();
+
+        EngineDevice &engineDevice;
+        VkCommandPool commandPool = VK_NULL_HANDLE;
+        VkSemaphore timelineSemaphore = VK_NULL_HANDLE;
+
+        uint64_t nextValue = 1;
+        uint64_t completedValue = 0;
+
+        Batch openBatch{};
+        bool batchHasWork = false;
+        std::deque<Batch> submittedBatches{};
+        std::vector<VkCommandBuffer> freeCommandBuffers{};
+
+        EngineStagingRing stagingRing;
+    };
+
+} // engine
+
+#endif //VULKANENGINE_ENGINE_UPLOAD_MANAGER_HPP
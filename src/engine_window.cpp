@@ -10,11 +10,17 @@
 
 namespace engine {
 
-    EngineWindow::EngineWindow (int w, int h, std::string name) : width{w}, height{h}, windowName{std::move(name)}{
+    EngineWindow::EngineWindow (int w, int h, std::string name, bool headless) : width{w}, height{h}, headless{headless}, windowName{std::move(name)}{
+        if (headless) {
+            spdlog::info ("Running headless at {}x{}", width, height);
+            return;
+        }
         initWindow();
     }
 
     EngineWindow::~EngineWindow () {
+        if (headless)
+            return;
         glfwDestroyWindow (window);
         glfwTerminate();
     }
@@ -45,10 +51,16 @@ namespace engine {
     }
 
     bool EngineWindow::shouldClose () {
+        if (headless)
+            return false;
         return glfwWindowShouldClose (window);
     }
 
     void EngineWindow::createWindowSurface (VkInstance instance, VkSurfaceKHR *surface) {
+        if (headless) {
+            spdlog::critical ("Can't create a surface for a headless window");
+            throw std::runtime_error("Can't create a surface for a headless window");
+        }
         if (glfwCreateWindowSurface (instance, window, nullptr, surface) != VK_SUCCESS) {
             spdlog::critical ("Failed to create window surface");
             throw std::runtime_error("Failed to create window surface");
@@ -15,7 +15,9 @@ namespace engine {
 
     class EngineWindow {
     public:
-        EngineWindow(int width, int height, std::string name);
+        // A headless window never initializes GLFW, there is nothing to show and no surface to present to.
+        // It only carries the extent the offscreen images are created with
+        EngineWindow(int width, int height, std::string name, bool headless = false);
         ~EngineWindow();
 
         EngineWindow(const EngineWindow &) = delete;
@@ -26,6 +28,7 @@ namespace engine {
         [[nodiscard]] bool wasWindowResized() const { return framebufferResized; }
         void resetWindowResizedFlag() { framebufferResized = false; }
         [[nodiscard]] GLFWwindow *getGLFWwindow() const { return window; }
+        [[nodiscard]] bool isHeadless() const { return headless; }
 
         void createWindowSurface(VkInstance instance, VkSurfaceKHR *surface);
 
@@ -33,9 +36,10 @@ namespace engine {
         int width;
         int height;
         bool framebufferResized = false;
+        bool headless;
 
         std::string windowName;
-        GLFWwindow *window;
+        GLFWwindow *window = nullptr;
 
         static void framebufferResizedCallback (GLFWwindow *window, int width, int height);
         static void glfwErrorCallback(int error_code, const char* description);
@@ -5,28 +5,39 @@
 #include "first_app.hpp"
 #include "systems/simple_render_system.hpp"
 #include "systems/point_light_system.hpp"
+#include "systems/light_cluster_system.hpp"
 #include "engine_camera.hpp"
 #include "keyboard_movement_controller.hpp"
 #include "engine_texture.hpp"
+#include "engine_texture_registry.hpp"
+#include "engine_texture_array.hpp"
+#include "engine_upload_manager.hpp"
+#include "engine_pipeline_builder.hpp"
+#include "engine_parallel_recorder.hpp"
+
+#include <spdlog/spdlog.h>
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include <glm/glm.hpp>
 
 // std
+#include <algorithm>
 #include <chrono>
+#include <filesystem>
+#include <numeric>
 
 namespace engine {
+
+    // Headless runs step the scene by a fixed time so they are repeatable, and turn the camera to sweep across it
+    constexpr float HEADLESS_FRAME_TIME = 1.0f / 60.0f;
+    constexpr float HEADLESS_TURN_SPEED = 0.25f;
+
     void FirstApp::run () {
         std::vector<std::unique_ptr<EngineBuffer>> uboBuffers(EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
 
         for (auto & uboBuffer : uboBuffers) {
-            uboBuffer = std::make_unique<EngineBuffer>(
-                    engineDevice,
-                    sizeof (GlobalUBO),
-                    1,
-                    VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+            uboBuffer = engineDevice.getFrameBufferPool().allocateOrCreate (sizeof (GlobalUBO), 1);
             uboBuffer->map ();
         }
 
@@ -40,29 +51,30 @@ namespace engine {
         };
         globalUBOBuffer.map ();
 
-        auto globalSetLayout = EngineDescriptorSetLayout::Builder(engineDevice)
+        auto &globalSetLayout = EngineDescriptorSetLayout::Builder(engineDevice)
                 .addBinding (0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
-                .addBinding (1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT)
-                .build();
+                .build (engineDevice.getDescriptorLayoutCache());
 
-        EngineTexture texture = EngineTexture(engineDevice, "assets/textures/statue.jpg");
-
-        VkDescriptorImageInfo imageInfo {};
-        imageInfo.sampler = texture.getSampler();
-        imageInfo.imageView = texture.getImageView();
-        imageInfo.imageLayout = texture.getImageLayout();
+        // Takes the registry's fallback slot, every object samples it until it registers a texture of its own
+        EngineTexture texture = EngineTexture(engineDevice, "assets/textures/statue.vtex");
+        EngineTextureRegistry textureRegistry{engineDevice, texture};
+        EngineTextureArray blockTextures{engineDevice, "assets/textures/blocks"};
+        chunkStreamer->setBlockTextureArray (textureRegistry.registerTextureArray (blockTextures));
 
         std::vector<VkDescriptorSet> globalDescriptorSets (EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
         for (int i = 0; i < globalDescriptorSets.size(); i++) {
             auto bufferInfo = uboBuffers[i]->descriptorInfo ();
-            EngineDescriptorWriter(*globalSetLayout, *globalPool)
+            EngineDescriptorWriter(globalSetLayout, engineDevice.getDescriptorAllocator())
                 .writeBuffer (0, &bufferInfo)
-                .writeImage (1, &imageInfo)
                 .build (globalDescriptorSets[i]);
         }
 
-        system::SimpleRenderSystem simpleRenderSystem{engineDevice, engineRenderer.getSwapchainRenderpass(), globalSetLayout->getDescriptorSetLayout()};
-        system::PointLightSystem pointLightSystem{engineDevice, engineRenderer.getSwapchainRenderpass(), globalSetLayout->getDescriptorSetLayout()};
+        // Pipelines build on the workers while the rest of the scene is set up, systems wait on theirs when they first draw
+        EnginePipelineBuilder pipelineBuilder{engineDevice, jobSystem};
+        EngineParallelRecorder parallelRecorder{engineDevice, jobSystem};
+        system::LightClusterSystem lightClusterSystem{engineDevice, pipelineBuilder};
+        system::SimpleRenderSystem simpleRenderSystem{engineDevice, pipelineBuilder, engineRenderer.getSwapchainRenderpass(), globalSetLayout.getDescriptorSetLayout(), lightClusterSystem.getDescriptorSetLayout(), textureRegistry};
+        system::PointLightSystem pointLightSystem{engineDevice, pipelineBuilder, engineRenderer.getSwapchainRenderpass(), globalSetLayout.getDescriptorSetLayout()};
 
         EngineCamera camera {};
         camera.setViewTarget (glm::vec3(-1.0f, -2.0f, 2.0f), glm::vec3(0.0f, 0.0f, 2.5f));
@@ -71,16 +83,34 @@ namespace engine {
         viewerObject.transform.translation.z = -2.5f;
         KeyboardMovementController cameraController {};
 
+        auto &uploadManager = engineDevice.getUploadManager();
         auto currentTime = std::chrono::high_resolution_clock::now();
 
-        while (!engineWindow.shouldClose()) {
-            glfwPollEvents();
+        if (!settings.captureDirectory.empty())
+            std::filesystem::create_directories (settings.captureDirectory);
+
+        std::vector<PointLight> pointLights{};
+        std::vector<float> frameTimes{};
+        frameTimes.reserve (settings.frameCount);
+        auto runStart = currentTime;
+        uint32_t framesRendered = 0;
 
+        while (!engineWindow.shouldClose() && (settings.frameCount == 0 || framesRendered < settings.frameCount)) {
             auto newTime = std::chrono::high_resolution_clock::now();
             float frameTime =  std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
             currentTime = newTime;
 
-            cameraController.moveInPlaneXZ (engineWindow.getGLFWwindow(), frameTime, viewerObject);
+            if (settings.headless) {
+                if (framesRendered > 0)
+                    frameTimes.push_back (frameTime);
+                frameTime = HEADLESS_FRAME_TIME;
+                viewerObject.transform.rotation.y += HEADLESS_TURN_SPEED * frameTime;
+            } else {
+                glfwPollEvents();
+                cameraController.moveInPlaneXZ (engineWindow.getGLFWwindow(), frameTime, viewerObject);
+            }
+            uploadManager.beginFrame();
+            chunkStreamer->update (viewerObject.transform.translation, gameObjects);
             camera.setViewYXZ (viewerObject.transform.translation, viewerObject.transform.rotation);
 
             float aspect = engineRenderer.getAspectRatio();
@@ -89,13 +119,18 @@ namespace engine {
 
             if (auto commandBuffer = engineRenderer.beginFrame()) {
                 int frameIndex = engineRenderer.getFrameIndex();
+                textureRegistry.beginFrame (frameIndex);
+                // Only chunks whose uploads were already seen complete are drawn, so this never actually stalls
+                engineRenderer.waitForUploads (uploadManager.getSemaphore(), uploadManager.getCompletedValue());
                 EngineFrameInfo frameInfo{
                     frameIndex,
                     frameTime,
                     commandBuffer,
                     camera,
                     globalDescriptorSets[frameIndex],
-                    gameObjects
+                    gameObjects,
+                    engineRenderer.getGpuProfiler(),
+                    engineRenderer.getFrameDescriptorAllocator()
                 };
 
                 //update
@@ -103,27 +138,91 @@ namespace engine {
                 ubo.projection = camera.getProjection();
                 ubo.view = camera.getViewMatrix();
                 ubo.inverseView = camera.getInverseViewMatrix();
-                pointLightSystem.update (frameInfo, ubo);
+                pointLights.clear();
+                pointLightSystem.update (frameInfo, pointLights);
                 uboBuffers[frameIndex]->writeToBuffer (&ubo);
                 uboBuffers[frameIndex]->flush();
 
                 //render
-                engineRenderer.beginSwapChainRenderPass (commandBuffer);
-                simpleRenderSystem.renderGameObjects (frameInfo);
-                pointLightSystem.render (frameInfo);
+                simpleRenderSystem.cullGameObjects (frameInfo, engineRenderer.getDepthPyramid());
+                lightClusterSystem.buildClusters (frameInfo, pointLights, engineRenderer.getSwapchainExtent());
+
+                // The main pass is recorded into secondaries on the workers, the primary only executes them
+                parallelRecorder.beginFrame (frameIndex);
+                parallelRecorder.beginPass (engineRenderer.getSwapchainRenderpass(), engineRenderer.getCurrentFramebuffer(), engineRenderer.getSwapchainExtent());
+                simpleRenderSystem.recordGameObjects (frameInfo, lightClusterSystem.getDescriptorSet (frameIndex), parallelRecorder);
+                parallelRecorder.record (frameInfo, [&pointLightSystem] (EngineFrameInfo &secondaryInfo) {
+                    pointLightSystem.render (secondaryInfo);
+                });
+                engineRenderer.beginSwapChainRenderPass (commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                parallelRecorder.executePass (commandBuffer);
                 engineRenderer.endSwapChainRenderPass (commandBuffer);
+                engineRenderer.buildDepthPyramid (commandBuffer);
                 engineRenderer.endFrame();
+                framesRendered++;
+
+                if (settings.headless && !settings.captureDirectory.empty()) {
+                    bool lastFrame = framesRendered == settings.frameCount;
+                    bool onInterval = settings.captureInterval > 0 && framesRendered % settings.captureInterval == 0;
+                    if (lastFrame || onInterval) {
+                        captureFrame (framesRendered);
+                        // The readback stalls the GPU, keep it out of the next frame's time
+                        currentTime = std::chrono::high_resolution_clock::now();
+                    }
+                }
             }
         }
         vkDeviceWaitIdle (engineDevice.device());
+        // Builds nobody took still use the systems' layouts, which go before the builder does
+        pipelineBuilder.waitAll();
+
+        engineRenderer.getGpuProfiler().logStats();
+        if (!settings.profileOutput.empty() && engineRenderer.getGpuProfiler().writeReport (settings.profileOutput))
+            spdlog::get ("renderer")->info ("Wrote GPU profile to {}", settings.profileOutput);
+
+        if (settings.headless) {
+            double totalSeconds = std::chrono::duration<double, std::chrono::seconds::period>(std::chrono::high_resolution_clock::now() - runStart).count();
+            logFrameTimes (frameTimes, totalSeconds);
+        }
+    }
+
+    void FirstApp::captureFrame (uint32_t frameNumber) {
+        auto filename = fmt::format ("frame_{:05}.png", frameNumber);
+        auto filepath = (std::filesystem::path(settings.captureDirectory) / filename).string();
+        if (engineRenderer.saveFrame (filepath))
+            spdlog::get ("renderer")->info ("Saved frame {} to {}", frameNumber, filepath);
+    }
+
+    // Times are from one frame start to the next, the first frame is left out since it includes pipeline and scene warm up
+    void FirstApp::logFrameTimes (const std::vector<float> &frameTimes, double totalSeconds) const {
+        auto log = spdlog::get ("renderer");
+        if (frameTimes.empty()) {
+            log->info ("Headless run finished, not enough frames for timings");
+            return;
+        }
+
+        std::vector<float> sorted = frameTimes;
+        std::sort (sorted.begin(), sorted.end());
+        double average = std::accumulate (sorted.begin(), sorted.end(), 0.0) / sorted.size();
+        float median = sorted[sorted.size() / 2];
+        float percentile99 = sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)];
+
+        log->info ("Headless run: {} frames at {}x{} in {:.2f}s on {}",
+                   frameTimes.size() + 1,
+                   settings.width,
+                   settings.height,
+                   totalSeconds,
+                   engineDevice.properties.deviceName);
+        log->info ("  frame time avg {:.3f} ms, median {:.3f} ms, p99 {:.3f} ms, min {:.3f} ms, max {:.3f} ms, {:.1f} fps",
+                   average * 1000.0,
+                   median * 1000.0f,
+                   percentile99 * 1000.0f,
+                   sorted.front() * 1000.0f,
+                   sorted.back() * 1000.0f,
+                   1.0 / average);
     }
 
-    FirstApp::FirstApp () {
-        globalPool = EngineDescriptorPool::Builder(engineDevice)
-                .setMaxSets (EngineSwapChain::MAX_FRAMES_IN_FLIGHT)
-                .addPoolSize (VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, EngineSwapChain::MAX_FRAMES_IN_FLIGHT)
-                .addPoolSize (VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, EngineSwapChain::MAX_FRAMES_IN_FLIGHT)
-                .build();
+    FirstApp::FirstApp (const AppSettings &settings) : settings{settings} {
         loadGameObjects ();
     }
 
@@ -144,13 +243,9 @@ namespace engine {
         flatVase.transform.scale = {3.0f, 1.5f, 3.0f};
         gameObjects.emplace(flatVase.getId(), std::move(flatVase));
 
-        //engineModel = EngineModel::createModelFromFile (engineDevice, "assets/models/quad.obj");
-        engineModel = EngineModel::createModelFromNoise (engineDevice, 16, 16);
-        auto floor = EngineGameObject::createGameObject();
-        floor.model = engineModel;
-        floor.transform.translation = {-8.0f, 0.5f, -2.0f};
-        floor.transform.scale = {1.0f, 1.0f, 1.0f};
-        gameObjects.emplace(floor.getId(), std::move(floor));
+        // Terrain streams in around the viewer each frame, generated and meshed on the job system
+        terrainGenerator.surfaceY = 24.0f;
+        chunkStreamer = std::make_unique<voxel::VoxelChunkStreamer>(engineDevice, jobSystem, voxelWorld, terrainGenerator);
 
         std::vector<glm::vec3> lightColors{
                 {1.f, .1f, .1f},
@@ -11,15 +11,37 @@
 #include "engine_renderer.hpp"
 #include "engine_buffer.hpp"
 #include "engine_descriptors.hpp"
+#include "engine_job_system.hpp"
+#include "voxel/voxel_world.hpp"
+#include "voxel/voxel_generator.hpp"
+#include "voxel/voxel_chunk_streamer.hpp"
 
 // std
+#include <cstdint>
 #include <memory>
+#include <string>
+#include <vector>
 
 namespace engine {
 
+    struct AppSettings {
+        int width = 800;
+        int height = 600;
+        // Renders to offscreen images with no window, surface or swap chain, for benchmarking on machines without
+        // a display or GPU. The camera follows a fixed path at a fixed time step so every run draws the same frames
+        bool headless = false;
+        // Stop after this many frames, 0 runs until the window is closed. Headless always needs a count
+        uint32_t frameCount = 0;
+        // Headless only, the last frame and every captureInterval frames are saved here as PNG. Empty saves nothing
+        std::string captureDirectory{};
+        uint32_t captureInterval = 0;
+        // GPU timings of every profiler scope are written here as JSON on exit. Empty writes nothing
+        std::string profileOutput{};
+    };
+
     class FirstApp {
     public:
-        FirstApp ();
+        explicit FirstApp (const AppSettings &settings = {});
         virtual ~FirstApp ();
 
         FirstApp(const FirstApp &) = delete;
@@ -29,14 +51,22 @@ namespace engine {
 
     private:
         void loadGameObjects();
+        void captureFrame(uint32_t frameNumber);
+        void logFrameTimes(const std::vector<float> &frameTimes, double totalSeconds) const;
 
-        EngineWindow engineWindow{800, 600, "Hello Vulkan!"};
+        AppSettings settings;
+        EngineWindow engineWindow{settings.width, settings.height, "Hello Vulkan!", settings.headless};
         EngineDevice engineDevice{engineWindow};
         EngineRenderer engineRenderer{engineWindow, engineDevice};
 
         // note: order of declarations matter
-        std::unique_ptr<EngineDescriptorPool> globalPool{};
         EngineGameObject::Map gameObjects;
+
+        // chunk streamer must be destroyed first, its jobs reference the world and generator
+        EngineJobSystem jobSystem{};
+        voxel::VoxelWorld voxelWorld{};
+        voxel::VoxelTerrainGenerator terrainGenerator{};
+        std::unique_ptr<voxel::VoxelChunkStreamer> chunkStreamer{};
     };
 }
 
@@ -6,6 +6,54 @@
 
 #include <cstdlib>
 #include <stdexcept>
+#include <string>
+
+namespace {
+    constexpr uint32_t DEFAULT_HEADLESS_FRAMES = 600;
+
+    void printUsage() {
+        spdlog::info ("Usage: Engine_App [--headless] [--frames <count>] [--size <width>x<height>] [--capture <directory>] [--capture-every <frames>] [--profile <file>]");
+    }
+
+    // Returns false on anything it doesn't understand, the caller prints usage
+    bool parseArguments(int argc, char* argv[], engine::AppSettings &settings) {
+        for (int i = 1; i < argc; i++) {
+            std::string argument = argv[i];
+            bool hasValue = i + 1 < argc;
+
+            try {
+                if (argument == "--headless") {
+                    settings.headless = true;
+                } else if (argument == "--frames" && hasValue) {
+                    settings.frameCount = static_cast<uint32_t>(std::stoul (argv[++i]));
+                } else if (argument == "--size" && hasValue) {
+                    std::string size = argv[++i];
+                    auto separator = size.find ('x');
+                    if (separator == std::string::npos)
+                        return false;
+                    settings.width = std::stoi (size.substr (0, separator));
+                    settings.height = std::stoi (size.substr (separator + 1));
+                } else if (argument == "--capture" && hasValue) {
+                    settings.captureDirectory = argv[++i];
+                } else if (argument == "--capture-every" && hasValue) {
+                    settings.captureInterval = static_cast<uint32_t>(std::stoul (argv[++i]));
+                } else if (argument == "--profile" && hasValue) {
+                    settings.profileOutput = argv[++i];
+                } else {
+                    return false;
+                }
+            } catch (std::exception &) {
+                return false;
+            }
+        }
+
+        if (settings.width <= 0 || settings.height <= 0)
+            return false;
+        if (settings.headless && settings.frameCount == 0)
+            settings.frameCount = DEFAULT_HEADLESS_FRAMES;
+        return true;
+    }
+}
 
 int main(int argc, char* argv[]) {
     auto consoleSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
@@ -25,9 +73,15 @@ int main(int argc, char* argv[]) {
     spdlog::register_logger (spdlog::get ("main")->clone ("renderer"));
     spdlog::register_logger (spdlog::get ("main")->clone ("assets"));
 
+    engine::AppSettings settings{};
+    if (!parseArguments (argc, argv, settings)) {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
     try {
         logger.info("Starting Application");
-        engine::FirstApp app{};
+        engine::FirstApp app{settings};
 
         app.run();
         logger.info ("Stopping Application");
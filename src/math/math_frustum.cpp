@@ -0,0 +1,222 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "math_frustum.hpp"
+
+// std
+#include <bit>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define ENGINE_FRUSTUM_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// Only the AVX2 path is built for AVX2, the rest of the engine keeps the default target
+#if defined(__GNUC__) || defined(__clang__)
+#define ENGINE_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define ENGINE_TARGET_AVX2
+#endif
+
+namespace engine::math {
+
+    void BoundsArray::clear () {
+        minX.clear();
+        minY.clear();
+        minZ.clear();
+        maxX.clear();
+        maxY.clear();
+        maxZ.clear();
+    }
+
+    void BoundsArray::reserve (size_t count) {
+        minX.reserve (count);
+        minY.reserve (count);
+        minZ.reserve (count);
+        maxX.reserve (count);
+        maxY.reserve (count);
+        maxZ.reserve (count);
+    }
+
+    void BoundsArray::add (const glm::vec3 &boundsMin, const glm::vec3 &boundsMax) {
+        minX.push_back (boundsMin.x);
+        minY.push_back (boundsMin.y);
+        minZ.push_back (boundsMin.z);
+        maxX.push_back (boundsMax.x);
+        maxY.push_back (boundsMax.y);
+        maxZ.push_back (boundsMax.z);
+    }
+
+    namespace {
+        // A box is outside a plane when even its corner farthest along the normal is behind it. The normal is the same
+        // for every box, so which array holds that corner is picked once per plane instead of once per box
+        struct CullPlane {
+            const float *x;
+            const float *y;
+            const float *z;
+            float nx, ny, nz, d;
+        };
+
+        std::array<CullPlane, 6> selectCorners (const BoundsArray &bounds, const std::array<glm::vec4, 6> &planes) {
+            std::array<CullPlane, 6> cullPlanes{};
+            for (size_t p = 0; p < planes.size(); p++) {
+                const glm::vec4 &plane = planes[p];
+                cullPlanes[p] = {
+                        plane.x >= 0.0f ? bounds.maxX.data() : bounds.minX.data(),
+                        plane.y >= 0.0f ? bounds.maxY.data() : bounds.minY.data(),
+                        plane.z >= 0.0f ? bounds.maxZ.data() : bounds.minZ.data(),
+                        plane.x, plane.y, plane.z, plane.w};
+            }
+            return cullPlanes;
+        }
+
+        // The output is written unconditionally and the count only moves on for visible boxes, no branch to mispredict.
+        // The SIMD paths sum the distance in the same order with no fused multiply add, so they round exactly like this
+        // one and agree on boxes that only just touch a plane
+        size_t cullScalar (const std::array<CullPlane, 6> &planes, size_t begin, size_t end, uint32_t *visibleIndices, size_t count) {
+            for (size_t i = begin; i < end; i++) {
+                bool inside = true;
+                for (const auto &plane : planes) {
+                    inside &= plane.nx * plane.x[i] + plane.ny * plane.y[i] + plane.nz * plane.z[i] + plane.d >= 0.0f;
+                }
+                visibleIndices[count] = static_cast<uint32_t>(i);
+                count += inside ? 1 : 0;
+            }
+            return count;
+        }
+
+#ifdef ENGINE_FRUSTUM_X86
+        size_t cullSSE (const std::array<CullPlane, 6> &planes, size_t size, uint32_t *visibleIndices) {
+            __m128 nx[6], ny[6], nz[6], d[6];
+            for (size_t p = 0; p < 6; p++) {
+                nx[p] = _mm_set1_ps (planes[p].nx);
+                ny[p] = _mm_set1_ps (planes[p].ny);
+                nz[p] = _mm_set1_ps (planes[p].nz);
+                d[p] = _mm_set1_ps (planes[p].d);
+            }
+            const __m128 zero = _mm_setzero_ps();
+
+            size_t count = 0;
+            size_t i = 0;
+            for (; i + 4 <= size; i += 4) {
+                __m128 inside = _mm_castsi128_ps (_mm_set1_epi32 (-1));
+                for (size_t p = 0; p < 6; p++) {
+                    __m128 distance = _mm_add_ps (_mm_mul_ps (nx[p], _mm_loadu_ps (planes[p].x + i)), _mm_mul_ps (ny[p], _mm_loadu_ps (planes[p].y + i)));
+                    distance = _mm_add_ps (distance, _mm_mul_ps (nz[p], _mm_loadu_ps (planes[p].z + i)));
+                    distance = _mm_add_ps (distance, d[p]);
+                    inside = _mm_and_ps (inside, _mm_cmpge_ps (distance, zero));
+                }
+
+                auto mask = static_cast<uint32_t>(_mm_movemask_ps (inside));
+                while (mask != 0) {
+                    visibleIndices[count++] = static_cast<uint32_t>(i + std::countr_zero (mask));
+                    mask &= mask - 1;
+                }
+            }
+            return cullScalar (planes, i, size, visibleIndices, count);
+        }
+
+        ENGINE_TARGET_AVX2 size_t cullAVX2 (const std::array<CullPlane, 6> &planes, size_t size, uint32_t *visibleIndices) {
+            __m256 nx[6], ny[6], nz[6], d[6];
+            for (size_t p = 0; p < 6; p++) {
+                nx[p] = _mm256_set1_ps (planes[p].nx);
+                ny[p] = _mm256_set1_ps (planes[p].ny);
+                nz[p] = _mm256_set1_ps (planes[p].nz);
+                d[p] = _mm256_set1_ps (planes[p].d);
+            }
+            const __m256 zero = _mm256_setzero_ps();
+
+            size_t count = 0;
+            size_t i = 0;
+            for (; i + 8 <= size; i += 8) {
+                __m256 inside = _mm256_castsi256_ps (_mm256_set1_epi32 (-1));
+                for (size_t p = 0; p < 6; p++) {
+                    __m256 distance = _mm256_add_ps (_mm256_mul_ps (nx[p], _mm256_loadu_ps (planes[p].x + i)), _mm256_mul_ps (ny[p], _mm256_loadu_ps (planes[p].y + i)));
+                    distance = _mm256_add_ps (distance, _mm256_mul_ps (nz[p], _mm256_loadu_ps (planes[p].z + i)));
+                    distance = _mm256_add_ps (distance, d[p]);
+                    inside = _mm256_and_ps (inside, _mm256_cmp_ps (distance, zero, _CMP_GE_OQ));
+                }
+
+                auto mask = static_cast<uint32_t>(_mm256_movemask_ps (inside));
+                while (mask != 0) {
+                    visibleIndices[count++] = static_cast<uint32_t>(i + std::countr_zero (mask));
+                    mask &= mask - 1;
+                }
+            }
+            return cullScalar (planes, i, size, visibleIndices, count);
+        }
+#endif
+
+        bool cpuSupportsAVX2 () {
+#if defined(ENGINE_FRUSTUM_X86) && (defined(__GNUC__) || defined(__clang__))
+            __builtin_cpu_init();
+            return __builtin_cpu_supports ("avx2");
+#elif defined(ENGINE_FRUSTUM_X86) && defined(_MSC_VER)
+            int info[4];
+            __cpuid (info, 0);
+            if (info[0] < 7)
+                return false;
+
+            __cpuidex (info, 1, 0);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx = (info[2] & (1 << 28)) != 0;
+            // The OS also has to save the upper halves of the ymm registers
+            if (!osxsave || !avx || (_xgetbv (0) & 0x6) != 0x6)
+                return false;
+
+            __cpuidex (info, 7, 0);
+            return (info[1] & (1 << 5)) != 0;
+#else
+            return false;
+#endif
+        }
+    }
+
+    CullPath FrustumCuller::bestPath () {
+        static const CullPath path = [] {
+            if (cpuSupportsAVX2())
+                return CullPath::AVX2;
+#ifdef ENGINE_FRUSTUM_X86
+            return CullPath::SSE;
+#else
+            return CullPath::Scalar;
+#endif
+        }();
+        return path;
+    }
+
+    const char *FrustumCuller::pathName (CullPath path) {
+        switch (path) {
+            case CullPath::Scalar: return "scalar";
+            case CullPath::SSE: return "SSE";
+            case CullPath::AVX2: return "AVX2";
+        }
+        return "unknown";
+    }
+
+    size_t FrustumCuller::cull (const BoundsArray &bounds, const std::array<glm::vec4, 6> &planes, uint32_t *visibleIndices) {
+        return cull (bounds, planes, visibleIndices, bestPath());
+    }
+
+    size_t FrustumCuller::cull (const BoundsArray &bounds, const std::array<glm::vec4, 6> &planes, uint32_t *visibleIndices, CullPath path) {
+        auto cullPlanes = selectCorners (bounds, planes);
+
+#ifdef ENGINE_FRUSTUM_X86
+        // Asking for a path the CPU can't run falls back to the best one it can
+        if (path == CullPath::AVX2 && bestPath() != CullPath::AVX2)
+            path = bestPath();
+
+        switch (path) {
+            case CullPath::AVX2: return cullAVX2 (cullPlanes, bounds.size(), visibleIndices);
+            case CullPath::SSE: return cullSSE (cullPlanes, bounds.size(), visibleIndices);
+            case CullPath::Scalar: break;
+        }
+#endif
+        return cullScalar (cullPlanes, 0, bounds.size(), visibleIndices, 0);
+    }
+
+} // engine::math
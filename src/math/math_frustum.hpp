@@ -0,0 +1,57 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_MATH_FRUSTUM_HPP
+#define VULKANENGINE_MATH_FRUSTUM_HPP
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace engine::math {
+
+    /**
+     * Axis aligned boxes stored as one array per component, so a SIMD lane maps to one box and
+     * eight boxes load with a single instruction per component.
+     */
+    struct BoundsArray {
+        std::vector<float> minX{};
+        std::vector<float> minY{};
+        std::vector<float> minZ{};
+        std::vector<float> maxX{};
+        std::vector<float> maxY{};
+        std::vector<float> maxZ{};
+
+        [[nodiscard]] size_t size () const { return minX.size(); }
+        void clear ();
+        void reserve (size_t count);
+        void add (const glm::vec3 &boundsMin, const glm::vec3 &boundsMax);
+    };
+
+    enum class CullPath {
+        Scalar,
+        SSE,
+        AVX2
+    };
+
+    class FrustumCuller {
+    public:
+        // Widest path the CPU running this supports, checked once
+        static CullPath bestPath ();
+        static const char *pathName (CullPath path);
+
+        // Planes as returned by EngineCamera::getFrustumPlanes. Writes the index of every box that is at least
+        // partly inside all six planes to visibleIndices, which needs room for bounds.size() entries. Returns the count
+        static size_t cull (const BoundsArray &bounds, const std::array<glm::vec4, 6> &planes, uint32_t *visibleIndices);
+        static size_t cull (const BoundsArray &bounds, const std::array<glm::vec4, 6> &planes, uint32_t *visibleIndices, CullPath path);
+    };
+
+} // engine::math
+
+#endif //VULKANENGINE_MATH_FRUSTUM_HPP
@@ -0,0 +1,175 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "light_cluster_system.hpp"
+
+#include "../engine_swapchain.hpp"
+#include "../engine_gpu_profiler.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include "glm/glm.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <spdlog/spdlog.h>
+
+namespace engine::system {
+    // std140 layout of LightClusterData in light_cluster.comp and simple_shader.frag
+    struct LightClusterData {
+        glm::mat4 inverseProjection{1.0f};
+        glm::mat4 view{1.0f};
+        glm::uvec4 gridSize{0};         // w is the light count
+        glm::vec2 tileScale{0.0f};      // clusters per pixel
+        float sliceScale = 0.0f;        // slice = log(viewZ) * sliceScale + sliceBias
+        float sliceBias = 0.0f;
+        float near = 0.0f;
+        float far = 0.0f;
+    };
+
+    constexpr uint32_t INITIAL_LIGHT_CAPACITY = 64;
+    constexpr uint32_t CLUSTER_GROUP_SIZE = 128;
+
+    LightClusterSystem::LightClusterSystem (EngineDevice &device, EnginePipelineBuilder &pipelineBuilder) : engineDevice{device} {
+        createFrameResources();
+        createPipeline(pipelineBuilder);
+    }
+
+    LightClusterSystem::~LightClusterSystem () {
+        clusterPipeline.reset();
+        vkDestroyPipelineLayout (engineDevice.device(), pipelineLayout, nullptr);
+    }
+
+    void LightClusterSystem::createFrameResources () {
+        VkShaderStageFlags stages = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+        lightSetLayout = &EngineDescriptorSetLayout::Builder(engineDevice)
+                .addBinding (0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, stages)
+                .addBinding (1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+                .addBinding (2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+                .addBinding (3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, stages)
+                .build (engineDevice.getDescriptorLayoutCache());
+
+        frames.resize (EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (auto &frame : frames) {
+            frame.clusterBuffer = engineDevice.getFrameBufferPool().allocateOrCreate (sizeof (LightClusterData), 1);
+            frame.clusterBuffer->map();
+
+            frame.gridBuffer = std::make_unique<EngineBuffer>(
+                    engineDevice,
+                    sizeof (uint32_t),
+                    CLUSTER_COUNT,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+            frame.indexBuffer = std::make_unique<EngineBuffer>(
+                    engineDevice,
+                    sizeof (uint32_t),
+                    CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+            reserveLightCapacity (frame, INITIAL_LIGHT_CAPACITY);
+        }
+    }
+
+    void LightClusterSystem::reserveLightCapacity (FrameResources &frame, uint32_t lightCount) {
+        if (lightCount <= frame.lightCapacity)
+            return;
+
+        uint32_t capacity = std::max(frame.lightCapacity, INITIAL_LIGHT_CAPACITY);
+        while (capacity < lightCount)
+            capacity *= 2;
+
+        frame.lightBuffer = engineDevice.getFrameBufferPool().allocateOrCreate (sizeof (PointLight), capacity);
+        frame.lightBuffer->map();
+
+        auto clusterInfo = frame.clusterBuffer->descriptorInfo();
+        auto lightInfo = frame.lightBuffer->descriptorInfo();
+        auto gridInfo = frame.gridBuffer->descriptorInfo();
+        auto indexInfo = frame.indexBuffer->descriptorInfo();
+        EngineDescriptorWriter writer (*lightSetLayout, engineDevice.getDescriptorAllocator());
+        writer.writeBuffer (0, &clusterInfo)
+                .writeBuffer (1, &lightInfo)
+                .writeBuffer (2, &gridInfo)
+                .writeBuffer (3, &indexInfo);
+
+        if (frame.descriptorSet == VK_NULL_HANDLE) {
+            if (!writer.build (frame.descriptorSet)) {
+                spdlog::get ("vulkan")->critical ("Failed to allocate light cluster descriptor set");
+                throw std::runtime_error ("Failed to allocate light cluster descriptor set!");
+            }
+        } else {
+            writer.overwrite (frame.descriptorSet);
+        }
+
+        frame.lightCapacity = capacity;
+    }
+
+    void LightClusterSystem::createPipeline (EnginePipelineBuilder &pipelineBuilder) {
+        VkDescriptorSetLayout setLayout = lightSetLayout->getDescriptorSetLayout();
+
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo {};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCreateInfo.setLayoutCount = 1;
+        pipelineLayoutCreateInfo.pSetLayouts = &setLayout;
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
+        pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+
+        if (vkCreatePipelineLayout (engineDevice.device(), &pipelineLayoutCreateInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to create light cluster pipeline layout");
+            throw std::runtime_error ("Failed to create light cluster pipeline layout!");
+        }
+
+        pendingPipeline = pipelineBuilder.addCompute ("assets/shaders/light_cluster.comp.spv", pipelineLayout);
+    }
+
+    void LightClusterSystem::buildClusters (EngineFrameInfo &frameInfo, const std::vector<PointLight> &lights, VkExtent2D extent) {
+        auto &frame = frames[frameInfo.frameIndex];
+        auto lightCount = static_cast<uint32_t>(lights.size());
+
+        reserveLightCapacity (frame, lightCount);
+        if (lightCount > 0) {
+            std::copy (lights.begin(), lights.end(), static_cast<PointLight *>(frame.lightBuffer->getMappedMemory()));
+            frame.lightBuffer->flush (sizeof (PointLight) * lightCount);
+        }
+
+        // Slices are spaced exponentially so froxels stay roughly cube shaped from the near to the far plane
+        float near = frameInfo.camera.getNear();
+        float far = frameInfo.camera.getFar();
+        float depthRange = std::log (far / near);
+
+        LightClusterData clusterData{};
+        clusterData.inverseProjection = glm::inverse (frameInfo.camera.getProjection());
+        clusterData.view = frameInfo.camera.getViewMatrix();
+        clusterData.gridSize = glm::uvec4(CLUSTER_COUNT_X, CLUSTER_COUNT_Y, CLUSTER_COUNT_Z, lightCount);
+        clusterData.tileScale = glm::vec2(
+                static_cast<float>(CLUSTER_COUNT_X) / static_cast<float>(extent.width),
+                static_cast<float>(CLUSTER_COUNT_Y) / static_cast<float>(extent.height));
+        clusterData.sliceScale = static_cast<float>(CLUSTER_COUNT_Z) / depthRange;
+        clusterData.sliceBias = -static_cast<float>(CLUSTER_COUNT_Z) * std::log (near) / depthRange;
+        clusterData.near = near;
+        clusterData.far = far;
+        frame.clusterBuffer->writeToBuffer (&clusterData);
+        frame.clusterBuffer->flush();
+
+        VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+        EngineGpuProfiler::Scope scope{frameInfo.gpuProfiler, commandBuffer, "light_clusters"};
+
+        if (!clusterPipeline)
+            clusterPipeline = pendingPipeline.get();
+        clusterPipeline->bind (commandBuffer);
+        vkCmdBindDescriptorSets (commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &frame.descriptorSet, 0, nullptr);
+        vkCmdDispatch (commandBuffer, (CLUSTER_COUNT + CLUSTER_GROUP_SIZE - 1) / CLUSTER_GROUP_SIZE, 1, 1);
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier (commandBuffer,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                              0, 1, &barrier, 0, nullptr, 0, nullptr);
+    }
+
+} // engine::system
@@ -0,0 +1,79 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_LIGHT_CLUSTER_SYSTEM_HPP
+#define VULKANENGINE_LIGHT_CLUSTER_SYSTEM_HPP
+
+#include "../engine_pipeline.hpp"
+#include "../engine_pipeline_builder.hpp"
+#include "../engine_device.hpp"
+#include "../engine_frame_info.hpp"
+#include "../engine_buffer.hpp"
+#include "../engine_descriptors.hpp"
+
+// std
+#include <memory>
+#include <vector>
+
+namespace engine::system {
+
+    /**
+     * Clustered forward lighting. The view frustum is split into a grid of froxels, screen tiles sliced exponentially
+     * in depth, and a compute pass bins every point light whose range touches a froxel into that froxel's light list.
+     * Fragments then only light themselves with the lights of the froxel they fall in, so the cost follows how many
+     * lights overlap a pixel rather than how many there are.
+     */
+    class LightClusterSystem {
+    public:
+        static constexpr uint32_t CLUSTER_COUNT_X = 16;
+        static constexpr uint32_t CLUSTER_COUNT_Y = 9;
+        static constexpr uint32_t CLUSTER_COUNT_Z = 24;
+        static constexpr uint32_t CLUSTER_COUNT = CLUSTER_COUNT_X * CLUSTER_COUNT_Y * CLUSTER_COUNT_Z;
+        // Lights past this in a single froxel are dropped, has to match light_cluster.comp and simple_shader.frag
+        static constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128;
+
+        LightClusterSystem (EngineDevice &device, EnginePipelineBuilder &pipelineBuilder);
+        virtual ~LightClusterSystem ();
+
+        LightClusterSystem(const LightClusterSystem &) = delete;
+        LightClusterSystem operator=(const LightClusterSystem &) = delete;
+
+        // Uploads this frame's lights and records the pass that bins them into the grid of the frame's camera.
+        // Has to be recorded before the render pass begins
+        void buildClusters (EngineFrameInfo &frameInfo, const std::vector<PointLight> &lights, VkExtent2D extent);
+
+        // Lights, cluster grid and light lists, for the fragment shaders that read them
+        [[nodiscard]] VkDescriptorSetLayout getDescriptorSetLayout () const { return lightSetLayout->getDescriptorSetLayout(); }
+        [[nodiscard]] VkDescriptorSet getDescriptorSet (int frameIndex) const { return frames[frameIndex].descriptorSet; }
+
+    private:
+        struct FrameResources {
+            std::unique_ptr<EngineBuffer> clusterBuffer;
+            std::unique_ptr<EngineBuffer> lightBuffer;
+            std::unique_ptr<EngineBuffer> gridBuffer;
+            std::unique_ptr<EngineBuffer> indexBuffer;
+            VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+            uint32_t lightCapacity = 0;
+        };
+
+        void createFrameResources();
+        // Grows the light list and rewrites the slot's light set to match. Only the cluster pass and the forward pass of
+        // this slot bind the set, and neither is still executing by the time the slot is recorded again
+        void reserveLightCapacity(FrameResources &frame, uint32_t lightCount);
+        void createPipeline(EnginePipelineBuilder &pipelineBuilder);
+
+        EngineDevice &engineDevice;
+
+        // Owned by the device's layout cache, the sets come from its descriptor allocator
+        EngineDescriptorSetLayout *lightSetLayout = nullptr;
+        std::vector<FrameResources> frames;
+
+        EnginePendingPipeline<EngineComputePipeline> pendingPipeline;
+        std::unique_ptr<EngineComputePipeline> clusterPipeline;
+        VkPipelineLayout pipelineLayout;
+    };
+
+} // engine::system
+
+#endif //VULKANENGINE_LIGHT_CLUSTER_SYSTEM_HPP
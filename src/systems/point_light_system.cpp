@@ -5,47 +5,62 @@
 #include "point_light_system.hpp"
 
 #include "../first_app.hpp"
+#include "../engine_gpu_profiler.hpp"
+#include "../engine_swapchain.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include "glm/glm.hpp"
 #include "glm/gtc/constants.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstddef>
 #include <iostream>
 #include <spdlog/spdlog.h>
 
 namespace engine::system {
 
-    struct PointLightPushConstants {
-        glm::vec4 position{};
-        glm::vec4 color{};
-        float radius;
-    };
+    // Intensity a light is considered dark at, sets how far each light reaches for clustering
+    constexpr float LIGHT_CUTOFF = 0.005f;
+    constexpr uint32_t INITIAL_INSTANCE_CAPACITY = 64;
 
-    PointLightSystem::PointLightSystem (EngineDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : engineDevice{device} {
+    PointLightSystem::PointLightSystem (EngineDevice &device, EnginePipelineBuilder &pipelineBuilder, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : engineDevice{device} {
+        frames.resize (EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (auto &frame : frames) {
+            reserveFrameCapacity (frame, INITIAL_INSTANCE_CAPACITY);
+        }
         createPipelineLayout(globalSetLayout);
-        createPipeline(renderPass);
+        createPipeline(pipelineBuilder, renderPass);
     }
 
     PointLightSystem::~PointLightSystem () {
         vkDestroyPipelineLayout (engineDevice.device(), pipelineLayout, nullptr);
     }
 
-    void PointLightSystem::createPipelineLayout (VkDescriptorSetLayout globalSetLayout) {
-        VkPushConstantRange pushConstantRange {};
-        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pushConstantRange.offset = 0;
-        pushConstantRange.size = sizeof (PointLightPushConstants);
+    void PointLightSystem::reserveFrameCapacity (FrameResources &frame, uint32_t instanceCount) {
+        if (instanceCount <= frame.capacity)
+            return;
+
+        uint32_t capacity = std::max(frame.capacity, INITIAL_INSTANCE_CAPACITY);
+        while (capacity < instanceCount)
+            capacity *= 2;
+
+        frame.instanceBuffer = engineDevice.getFrameBufferPool().allocateOrCreate (sizeof (PointLightInstance), capacity);
+        frame.instanceBuffer->map();
+        frame.capacity = capacity;
+    }
 
+    void PointLightSystem::createPipelineLayout (VkDescriptorSetLayout globalSetLayout) {
         std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
 
         VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo {};
         pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
         pipelineLayoutCreateInfo.pSetLayouts = descriptorSetLayouts.data();
-        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
-        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
+        pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
 
         if (vkCreatePipelineLayout (engineDevice.device(), &pipelineLayoutCreateInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
             spdlog::get ("vulkan")->critical ("Failed to create pipeline layout");
@@ -54,25 +69,34 @@ namespace engine::system {
 
     }
 
-    void PointLightSystem::createPipeline (VkRenderPass renderPass) {
+    void PointLightSystem::createPipeline (EnginePipelineBuilder &pipelineBuilder, VkRenderPass renderPass) {
         assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-        PipelineConfigInfo pipelineConfig{};
-        EnginePipeline::defaultPipelineConfigInfo (pipelineConfig);
-        pipelineConfig.attributeDescriptions.clear ();
-        pipelineConfig.bindingDescriptions.clear();
-        pipelineConfig.renderPass = renderPass;
-        pipelineConfig.pipelineLayout = pipelineLayout;
-
-        enginePipeline = std::make_unique<EnginePipeline>(
-                engineDevice,
+        auto pipelineConfig = std::make_unique<PipelineConfigInfo>();
+        EnginePipeline::defaultPipelineConfigInfo (*pipelineConfig);
+        // The quad corners come from gl_VertexIndex, the only vertex input is each light's instance
+        pipelineConfig->bindingDescriptions = {{0, sizeof (PointLightInstance), VK_VERTEX_INPUT_RATE_INSTANCE}};
+        pipelineConfig->attributeDescriptions = {
+                {0, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(PointLightInstance, position))},
+                {1, 0, VK_FORMAT_R32G32B32A32_SFLOAT, static_cast<uint32_t>(offsetof(PointLightInstance, color))}};
+        pipelineConfig->renderPass = renderPass;
+        pipelineConfig->pipelineLayout = pipelineLayout;
+
+        pendingPipeline = pipelineBuilder.addGraphics (
                 "assets/shaders/point_light.vert.spv",
                 "assets/shaders/point_light.frag.spv",
-                pipelineConfig);
+                std::move (pipelineConfig));
 
     }
 
     void PointLightSystem::render (EngineFrameInfo &frameInfo) {
+        auto &frame = frames[frameInfo.frameIndex];
+        if (frame.instanceCount == 0)
+            return;
+
+        EngineGpuProfiler::Scope scope{frameInfo.gpuProfiler, frameInfo.commandBuffer, "point_lights"};
+        if (!enginePipeline)
+            enginePipeline = pendingPipeline.get();
         enginePipeline->bind (frameInfo.commandBuffer);
 
         vkCmdBindDescriptorSets (frameInfo.commandBuffer,
@@ -84,32 +108,17 @@ namespace engine::system {
                                  0,
                                  nullptr);
 
-        for (auto &kv: frameInfo.gameObjects) {
-            auto &obj = kv.second;
-            if (obj.pointLight == nullptr)
-                continue;
-
-            PointLightPushConstants push{};
-            push.position = glm::vec4(obj.transform.translation, 1.0f);
-            push.color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-            push.radius = obj.transform.scale.x;
-
-            vkCmdPushConstants (
-                    frameInfo.commandBuffer,
-                    pipelineLayout,
-                    VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                    0,
-                    sizeof (PointLightPushConstants),
-                    &push);
-
-            vkCmdDraw (frameInfo.commandBuffer, 6, 1, 0, 0);
-        }
+        VkBuffer buffers[] = {frame.instanceBuffer->getBuffer()};
+        VkDeviceSize offsets[] = {frame.instanceBuffer->getBufferOffset()};
+        vkCmdBindVertexBuffers (frameInfo.commandBuffer, 0, 1, buffers, offsets);
 
+        vkCmdDraw (frameInfo.commandBuffer, 6, frame.instanceCount, 0, 0);
     }
 
-    void PointLightSystem::update (EngineFrameInfo &frameInfo, GlobalUBO &ubo) {
+    void PointLightSystem::update (EngineFrameInfo &frameInfo, std::vector<PointLight> &lights) {
+        auto &frame = frames[frameInfo.frameIndex];
         auto rotateLight = glm::rotate (glm::mat4(1.0f), frameInfo.frameTime, {0.0f, -1.0f, 0.0f});
-        int lightIndex = 0;
+        instances.clear();
         for (auto& kv : frameInfo.gameObjects) {
             auto& obj = kv.second;
             if (obj.pointLight == nullptr)
@@ -117,12 +126,19 @@ namespace engine::system {
             // update light position
             obj.transform.translation = glm::vec3(rotateLight * glm::vec4(obj.transform.translation, 1.0f));
 
-            // copy light to UBO
-            ubo.pointLights[lightIndex].position = glm::vec4(obj.transform.translation, 1.0f);
-            ubo.pointLights[lightIndex].color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
+            // Inverse square falloff never reaches zero, the light is cut off where it would fall below LIGHT_CUTOFF
+            float range = std::sqrt (obj.pointLight->lightIntensity / LIGHT_CUTOFF);
+            glm::vec4 color{obj.color, obj.pointLight->lightIntensity};
+            lights.push_back ({glm::vec4(obj.transform.translation, range), color});
+            instances.push_back ({glm::vec4(obj.transform.translation, obj.transform.scale.x), color});
+        }
 
-            lightIndex += 1;
+        auto instanceCount = static_cast<uint32_t>(instances.size());
+        reserveFrameCapacity (frame, instanceCount);
+        if (instanceCount > 0) {
+            std::copy (instances.begin(), instances.end(), static_cast<PointLightInstance *>(frame.instanceBuffer->getMappedMemory()));
+            frame.instanceBuffer->flush (sizeof (PointLightInstance) * instanceCount);
         }
-        ubo.numLights = lightIndex;
+        frame.instanceCount = instanceCount;
     }
 } // engine::system
\ No newline at end of file
@@ -6,31 +6,60 @@
 #define VULKANENGINE_POINT_LIGHT_SYSTEM_HPP
 
 #include "../engine_pipeline.hpp"
+#include "../engine_pipeline_builder.hpp"
 #include "../engine_device.hpp"
 #include "../engine_game_object.hpp"
 #include "../engine_camera.hpp"
 #include "../engine_frame_info.hpp"
+#include "../engine_buffer.hpp"
+
+// std
+#include <memory>
+#include <vector>
 
 namespace engine::system {
 
     class PointLightSystem {
     public:
-        PointLightSystem (EngineDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        PointLightSystem (EngineDevice &device, EnginePipelineBuilder &pipelineBuilder, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
         virtual ~PointLightSystem();
 
         PointLightSystem(const PointLightSystem &) = delete;
         PointLightSystem operator=(const PointLightSystem &) = delete;
 
-        void update(EngineFrameInfo &frameInfo, GlobalUBO &ubo);
+        // Animates the lights, appends every one of them to lights for the cluster pass and fills this frame's billboards
+        void update(EngineFrameInfo &frameInfo, std::vector<PointLight> &lights);
+        // Every light's billboard in a single instanced draw
         void render (EngineFrameInfo &frameInfo);
 
 
     private:
+        // Per instance vertex input of point_light.vert
+        struct PointLightInstance {
+            glm::vec4 position{};   // w is the billboard radius
+            glm::vec4 color{};      // w is intensity
+        };
+
+        struct FrameResources {
+            std::unique_ptr<EngineBuffer> instanceBuffer;
+            uint32_t capacity = 0;
+            uint32_t instanceCount = 0;
+        };
+
+        // Doubles the slot's instance buffer until it fits. The old buffer can go at once, the draw that last read it
+        // was in this slot's previous submission, which its fence has already waited for
+        void reserveFrameCapacity(FrameResources &frame, uint32_t instanceCount);
         void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-        void createPipeline(VkRenderPass renderPass);
+        void createPipeline(EnginePipelineBuilder &pipelineBuilder, VkRenderPass renderPass);
 
         EngineDevice &engineDevice;
 
+        std::vector<FrameResources> frames;
+        // Scratch kept between frames so it only allocates when lights are added
+        std::vector<PointLightInstance> instances{};
+
+        // Taken from the builder the first time the lights are drawn
+        EnginePendingPipeline<EnginePipeline> pendingPipeline;
         std::unique_ptr<EnginePipeline> enginePipeline;
         VkPipelineLayout pipelineLayout;
     };
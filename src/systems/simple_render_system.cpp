@@ -5,45 +5,146 @@
 #include "simple_render_system.hpp"
 
 #include "../first_app.hpp"
+#include "../engine_swapchain.hpp"
+#include "../engine_mesh_heap.hpp"
+#include "../engine_gpu_profiler.hpp"
 
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
 #include "glm/glm.hpp"
 #include "glm/gtc/constants.hpp"
 
+#include <algorithm>
 #include <chrono>
 #include <iostream>
 #include <spdlog/spdlog.h>
 
 namespace engine::system {
-    struct SimplePushConstantData {
+    // std430 layout of ObjectBuffer in simple_shader.vert and cull.comp
+    struct SimpleObjectData {
         glm::mat4 modelMatrix {1.0f};
         glm::mat4 normalMatrix{1.0f};
+        glm::vec4 boundsCenter{0.0f};   // model space, w unused
+        glm::vec4 boundsExtent{0.0f};
+        uint32_t textureIndex = 0;   // into the bindless texture array
+        uint32_t textureArrayIndex = EngineTextureRegistry::NO_TEXTURE_ARRAY;
+        uint32_t padding[2]{};
     };
 
-    SimpleRenderSystem::SimpleRenderSystem (EngineDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout) : engineDevice{device} {
-        createPipelineLayout(globalSetLayout);
-        createPipeline(renderPass);
+    // std140 layout of CullData in cull.comp
+    struct SimpleCullData {
+        glm::mat4 previousViewProjection{1.0f};
+        glm::vec4 frustumPlanes[6]{};
+        glm::vec2 pyramidSize{0.0f};
+        uint32_t drawCount = 0;
+        uint32_t occlusionEnabled = 0;
+        uint32_t pyramidLevelCount = 0;
+        uint32_t partitionSize = 0;
+    };
+
+    constexpr uint32_t INITIAL_OBJECT_CAPACITY = 1024;
+    constexpr uint32_t CULL_GROUP_SIZE = 64;
+    // The visible list is split into partitions with their own count, each drawn from its own secondary command buffer
+    constexpr uint32_t MAX_DRAW_PARTITIONS = 8;
+    constexpr uint32_t MIN_DRAWS_PER_PARTITION = 256;
+
+    SimpleRenderSystem::SimpleRenderSystem (EngineDevice &device, EnginePipelineBuilder &pipelineBuilder, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout lightSetLayout, EngineTextureRegistry &textureRegistry) : engineDevice{device}, textureRegistry{textureRegistry} {
+        createObjectResources();
+        createPipelineLayout(globalSetLayout, lightSetLayout);
+        createPipelines(pipelineBuilder, renderPass);
+        createCullPipeline(pipelineBuilder);
     }
 
     SimpleRenderSystem::~SimpleRenderSystem () {
+        cullPipeline.reset();
+        vkDestroyPipelineLayout (engineDevice.device(), cullPipelineLayout, nullptr);
         vkDestroyPipelineLayout (engineDevice.device(), pipelineLayout, nullptr);
     }
 
-    void SimpleRenderSystem::createPipelineLayout (VkDescriptorSetLayout globalSetLayout) {
-        VkPushConstantRange pushConstantRange {};
-        pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
-        pushConstantRange.offset = 0;
-        pushConstantRange.size = sizeof (SimplePushConstantData);
+    void SimpleRenderSystem::createObjectResources () {
+        auto &layoutCache = engineDevice.getDescriptorLayoutCache();
+        // Binding 1 is the face heap, voxel_face.vert pulls its quads straight out of it
+        objectSetLayout = &EngineDescriptorSetLayout::Builder(engineDevice)
+                .addBinding (0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+                .addBinding (1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+                .build (layoutCache);
+
+        cullSetLayout = &EngineDescriptorSetLayout::Builder(engineDevice)
+                .addBinding (0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                .addBinding (1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                .addBinding (2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                .addBinding (3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                .addBinding (4, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)
+                .addBinding (5, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)
+                .build (layoutCache);
+
+        frames.resize (EngineSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (auto &frame : frames) {
+            // Rounding each group up to whole partitions can cost at most one extra partition per group after the first
+            frame.countBuffer = std::make_unique<EngineBuffer>(
+                    engineDevice,
+                    sizeof (uint32_t),
+                    MAX_DRAW_PARTITIONS + DRAW_GROUP_COUNT - 1,
+                    VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                    VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+            frame.cullBuffer = engineDevice.getFrameBufferPool().allocateOrCreate (sizeof (SimpleCullData), 1);
+            frame.cullBuffer->map();
+
+            reserveFrameCapacity (frame, INITIAL_OBJECT_CAPACITY);
+        }
+    }
+
+    void SimpleRenderSystem::reserveFrameCapacity (FrameResources &frame, uint32_t objectCount) {
+        if (objectCount <= frame.capacity)
+            return;
 
-        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout};
+        uint32_t capacity = std::max(frame.capacity, INITIAL_OBJECT_CAPACITY);
+        while (capacity < objectCount)
+            capacity *= 2;
+
+        // Both grow with the scene, past what the pool holds they get their own buffers
+        auto &bufferPool = engineDevice.getFrameBufferPool();
+        frame.objectBuffer = bufferPool.allocateOrCreate (sizeof (SimpleObjectData), capacity);
+        frame.objectBuffer->map();
+
+        frame.candidateBuffer = bufferPool.allocateOrCreate (sizeof (VkDrawIndexedIndirectCommand), capacity);
+        frame.candidateBuffer->map();
+
+        frame.visibleBuffer = std::make_unique<EngineBuffer>(
+                engineDevice,
+                sizeof (VkDrawIndexedIndirectCommand),
+                capacity,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        auto objectInfo = frame.objectBuffer->descriptorInfo();
+        auto faceInfo = engineDevice.getVoxelFaceHeap().getVertexDescriptorInfo();
+        EngineDescriptorWriter objectWriter (*objectSetLayout, engineDevice.getDescriptorAllocator());
+        objectWriter.writeBuffer (0, &objectInfo)
+                .writeBuffer (1, &faceInfo);
+
+        if (frame.objectDescriptorSet == VK_NULL_HANDLE) {
+            if (!objectWriter.build (frame.objectDescriptorSet)) {
+                spdlog::get ("vulkan")->critical ("Failed to allocate object descriptor set");
+                throw std::runtime_error ("Failed to allocate object descriptor set!");
+            }
+        } else {
+            objectWriter.overwrite (frame.objectDescriptorSet);
+        }
+
+        frame.capacity = capacity;
+    }
+
+    void SimpleRenderSystem::createPipelineLayout (VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout lightSetLayout) {
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalSetLayout, objectSetLayout->getDescriptorSetLayout(), lightSetLayout, textureRegistry.getDescriptorSetLayout()};
 
         VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo {};
         pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size());
         pipelineLayoutCreateInfo.pSetLayouts = descriptorSetLayouts.data();
-        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
-        pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
+        pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
 
         if (vkCreatePipelineLayout (engineDevice.device(), &pipelineLayoutCreateInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
             spdlog::get ("vulkan")->critical ("Failed to create pipeline layout");
@@ -52,48 +153,297 @@ namespace engine::system {
 
     }
 
-    void SimpleRenderSystem::createPipeline (VkRenderPass renderPass) {
+    void SimpleRenderSystem::createPipelines (EnginePipelineBuilder &pipelineBuilder, VkRenderPass renderPass) {
         assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-        PipelineConfigInfo pipelineConfig{};
-        EnginePipeline::defaultPipelineConfigInfo (pipelineConfig);
-        pipelineConfig.renderPass = renderPass;
-        pipelineConfig.pipelineLayout = pipelineLayout;
+        auto pipelineConfig = std::make_unique<PipelineConfigInfo>();
+        EnginePipeline::defaultPipelineConfigInfo (*pipelineConfig);
+        pipelineConfig->renderPass = renderPass;
+        pipelineConfig->pipelineLayout = pipelineLayout;
+
+        pendingPipelines[STANDARD_PIPELINE] = pipelineBuilder.addGraphics ("assets/shaders/simple_shader.vert.spv", "assets/shaders/simple_shader.frag.spv", std::move (pipelineConfig));
 
-        enginePipeline = std::make_unique<EnginePipeline>(engineDevice, "assets/shaders/simple_shader.vert.spv", "assets/shaders/simple_shader.frag.spv", pipelineConfig);
+        // Same fragment stage, the vertex shader unpacks the position, normal and UV from the two packed words
+        auto voxelPipelineConfig = std::make_unique<PipelineConfigInfo>();
+        EnginePipeline::defaultPipelineConfigInfo (*voxelPipelineConfig);
+        voxelPipelineConfig->renderPass = renderPass;
+        voxelPipelineConfig->pipelineLayout = pipelineLayout;
+        voxelPipelineConfig->bindingDescriptions = EngineModel::PackedVoxelVertex::getBindingDescriptions();
+        voxelPipelineConfig->attributeDescriptions = EngineModel::PackedVoxelVertex::getAttributeDescriptions();
 
+        pendingPipelines[VOXEL_PIPELINE] = pipelineBuilder.addGraphics ("assets/shaders/voxel_shader.vert.spv", "assets/shaders/simple_shader.frag.spv", std::move (voxelPipelineConfig));
+
+        // No vertex input at all, the shader reads the face records from the object set by gl_VertexIndex
+        auto facePipelineConfig = std::make_unique<PipelineConfigInfo>();
+        EnginePipeline::defaultPipelineConfigInfo (*facePipelineConfig);
+        facePipelineConfig->renderPass = renderPass;
+        facePipelineConfig->pipelineLayout = pipelineLayout;
+        facePipelineConfig->bindingDescriptions.clear();
+        facePipelineConfig->attributeDescriptions.clear();
+
+        pendingPipelines[VOXEL_FACE_PIPELINE] = pipelineBuilder.addGraphics ("assets/shaders/voxel_face.vert.spv", "assets/shaders/simple_shader.frag.spv", std::move (facePipelineConfig));
+    }
+
+    void SimpleRenderSystem::createCullPipeline (EnginePipelineBuilder &pipelineBuilder) {
+        VkDescriptorSetLayout setLayout = cullSetLayout->getDescriptorSetLayout();
+
+        VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo {};
+        pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutCreateInfo.setLayoutCount = 1;
+        pipelineLayoutCreateInfo.pSetLayouts = &setLayout;
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
+        pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+
+        if (vkCreatePipelineLayout (engineDevice.device(), &pipelineLayoutCreateInfo, nullptr, &cullPipelineLayout) != VK_SUCCESS) {
+            spdlog::get ("vulkan")->critical ("Failed to create cull pipeline layout");
+            throw std::runtime_error ("Failed to create cull pipeline layout!");
+        }
+
+        pendingCullPipeline = pipelineBuilder.addCompute ("assets/shaders/cull.comp.spv", cullPipelineLayout);
     }
 
-    void SimpleRenderSystem::renderGameObjects (EngineFrameInfo &frameInfo) {
-        enginePipeline->bind (frameInfo.commandBuffer);
+    void SimpleRenderSystem::cullGameObjects (EngineFrameInfo &frameInfo, const EngineDepthPyramid &depthPyramid) {
+        auto &frame = frames[frameInfo.frameIndex];
+        auto frustumPlanes = frameInfo.camera.getFrustumPlanes();
+
+        // Coarse frustum pass on the CPU first, so objects behind the camera never reach the object buffer.
+        // World space boxes from each model box and transform, the centre moves with the matrix and the
+        // extent grows by the absolute value of its rotation and scale
+        worldBounds.clear();
+        cullCandidates.clear();
+        for (auto& kv : frameInfo.gameObjects) {
+            auto& obj = kv.second;
+
+            if (obj.model == nullptr || obj.model->getIndexCount() == 0) continue;
+
+            glm::mat4 modelMatrix = obj.transform.mat4();
+            glm::vec3 center = (obj.model->getBoundsMin() + obj.model->getBoundsMax()) * 0.5f;
+            glm::vec3 extent = (obj.model->getBoundsMax() - obj.model->getBoundsMin()) * 0.5f;
+            glm::vec3 worldCenter = glm::vec3(modelMatrix * glm::vec4(center, 1.0f));
+            glm::vec3 worldExtent = glm::abs(glm::vec3(modelMatrix[0])) * extent.x
+                                    + glm::abs(glm::vec3(modelMatrix[1])) * extent.y
+                                    + glm::abs(glm::vec3(modelMatrix[2])) * extent.z;
+
+            worldBounds.add (worldCenter - worldExtent, worldCenter + worldExtent);
+            cullCandidates.push_back (&obj);
+        }
+
+        visibleIndices.resize (cullCandidates.size());
+        size_t visibleCount = math::FrustumCuller::cull (worldBounds, frustumPlanes, visibleIndices.data());
+
+        for (auto &objects : groupObjects)
+            objects.clear();
+        for (size_t i = 0; i < visibleCount; i++) {
+            auto *obj = cullCandidates[visibleIndices[i]];
+            groupObjects[drawGroupFor (*obj->model)].push_back (obj);
+        }
 
+        // Partitions are sized over every group, then each group is rounded up to whole partitions
+        uint32_t partitionSize = std::max (MIN_DRAWS_PER_PARTITION, (static_cast<uint32_t>(visibleCount) + MAX_DRAW_PARTITIONS - 1) / MAX_DRAW_PARTITIONS);
+        uint32_t partitionCount = 0;
+        uint32_t slotCount = 0;
+        for (uint32_t group = 0; group < DRAW_GROUP_COUNT; group++) {
+            auto groupDrawCount = static_cast<uint32_t>(groupObjects[group].size());
+            frame.groupDrawCounts[group] = groupDrawCount;
+            frame.groupFirstPartitions[group] = partitionCount;
+            frame.groupPartitionCounts[group] = (groupDrawCount + partitionSize - 1) / partitionSize;
+            partitionCount += frame.groupPartitionCounts[group];
+            if (groupDrawCount > 0)
+                slotCount = frame.groupFirstPartitions[group] * partitionSize + groupDrawCount;
+        }
+
+        reserveFrameCapacity (frame, slotCount);
+
+        // Each object is just its matrices, bounds and a draw command, the GPU pass decides what actually gets drawn
+        auto *objects = static_cast<SimpleObjectData *>(frame.objectBuffer->getMappedMemory());
+        auto *commands = static_cast<VkDrawIndexedIndirectCommand *>(frame.candidateBuffer->getMappedMemory());
+
+        for (uint32_t group = 0; group < DRAW_GROUP_COUNT; group++) {
+            uint32_t slot = frame.groupFirstPartitions[group] * partitionSize;
+            for (auto *obj : groupObjects[group]) {
+                const glm::vec3 &boundsMin = obj->model->getBoundsMin();
+                const glm::vec3 &boundsMax = obj->model->getBoundsMax();
+                objects[slot].modelMatrix = obj->transform.mat4();
+                objects[slot].normalMatrix = obj->transform.normalMatrix();
+                objects[slot].boundsCenter = glm::vec4((boundsMin + boundsMax) * 0.5f, 1.0f);
+                objects[slot].boundsExtent = glm::vec4((boundsMax - boundsMin) * 0.5f, 0.0f);
+                objects[slot].textureIndex = obj->textureIndex;
+                objects[slot].textureArrayIndex = obj->textureArrayIndex;
+                commands[slot] = obj->model->getDrawCommand (slot);
+                slot++;
+            }
+
+            // Padding up to the next group's first partition, the cull pass skips commands without instances
+            uint32_t groupEnd = std::min (slotCount, (frame.groupFirstPartitions[group] + frame.groupPartitionCounts[group]) * partitionSize);
+            for (; slot < groupEnd; slot++)
+                commands[slot] = VkDrawIndexedIndirectCommand{};
+        }
+
+        uint32_t drawCount = slotCount;
+        frame.drawCount = drawCount;
+        frame.partitionSize = partitionSize;
+        glm::mat4 viewProjection = frameInfo.camera.getProjection() * frameInfo.camera.getViewMatrix();
+        if (drawCount == 0) {
+            previousViewProjection = viewProjection;
+            hasPreviousViewProjection = true;
+            return;
+        }
+
+        frame.objectBuffer->flush (sizeof (SimpleObjectData) * drawCount);
+        frame.candidateBuffer->flush (sizeof (VkDrawIndexedIndirectCommand) * drawCount);
+
+        SimpleCullData cullData{};
+        std::copy (frustumPlanes.begin(), frustumPlanes.end(), cullData.frustumPlanes);
+        cullData.previousViewProjection = previousViewProjection;
+        cullData.pyramidSize = glm::vec2(depthPyramid.getExtent().width, depthPyramid.getExtent().height);
+        cullData.drawCount = drawCount;
+        cullData.occlusionEnabled = depthPyramid.isBuilt() && hasPreviousViewProjection ? 1 : 0;
+        cullData.pyramidLevelCount = depthPyramid.getLevelCount();
+        cullData.partitionSize = frame.partitionSize;
+        frame.cullBuffer->writeToBuffer (&cullData);
+        frame.cullBuffer->flush();
+
+        // Allocated for this frame only, so it always sees the current buffers and the pyramid recreated with the swap chain
+        auto objectInfo = frame.objectBuffer->descriptorInfo();
+        auto candidateInfo = frame.candidateBuffer->descriptorInfo();
+        auto visibleInfo = frame.visibleBuffer->descriptorInfo();
+        auto countInfo = frame.countBuffer->descriptorInfo();
+        auto cullInfo = frame.cullBuffer->descriptorInfo();
+        VkDescriptorImageInfo pyramidInfo{};
+        pyramidInfo.sampler = depthPyramid.getSampler();
+        pyramidInfo.imageView = depthPyramid.getImageView();
+        pyramidInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+        VkDescriptorSet cullDescriptorSet;
+        bool cullSetBuilt = EngineDescriptorWriter(*cullSetLayout, frameInfo.frameDescriptors)
+                .writeBuffer (0, &objectInfo)
+                .writeBuffer (1, &candidateInfo)
+                .writeBuffer (2, &visibleInfo)
+                .writeBuffer (3, &countInfo)
+                .writeBuffer (4, &cullInfo)
+                .writeImage (5, &pyramidInfo)
+                .build (cullDescriptorSet);
+        if (!cullSetBuilt) {
+            spdlog::get ("vulkan")->critical ("Failed to allocate cull descriptor set");
+            throw std::runtime_error ("Failed to allocate cull descriptor set!");
+        }
+
+        VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+        EngineGpuProfiler::Scope scope{frameInfo.gpuProfiler, commandBuffer, "cull"};
+        vkCmdFillBuffer (commandBuffer, frame.countBuffer->getBuffer(), frame.countBuffer->getBufferOffset(), frame.countBuffer->getBufferSize(), 0);
+
+        // Covers the count reset and the last frame's pyramid build
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier (commandBuffer,
+                              VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        if (!cullPipeline)
+            cullPipeline = pendingCullPipeline.get();
+        cullPipeline->bind (commandBuffer);
+        vkCmdBindDescriptorSets (commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipelineLayout, 0, 1, &cullDescriptorSet, 0, nullptr);
+        vkCmdDispatch (commandBuffer, (drawCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        vkCmdPipelineBarrier (commandBuffer,
+                              VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                              VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT,
+                              0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        previousViewProjection = viewProjection;
+        hasPreviousViewProjection = true;
+    }
+
+    void SimpleRenderSystem::recordGameObjects (EngineFrameInfo &frameInfo, VkDescriptorSet lightDescriptorSet, EngineParallelRecorder &recorder) {
+        auto &frame = frames[frameInfo.frameIndex];
+        if (frame.drawCount == 0)
+            return;
+
+        for (uint32_t groupIndex = 0; groupIndex < DRAW_GROUP_COUNT; groupIndex++) {
+            auto group = static_cast<DrawGroup>(groupIndex);
+            if (frame.groupDrawCounts[group] == 0)
+                continue;
+
+            // Taken here on the render thread, the partitions only read it
+            PipelineKind pipeline = pipelineFor (group);
+            if (!pipelines[pipeline])
+                pipelines[pipeline] = pendingPipelines[pipeline].get();
+
+            for (uint32_t i = 0; i < frame.groupPartitionCounts[group]; i++) {
+                uint32_t partition = frame.groupFirstPartitions[group] + i;
+                recorder.record (frameInfo, [this, lightDescriptorSet, group, partition] (EngineFrameInfo &secondaryInfo) {
+                    renderPartition (secondaryInfo, lightDescriptorSet, group, partition);
+                });
+            }
+        }
+    }
+
+    void SimpleRenderSystem::renderPartition (EngineFrameInfo &frameInfo, VkDescriptorSet lightDescriptorSet, DrawGroup group, uint32_t partition) {
+        const auto &frame = frames[frameInfo.frameIndex];
+        uint32_t firstDraw = partition * frame.partitionSize;
+        uint32_t groupEnd = frame.groupFirstPartitions[group] * frame.partitionSize + frame.groupDrawCounts[group];
+        uint32_t maxDrawCount = std::min(frame.partitionSize, groupEnd - firstDraw);
+
+        PipelineKind pipeline = pipelineFor (group);
+        EngineGpuProfiler::Scope scope{frameInfo.gpuProfiler, frameInfo.commandBuffer, pipeline == STANDARD_PIPELINE ? "simple_render" : "voxel_render"};
+        pipelines[pipeline]->bind (frameInfo.commandBuffer);
+
+        // The texture array is the same for every draw, each object picks its own texture out of it
+        VkDescriptorSet descriptorSets[] = {frameInfo.globalDescriptorSet, frame.objectDescriptorSet, lightDescriptorSet, textureRegistry.getDescriptorSet()};
         vkCmdBindDescriptorSets (frameInfo.commandBuffer,
                                  VK_PIPELINE_BIND_POINT_GRAPHICS,
                                  pipelineLayout,
                                  0,
-                                 1,
-                                 &frameInfo.globalDescriptorSet,
+                                 4,
+                                 descriptorSets,
                                  0,
                                  nullptr);
 
-        for (auto& kv : frameInfo.gameObjects) {
-            auto& obj = kv.second;
+        // Face draws only use the index buffer from this, their shared quad pattern
+        meshHeapFor (group).bind (frameInfo.commandBuffer, indexTypeFor (group));
+
+        // The cull pass packs each partition's survivors at the start of its range and counts them separately
+        vkCmdDrawIndexedIndirectCount (
+                frameInfo.commandBuffer,
+                frame.visibleBuffer->getBuffer(),
+                frame.visibleBuffer->getBufferOffset() + static_cast<VkDeviceSize>(firstDraw) * sizeof (VkDrawIndexedIndirectCommand),
+                frame.countBuffer->getBuffer(),
+                frame.countBuffer->getBufferOffset() + static_cast<VkDeviceSize>(partition) * sizeof (uint32_t),
+                std::min(maxDrawCount, engineDevice.properties.limits.maxDrawIndirectCount),
+                sizeof (VkDrawIndexedIndirectCommand));
+    }
+
+    SimpleRenderSystem::DrawGroup SimpleRenderSystem::drawGroupFor (const EngineModel &model) {
+        bool shortIndices = model.getIndexType() == VK_INDEX_TYPE_UINT16;
+        switch (model.getVertexFormat()) {
+            case EngineModel::VertexFormat::PackedVoxel: return shortIndices ? VOXEL_DRAWS_16 : VOXEL_DRAWS;
+            case EngineModel::VertexFormat::VoxelFaces: return VOXEL_FACE_DRAWS;
+            default: return shortIndices ? STANDARD_DRAWS_16 : STANDARD_DRAWS;
+        }
+    }
+
+    SimpleRenderSystem::PipelineKind SimpleRenderSystem::pipelineFor (DrawGroup group) {
+        switch (group) {
+            case VOXEL_DRAWS:
+            case VOXEL_DRAWS_16: return VOXEL_PIPELINE;
+            case VOXEL_FACE_DRAWS: return VOXEL_FACE_PIPELINE;
+            default: return STANDARD_PIPELINE;
+        }
+    }
+
+    VkIndexType SimpleRenderSystem::indexTypeFor (DrawGroup group) {
+        return group == STANDARD_DRAWS_16 || group == VOXEL_DRAWS_16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    }
 
-            if (obj.model == nullptr) continue;
-
-            SimplePushConstantData push {};
-            push.modelMatrix = obj.transform.mat4();
-            push.normalMatrix = obj.transform.normalMatrix();
-
-            vkCmdPushConstants (
-                    frameInfo.commandBuffer,
-                    pipelineLayout,
-                    VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
-                    0,
-                    sizeof (SimplePushConstantData),
-                    &push);
-            obj.model->bind (frameInfo.commandBuffer);
-            obj.model->draw (frameInfo.commandBuffer);
+    EngineMeshHeap &SimpleRenderSystem::meshHeapFor (DrawGroup group) const {
+        switch (pipelineFor (group)) {
+            case VOXEL_PIPELINE: return engineDevice.getVoxelMeshHeap();
+            case VOXEL_FACE_PIPELINE: return engineDevice.getVoxelFaceHeap();
+            default: return engineDevice.getMeshHeap();
         }
     }
-} // engine::system
+} // engine::system
\ No newline at end of file
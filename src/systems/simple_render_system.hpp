@@ -6,34 +6,120 @@
 #define VULKANENGINE_SIMPLE_RENDER_SYSTEM_HPP
 
 #include "../engine_pipeline.hpp"
+#include "../engine_pipeline_builder.hpp"
+#include "../engine_parallel_recorder.hpp"
 #include "../engine_device.hpp"
 #include "../engine_game_object.hpp"
 #include "../engine_camera.hpp"
 #include "../engine_frame_info.hpp"
+#include "../engine_buffer.hpp"
+#include "../engine_descriptors.hpp"
+#include "../engine_texture_registry.hpp"
+#include "../engine_depth_pyramid.hpp"
+#include "../math/math_frustum.hpp"
 
 // std
+#include <array>
 #include <memory>
+#include <vector>
 
 namespace engine::system {
     class SimpleRenderSystem {
     public:
-        SimpleRenderSystem (EngineDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
+        SimpleRenderSystem (EngineDevice &device, EnginePipelineBuilder &pipelineBuilder, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout lightSetLayout, EngineTextureRegistry &textureRegistry);
         virtual ~SimpleRenderSystem ();
 
         SimpleRenderSystem(const SimpleRenderSystem &) = delete;
         SimpleRenderSystem operator=(const SimpleRenderSystem &) = delete;
 
-        void renderGameObjects (EngineFrameInfo &frameInfo);
+        // Frustum culls the objects on the CPU, writes the transform and draw of every survivor, then records the compute
+        // pass that frustum and occlusion culls them into this frame's visible list. Has to be recorded before the render pass begins
+        void cullGameObjects (EngineFrameInfo &frameInfo, const EngineDepthPyramid &depthPyramid);
+        // Draws whatever survived cullGameObjects, lit by the clustered lights in lightDescriptorSet. Each partition of the
+        // visible list is one indirect count draw recorded into its own secondary command buffer on the recorder.
+        // Chunk meshes in packed voxel vertices or packed faces draw from their own heaps with their own pipelines
+        void recordGameObjects (EngineFrameInfo &frameInfo, VkDescriptorSet lightDescriptorSet, EngineParallelRecorder &recorder);
 
 
     private:
-        void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-        void createPipeline(VkRenderPass renderPass);
+        // Each mesh heap has its own vertex format, so its models need their own pipeline and bind
+        enum PipelineKind : uint32_t {
+            STANDARD_PIPELINE = 0,
+            VOXEL_PIPELINE = 1,
+            VOXEL_FACE_PIPELINE = 2,
+            PIPELINE_COUNT = 3
+        };
+
+        // One group per heap and index type, the heap's index buffer is bound as one type per draw. Every group
+        // starts on a partition boundary of the visible list, a partition never mixes groups
+        enum DrawGroup : uint32_t {
+            STANDARD_DRAWS = 0,
+            STANDARD_DRAWS_16 = 1,
+            VOXEL_DRAWS = 2,
+            VOXEL_DRAWS_16 = 3,
+            VOXEL_FACE_DRAWS = 4,
+            DRAW_GROUP_COUNT = 5
+        };
+
+        // Object transforms and candidate draws are written by the CPU each frame, the visible draws and their count
+        // by the cull pass. One set per frame in flight
+        struct FrameResources {
+            std::unique_ptr<EngineBuffer> objectBuffer;
+            std::unique_ptr<EngineBuffer> candidateBuffer;
+            std::unique_ptr<EngineBuffer> visibleBuffer;
+            std::unique_ptr<EngineBuffer> countBuffer;
+            std::unique_ptr<EngineBuffer> cullBuffer;
+            VkDescriptorSet objectDescriptorSet = VK_NULL_HANDLE;
+            uint32_t capacity = 0;
+            // Candidate slots, including the empty padding between groups
+            uint32_t drawCount = 0;
+            uint32_t partitionSize = 0;
+            std::array<uint32_t, DRAW_GROUP_COUNT> groupDrawCounts{};
+            std::array<uint32_t, DRAW_GROUP_COUNT> groupFirstPartitions{};
+            std::array<uint32_t, DRAW_GROUP_COUNT> groupPartitionCounts{};
+        };
+
+        void createObjectResources();
+        // Grows the object, candidate, visible and count buffers together since the cull shader indexes all four with
+        // the same slot. The object set is rewritten in place, this slot's last cull and draw retired before it started
+        void reserveFrameCapacity(FrameResources &frame, uint32_t objectCount);
+        void createPipelineLayout(VkDescriptorSetLayout globalSetLayout, VkDescriptorSetLayout lightSetLayout);
+        void createPipelines(EnginePipelineBuilder &pipelineBuilder, VkRenderPass renderPass);
+        void createCullPipeline(EnginePipelineBuilder &pipelineBuilder);
+        // Runs on a worker, only reads the frame's resources
+        void renderPartition(EngineFrameInfo &frameInfo, VkDescriptorSet lightDescriptorSet, DrawGroup group, uint32_t partition);
+        static DrawGroup drawGroupFor(const EngineModel &model);
+        static PipelineKind pipelineFor(DrawGroup group);
+        static VkIndexType indexTypeFor(DrawGroup group);
+        EngineMeshHeap &meshHeapFor(DrawGroup group) const;
 
         EngineDevice &engineDevice;
+        EngineTextureRegistry &textureRegistry;
+
+        // Owned by the device's layout cache, the sets come from its descriptor allocator
+        EngineDescriptorSetLayout *objectSetLayout = nullptr;
+        EngineDescriptorSetLayout *cullSetLayout = nullptr;
+        std::vector<FrameResources> frames;
 
-        std::unique_ptr<EnginePipeline> enginePipeline;
+        // Scratch for the CPU frustum pass, kept between frames so they only allocate when the scene grows
+        math::BoundsArray worldBounds{};
+        std::vector<EngineGameObject *> cullCandidates{};
+        std::vector<uint32_t> visibleIndices{};
+        std::array<std::vector<EngineGameObject *>, DRAW_GROUP_COUNT> groupObjects{};
+
+        // The depth pyramid always holds the previous frame's depth, so boxes are projected with that frame's matrices
+        glm::mat4 previousViewProjection{1.0f};
+        bool hasPreviousViewProjection = false;
+
+        // Every pipeline is built by the job system, taken from its pending handle the first time it's recorded.
+        // The graphics pipelines share one layout
+        std::array<EnginePendingPipeline<EnginePipeline>, PIPELINE_COUNT> pendingPipelines;
+        std::array<std::unique_ptr<EnginePipeline>, PIPELINE_COUNT> pipelines;
         VkPipelineLayout pipelineLayout;
+
+        EnginePendingPipeline<EngineComputePipeline> pendingCullPipeline;
+        std::unique_ptr<EngineComputePipeline> cullPipeline;
+        VkPipelineLayout cullPipelineLayout;
     };
 } // engine::system
 
@@ -0,0 +1,215 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "voxel_chunk.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+namespace engine::voxel {
+
+    // Smallest power of two index width able to address paletteSize entries
+    static int bitsForPaletteSize (size_t paletteSize) {
+        if (paletteSize <= 1) return 0;
+        if (paletteSize <= 2) return 1;
+        if (paletteSize <= 4) return 2;
+        if (paletteSize <= 16) return 4;
+        if (paletteSize <= 256) return 8;
+        return 16;
+    }
+
+    VoxelChunk::VoxelChunk (BlockId fillBlock) {
+        fill (fillBlock);
+    }
+
+    BlockId VoxelChunk::get (int x, int y, int z) const {
+        assert(inBounds (x, y, z) && "Block position outside of chunk");
+        if (bitsPerIndex == 0)
+            return palette[0];
+        return palette[readIndex (blockIndex (x, y, z))];
+    }
+
+    void VoxelChunk::set (int x, int y, int z, BlockId block) {
+        assert(inBounds (x, y, z) && "Block position outside of chunk");
+        int index = blockIndex (x, y, z);
+
+        uint32_t oldEntry = bitsPerIndex == 0 ? 0 : readIndex (index);
+        if (palette[oldEntry] == block)
+            return;
+
+        uint32_t newEntry = findOrAddPaletteEntry (block);
+        writeIndex (index, newEntry);
+        paletteRefCounts[oldEntry]--;
+        paletteRefCounts[newEntry]++;
+
+        // Every block is now the same type, collapse back to a single value chunk
+        if (paletteRefCounts[newEntry] == VOLUME) {
+            fill (block);
+        }
+    }
+
+    void VoxelChunk::fill (BlockId block) {
+        palette.assign (1, block);
+        paletteRefCounts.assign (1, VOLUME);
+        data.clear();
+        data.shrink_to_fit();
+        bitsPerIndex = 0;
+    }
+
+    void VoxelChunk::assign (const BlockId *blocks) {
+        palette.clear();
+        paletteRefCounts.clear();
+
+        // Build the palette first so the indices only have to be packed once at the final width
+        std::vector<uint32_t> indices (VOLUME);
+        for (int i = 0; i < VOLUME; i++) {
+            uint32_t entry = 0;
+            while (entry < palette.size() && palette[entry] != blocks[i])
+                entry++;
+            if (entry == palette.size()) {
+                palette.push_back (blocks[i]);
+                paletteRefCounts.push_back (0);
+            }
+            paletteRefCounts[entry]++;
+            indices[i] = entry;
+        }
+
+        if (palette.size() == 1) {
+            fill (palette[0]);
+            return;
+        }
+
+        bitsPerIndex = static_cast<uint8_t>(bitsForPaletteSize (palette.size()));
+        data.assign ((static_cast<size_t>(VOLUME) * bitsPerIndex + 63) / 64, 0);
+        data.shrink_to_fit();
+        for (int i = 0; i < VOLUME; i++) {
+            writeIndex (i, indices[i]);
+        }
+    }
+
+    void VoxelChunk::copyTo (BlockId *out) const {
+        if (bitsPerIndex == 0) {
+            std::fill (out, out + VOLUME, palette[0]);
+            return;
+        }
+
+        const int indicesPerWord = 64 / bitsPerIndex;
+        const uint64_t mask = (uint64_t{1} << bitsPerIndex) - 1;
+        int index = 0;
+        for (uint64_t word : data) {
+            for (int i = 0; i < indicesPerWord && index < VOLUME; i++, index++) {
+                out[index] = palette[word & mask];
+                word >>= bitsPerIndex;
+            }
+        }
+    }
+
+    void VoxelChunk::compact () {
+        if (bitsPerIndex == 0)
+            return;
+
+        std::vector<uint32_t> remap (palette.size(), 0);
+        std::vector<BlockId> newPalette{};
+        std::vector<uint32_t> newRefCounts{};
+        for (size_t i = 0; i < palette.size(); i++) {
+            if (paletteRefCounts[i] == 0)
+                continue;
+            remap[i] = static_cast<uint32_t>(newPalette.size());
+            newPalette.push_back (palette[i]);
+            newRefCounts.push_back (paletteRefCounts[i]);
+        }
+
+        if (newPalette.size() == 1) {
+            fill (newPalette[0]);
+            return;
+        }
+
+        int newBits = bitsForPaletteSize (newPalette.size());
+        std::vector<uint32_t> indices (VOLUME);
+        for (int i = 0; i < VOLUME; i++) {
+            indices[i] = remap[readIndex (i)];
+        }
+
+        palette = std::move (newPalette);
+        paletteRefCounts = std::move (newRefCounts);
+        bitsPerIndex = static_cast<uint8_t>(newBits);
+        data.assign ((static_cast<size_t>(VOLUME) * newBits + 63) / 64, 0);
+        data.shrink_to_fit();
+        for (int i = 0; i < VOLUME; i++) {
+            writeIndex (i, indices[i]);
+        }
+    }
+
+    size_t VoxelChunk::memoryUsage () const {
+        return sizeof (VoxelChunk)
+               + palette.capacity() * sizeof (BlockId)
+               + paletteRefCounts.capacity() * sizeof (uint32_t)
+               + data.capacity() * sizeof (uint64_t);
+    }
+
+    uint32_t VoxelChunk::readIndex (int index) const {
+        const int indicesPerWord = 64 / bitsPerIndex;
+        const uint64_t mask = (uint64_t{1} << bitsPerIndex) - 1;
+        const uint64_t word = data[index / indicesPerWord];
+        return static_cast<uint32_t>((word >> ((index % indicesPerWord) * bitsPerIndex)) & mask);
+    }
+
+    void VoxelChunk::writeIndex (int index, uint32_t value) {
+        const int indicesPerWord = 64 / bitsPerIndex;
+        const int shift = (index % indicesPerWord) * bitsPerIndex;
+        const uint64_t mask = ((uint64_t{1} << bitsPerIndex) - 1) << shift;
+        uint64_t &word = data[index / indicesPerWord];
+        word = (word & ~mask) | ((static_cast<uint64_t>(value) << shift) & mask);
+    }
+
+    uint32_t VoxelChunk::findOrAddPaletteEntry (BlockId block) {
+        int freeEntry = -1;
+        for (size_t i = 0; i < palette.size(); i++) {
+            if (palette[i] == block)
+                return static_cast<uint32_t>(i);
+            if (freeEntry < 0 && paletteRefCounts[i] == 0)
+                freeEntry = static_cast<int>(i);
+        }
+
+        // Reuse a slot no block refers to anymore before growing the palette
+        if (freeEntry >= 0) {
+            palette[freeEntry] = block;
+            return static_cast<uint32_t>(freeEntry);
+        }
+
+        palette.push_back (block);
+        paletteRefCounts.push_back (0);
+        int requiredBits = bitsForPaletteSize (palette.size());
+        if (requiredBits > bitsPerIndex) {
+            resize (requiredBits);
+        }
+        return static_cast<uint32_t>(palette.size() - 1);
+    }
+
+    void VoxelChunk::resize (int newBitsPerIndex) {
+        assert(newBitsPerIndex > 0 && newBitsPerIndex <= 16 && "Unsupported palette index width");
+
+        if (bitsPerIndex == 0) {
+            // Previously a single value chunk, every block references entry 0
+            bitsPerIndex = static_cast<uint8_t>(newBitsPerIndex);
+            data.assign ((static_cast<size_t>(VOLUME) * newBitsPerIndex + 63) / 64, 0);
+            return;
+        }
+
+        std::vector<uint64_t> oldData = std::move (data);
+        int oldBits = bitsPerIndex;
+
+        data.assign ((static_cast<size_t>(VOLUME) * newBitsPerIndex + 63) / 64, 0);
+        const int oldPerWord = 64 / oldBits;
+        const uint64_t oldMask = (uint64_t{1} << oldBits) - 1;
+
+        bitsPerIndex = static_cast<uint8_t>(newBitsPerIndex);
+        for (int i = 0; i < VOLUME; i++) {
+            uint64_t value = (oldData[i / oldPerWord] >> ((i % oldPerWord) * oldBits)) & oldMask;
+            writeIndex (i, static_cast<uint32_t>(value));
+        }
+    }
+
+} // engine::voxel
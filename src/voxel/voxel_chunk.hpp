@@ -0,0 +1,74 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_VOXEL_CHUNK_HPP
+#define VULKANENGINE_VOXEL_CHUNK_HPP
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace engine::voxel {
+
+    using BlockId = uint16_t;
+    constexpr BlockId BLOCK_AIR = 0;
+    constexpr BlockId BLOCK_STONE = 1;
+    constexpr BlockId BLOCK_DIRT = 2;
+    constexpr BlockId BLOCK_GRASS = 3;
+
+    /**
+     * A fixed size cube of blocks.
+     *
+     * Blocks are stored as indices into a per chunk palette of block ids. The indices are bit packed into
+     * 64 bit words using the smallest power of two width that can address the palette, so a chunk with two
+     * block types costs 1 bit per block. A chunk holding a single block type has no index data at all.
+     */
+    class VoxelChunk {
+    public:
+        static constexpr int SIZE = 32;
+        static constexpr int VOLUME = SIZE * SIZE * SIZE;
+
+        explicit VoxelChunk (BlockId fillBlock = BLOCK_AIR);
+
+        [[nodiscard]] BlockId get (int x, int y, int z) const;
+        void set (int x, int y, int z, BlockId block);
+        void fill (BlockId block);
+        // Replaces every block at once, blocks must hold VOLUME entries in blockIndex order
+        void assign (const BlockId *blocks);
+        // Decodes every block into out (VOLUME entries, blockIndex order)
+        void copyTo (BlockId *out) const;
+
+        // Drops unused palette entries and shrinks the index width to match
+        void compact ();
+
+        [[nodiscard]] bool isUniform () const { return bitsPerIndex == 0; }
+        [[nodiscard]] BlockId uniformBlock () const { return palette[0]; }
+        [[nodiscard]] bool isEmpty () const { return isUniform() && palette[0] == BLOCK_AIR; }
+        [[nodiscard]] size_t paletteSize () const { return palette.size(); }
+        [[nodiscard]] int getBitsPerIndex () const { return bitsPerIndex; }
+
+        // Approximate heap + object size in bytes
+        [[nodiscard]] size_t memoryUsage () const;
+
+        static int blockIndex (int x, int y, int z) { return (y * SIZE + z) * SIZE + x; }
+        static bool inBounds (int x, int y, int z) {
+            return x >= 0 && y >= 0 && z >= 0 && x < SIZE && y < SIZE && z < SIZE;
+        }
+
+    private:
+        [[nodiscard]] uint32_t readIndex (int index) const;
+        void writeIndex (int index, uint32_t value);
+        uint32_t findOrAddPaletteEntry (BlockId block);
+        void resize (int newBitsPerIndex);
+
+        std::vector<BlockId> palette{};
+        std::vector<uint32_t> paletteRefCounts{};   // number of blocks using each palette entry
+        std::vector<uint64_t> data{};
+        uint8_t bitsPerIndex = 0;
+    };
+
+} // engine::voxel
+
+#endif //VULKANENGINE_VOXEL_CHUNK_HPP
@@ -0,0 +1,91 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "voxel_chunk_builder.hpp"
+#include "voxel_mesher.hpp"
+
+namespace engine::voxel {
+
+    VoxelChunkBuilder::VoxelChunkBuilder (EngineJobSystem &jobSystem, VoxelWorld &world, const VoxelTerrainGenerator &generator,
+                                          EngineModel::VertexFormat meshFormat)
+            : jobSystem{jobSystem}, world{world}, generator{generator}, meshFormat{meshFormat} {}
+
+    VoxelChunkBuilder::~VoxelChunkBuilder () {
+        // Jobs hold a pointer back to this builder
+        waitIdle();
+    }
+
+    void VoxelChunkBuilder::requestMesh (const glm::ivec3 &chunkCoord, JobPriority priority) {
+        auto existing = meshJobs.find (chunkCoord);
+        if (existing != meshJobs.end() && !EngineJobSystem::isFinished (existing->second))
+            return;
+
+        std::vector<JobHandle> dependencies{};
+        dependencies.push_back (requestGeneration (chunkCoord, priority));
+        for (int face = 0; face < 6; face++) {
+            glm::ivec3 neighbourCoord = chunkCoord + ChunkNeighbourhood::faceOffset (static_cast<ChunkFace>(face));
+            dependencies.push_back (requestGeneration (neighbourCoord, priority));
+        }
+
+        pendingMeshes.fetch_add (1, std::memory_order_relaxed);
+        meshJobs[chunkCoord] = jobSystem.schedule ([this, chunkCoord] {
+            ChunkMesh mesh{chunkCoord};
+            VoxelMesher::meshChunk (ChunkNeighbourhood::gather (world, chunkCoord), mesh.builder, meshFormat);
+            finishedMeshes.push (std::move (mesh));
+            pendingMeshes.fetch_sub (1, std::memory_order_relaxed);
+        }, priority, dependencies);
+    }
+
+    void VoxelChunkBuilder::waitIdle () {
+        for (const auto &[coord, job] : meshJobs) {
+            jobSystem.wait (job);
+        }
+        for (const auto &[coord, job] : generationJobs) {
+            jobSystem.wait (job);
+        }
+    }
+
+    bool VoxelChunkBuilder::releaseChunk (const glm::ivec3 &chunkCoord) {
+        auto generation = generationJobs.find (chunkCoord);
+        auto mesh = meshJobs.find (chunkCoord);
+        if (generation != generationJobs.end() && !EngineJobSystem::isFinished (generation->second))
+            return false;
+        if (mesh != meshJobs.end() && !EngineJobSystem::isFinished (mesh->second))
+            return false;
+
+        if (generation != generationJobs.end())
+            generationJobs.erase (generation);
+        if (mesh != meshJobs.end())
+            meshJobs.erase (mesh);
+        world.removeChunk (chunkCoord);
+        return true;
+    }
+
+    std::vector<glm::ivec3> VoxelChunkBuilder::getTrackedChunks () const {
+        std::vector<glm::ivec3> coords{};
+        coords.reserve (generationJobs.size());
+        for (const auto &[coord, job] : generationJobs) {
+            coords.push_back (coord);
+        }
+        return coords;
+    }
+
+    JobHandle VoxelChunkBuilder::requestGeneration (const glm::ivec3 &chunkCoord, JobPriority priority) {
+        auto existing = generationJobs.find (chunkCoord);
+        if (existing != generationJobs.end())
+            return existing->second;
+
+        JobHandle job = jobSystem.schedule ([this, chunkCoord] {
+            if (world.hasChunk (chunkCoord))
+                return;
+            // Build off to the side and publish once complete, mesh jobs never see a half generated chunk
+            auto chunk = std::make_shared<VoxelChunk>();
+            generator.generateChunk (chunkCoord, *chunk);
+            world.setChunk (chunkCoord, std::move (chunk));
+        }, priority);
+        generationJobs.emplace (chunkCoord, job);
+        return job;
+    }
+
+} // engine::voxel
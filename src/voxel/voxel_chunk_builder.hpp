@@ -0,0 +1,76 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_VOXEL_CHUNK_BUILDER_HPP
+#define VULKANENGINE_VOXEL_CHUNK_BUILDER_HPP
+
+#include "voxel_world.hpp"
+#include "voxel_generator.hpp"
+#include "../engine_job_system.hpp"
+#include "../engine_mpsc_queue.hpp"
+#include "../engine_model.hpp"
+
+// std
+#include <atomic>
+#include <unordered_map>
+#include <vector>
+
+namespace engine::voxel {
+
+    struct ChunkMesh {
+        glm::ivec3 chunkCoord{};
+        EngineModel::Builder builder{};
+    };
+
+    /**
+     * Runs terrain generation and meshing on the job system. A mesh job depends on the generation jobs of
+     * its chunk and the six face neighbours, finished meshes are handed back through a lock free queue
+     * for the render thread to upload.
+     *
+     * requestMesh and popFinishedMesh must be called from a single thread, usually the render thread.
+     */
+    class VoxelChunkBuilder {
+    public:
+        VoxelChunkBuilder (EngineJobSystem &jobSystem, VoxelWorld &world, const VoxelTerrainGenerator &generator,
+                           EngineModel::VertexFormat meshFormat = EngineModel::VertexFormat::VoxelFaces);
+        ~VoxelChunkBuilder ();
+
+        VoxelChunkBuilder (const VoxelChunkBuilder &) = delete;
+        VoxelChunkBuilder &operator= (const VoxelChunkBuilder &) = delete;
+
+        // Does nothing if a mesh for chunkCoord is already in flight
+        void requestMesh (const glm::ivec3 &chunkCoord, JobPriority priority = JobPriority::Normal);
+
+        // Meshes with no visible faces are still returned so the caller knows the chunk is done
+        bool popFinishedMesh (ChunkMesh &mesh) { return finishedMeshes.tryPop (mesh); }
+
+        [[nodiscard]] int getPendingMeshCount () const { return pendingMeshes.load (std::memory_order_relaxed); }
+
+        // Forgets the jobs for chunkCoord and drops its voxel data, returns false while one of its jobs is still queued or running
+        bool releaseChunk (const glm::ivec3 &chunkCoord);
+
+        // Every chunk with a generation job, finished or not
+        [[nodiscard]] std::vector<glm::ivec3> getTrackedChunks () const;
+
+        // Blocks until every job this builder scheduled has finished
+        void waitIdle ();
+
+    private:
+        JobHandle requestGeneration (const glm::ivec3 &chunkCoord, JobPriority priority);
+
+        EngineJobSystem &jobSystem;
+        VoxelWorld &world;
+        const VoxelTerrainGenerator &generator;
+        EngineModel::VertexFormat meshFormat;
+
+        std::unordered_map<glm::ivec3, JobHandle, ChunkCoordHash> generationJobs{};
+        std::unordered_map<glm::ivec3, JobHandle, ChunkCoordHash> meshJobs{};
+
+        EngineMpscQueue<ChunkMesh> finishedMeshes{};
+        std::atomic<int> pendingMeshes{0};
+    };
+
+} // engine::voxel
+
+#endif //VULKANENGINE_VOXEL_CHUNK_BUILDER_HPP
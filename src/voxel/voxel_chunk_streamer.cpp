@@ -0,0 +1,246 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "voxel_chunk_streamer.hpp"
+#include "../engine_swapchain.hpp"
+
+#include <spdlog/spdlog.h>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace engine::voxel {
+
+    namespace {
+        // Power of two buffer sizes so a recycled model fits most meshes of a similar size
+        uint32_t roundUpCapacity (size_t count) {
+            uint32_t capacity = 256;
+            while (capacity < count)
+                capacity *= 2;
+            return capacity;
+        }
+    }
+
+    VoxelChunkStreamer::VoxelChunkStreamer (EngineDevice &device, EngineJobSystem &jobSystem, VoxelWorld &world, const VoxelTerrainGenerator &generator,
+                                            const ChunkStreamingSettings &settings)
+            : engineDevice{device}, uploadManager{device.getUploadManager()}, world{world}, settings{settings}, chunkBuilder{jobSystem, world, generator, settings.meshFormat} {
+        // Equal radii would evict chunks the load queue asks for again straight away
+        if (settings.unloadRadius <= settings.loadRadius) {
+            spdlog::get ("renderer")->critical ("Chunk unload radius {} is not larger than the load radius {}", settings.unloadRadius, settings.loadRadius);
+            throw std::runtime_error ("Chunk unload radius has to be larger than the load radius!");
+        }
+    }
+
+    void VoxelChunkStreamer::update (const glm::vec3 &viewerPosition, EngineGameObject::Map &gameObjects) {
+        frameNumber++;
+
+        glm::ivec3 currentChunk = VoxelWorld::worldToChunk (glm::ivec3 (glm::floor (viewerPosition)));
+        currentChunk.y = 0;
+        if (!viewerChunk.has_value() || *viewerChunk != currentChunk) {
+            viewerChunk = currentChunk;
+            evictDistantChunks (gameObjects);
+            rebuildLoadQueue();
+        }
+
+        releaseEvictedChunks();
+        requestQueuedMeshes();
+        publishUploadedChunks (gameObjects);
+        uploadFinishedMeshes();
+        recycleRetiredModels();
+    }
+
+    void VoxelChunkStreamer::rebuildLoadQueue () {
+        loadQueue.clear();
+        for (int cx = -settings.loadRadius; cx <= settings.loadRadius; cx++) {
+            for (int cz = -settings.loadRadius; cz <= settings.loadRadius; cz++) {
+                for (int cy = settings.minChunkY; cy <= settings.maxChunkY; cy++) {
+                    glm::ivec3 coord{viewerChunk->x + cx, cy, viewerChunk->z + cz};
+                    if (horizontalDistance (coord) > static_cast<float>(settings.loadRadius))
+                        continue;
+                    if (loadedChunks.count (coord) > 0 || requestedChunks.count (coord) > 0)
+                        continue;
+                    loadQueue.push_back (coord);
+                }
+            }
+        }
+
+        std::sort (loadQueue.begin(), loadQueue.end(), [this] (const glm::ivec3 &a, const glm::ivec3 &b) {
+            return horizontalDistance (a) > horizontalDistance (b);
+        });
+    }
+
+    void VoxelChunkStreamer::evictDistantChunks (EngineGameObject::Map &gameObjects) {
+        const auto unloadRadius = static_cast<float>(settings.unloadRadius);
+
+        for (auto it = loadedChunks.begin(); it != loadedChunks.end();) {
+            if (horizontalDistance (it->first) <= unloadRadius) {
+                ++it;
+                continue;
+            }
+
+            if (it->second.has_value()) {
+                auto object = gameObjects.find (*it->second);
+                if (object != gameObjects.end()) {
+                    retireModel (std::move (object->second.model));
+                    gameObjects.erase (object);
+                }
+            }
+            it = loadedChunks.erase (it);
+        }
+
+        for (auto pending = pendingChunks.begin(); pending != pendingChunks.end();) {
+            if (horizontalDistance (pending->chunkCoord) <= unloadRadius) {
+                ++pending;
+                continue;
+            }
+            retireModel (std::move (pending->object.model), pending->uploadValue);
+            pending = pendingChunks.erase (pending);
+        }
+
+        // Includes chunks only generated as neighbours of a mesh, those never show up in loadedChunks.
+        // Chunks with a job still in flight are retried every frame by releaseEvictedChunks
+        for (const auto &coord : chunkBuilder.getTrackedChunks()) {
+            if (horizontalDistance (coord) > unloadRadius && !chunkBuilder.releaseChunk (coord)) {
+                unreleasedChunks.insert (coord);
+            }
+        }
+    }
+
+    void VoxelChunkStreamer::releaseEvictedChunks () {
+        const auto unloadRadius = static_cast<float>(settings.unloadRadius);
+
+        for (auto it = unreleasedChunks.begin(); it != unreleasedChunks.end();) {
+            // The viewer may have come back for it, then its data is worth keeping
+            if (horizontalDistance (*it) <= unloadRadius || chunkBuilder.releaseChunk (*it)) {
+                it = unreleasedChunks.erase (it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void VoxelChunkStreamer::requestQueuedMeshes () {
+        const auto loadRadius = static_cast<float>(settings.loadRadius);
+
+        while (!loadQueue.empty() && chunkBuilder.getPendingMeshCount() < settings.maxPendingMeshes) {
+            glm::ivec3 coord = loadQueue.back();
+            loadQueue.pop_back();
+
+            float distance = horizontalDistance (coord);
+            if (distance > loadRadius || loadedChunks.count (coord) > 0 || requestedChunks.count (coord) > 0)
+                continue;
+
+            chunkBuilder.requestMesh (coord, priorityFor (distance));
+            requestedChunks.insert (coord);
+        }
+    }
+
+    void VoxelChunkStreamer::uploadFinishedMeshes () {
+        ChunkMesh mesh{};
+        int uploads = 0;
+        while (uploads < settings.maxUploadsPerFrame && chunkBuilder.popFinishedMesh (mesh)) {
+            const glm::ivec3 coord = mesh.chunkCoord;
+
+            // Drop results the viewer has already moved away from, or duplicates of a chunk that was re-requested
+            if (requestedChunks.erase (coord) == 0 || loadedChunks.count (coord) > 0)
+                continue;
+            if (horizontalDistance (coord) > static_cast<float>(settings.unloadRadius))
+                continue;
+
+            if (mesh.builder.vertexCount() == 0) {
+                loadedChunks.emplace (coord, std::nullopt);
+                continue;
+            }
+            // The mesher already falls back to indexed vertices past the quad pattern, never hand the model one that doesn't fit
+            if (mesh.builder.vertexFormat == EngineModel::VertexFormat::VoxelFaces && mesh.builder.vertexCount() > EngineMeshHeap::MAX_QUADS_PER_DRAW) {
+                spdlog::get ("renderer")->error ("Chunk ({}, {}, {}) has {} faces, more than one face draw holds, skipping it",
+                                                 coord.x, coord.y, coord.z, mesh.builder.vertexCount());
+                loadedChunks.emplace (coord, std::nullopt);
+                continue;
+            }
+
+            auto chunkObject = EngineGameObject::createGameObject();
+            chunkObject.model = acquireModel (mesh.builder);
+            chunkObject.textureArrayIndex = blockTextureArray;
+            chunkObject.transform.translation = glm::vec3 (VoxelWorld::chunkToWorld (coord));
+            loadedChunks.emplace (coord, chunkObject.getId());
+            pendingChunks.push_back ({coord, std::move (chunkObject), uploadManager.getBatchValue()});
+            uploads++;
+        }
+
+        // Everything recorded this frame goes to the transfer queue as one submit
+        if (uploads > 0)
+            uploadManager.submit();
+    }
+
+    void VoxelChunkStreamer::publishUploadedChunks (EngineGameObject::Map &gameObjects) {
+        for (auto pending = pendingChunks.begin(); pending != pendingChunks.end();) {
+            if (!uploadManager.isComplete (pending->uploadValue)) {
+                ++pending;
+                continue;
+            }
+            auto id = pending->object.getId();
+            gameObjects.emplace (id, std::move (pending->object));
+            pending = pendingChunks.erase (pending);
+        }
+    }
+
+    void VoxelChunkStreamer::recycleRetiredModels () {
+        // A model removed before recording frame N may still be read by the previous frames in flight
+        while (!retiredModels.empty() && frameNumber - retiredModels.front().retiredFrame > EngineSwapChain::MAX_FRAMES_IN_FLIGHT &&
+               uploadManager.isComplete (retiredModels.front().uploadValue)) {
+            if (freeModels.size() < settings.maxPooledModels) {
+                freeModels.push_back (std::move (retiredModels.front().model));
+            }
+            retiredModels.pop_front();
+        }
+    }
+
+    std::shared_ptr<EngineModel> VoxelChunkStreamer::acquireModel (const EngineModel::Builder &builder) {
+        auto best = freeModels.end();
+        for (auto it = freeModels.begin(); it != freeModels.end(); ++it) {
+            if ((*it)->canFit (builder) && (best == freeModels.end() || (*it)->getVertexCapacity() < (*best)->getVertexCapacity()))
+                best = it;
+        }
+
+        std::shared_ptr<EngineModel> model{};
+        if (best != freeModels.end()) {
+            model = std::move (*best);
+            *best = std::move (freeModels.back());
+            freeModels.pop_back();
+        } else {
+            uint32_t vertexCapacity = roundUpCapacity (builder.vertexCount());
+            // Rounding up must not take a face model past the quad pattern, the limit is itself a power of two
+            if (builder.vertexFormat == EngineModel::VertexFormat::VoxelFaces)
+                vertexCapacity = std::min (vertexCapacity, EngineMeshHeap::MAX_QUADS_PER_DRAW);
+            model = std::make_shared<EngineModel>(engineDevice, vertexCapacity, roundUpCapacity (builder.indices.size()), builder.vertexFormat);
+        }
+
+        model->update (builder);
+        return model;
+    }
+
+    void VoxelChunkStreamer::retireModel (std::shared_ptr<EngineModel> model, uint64_t uploadValue) {
+        if (model == nullptr)
+            return;
+        retiredModels.push_back ({std::move (model), frameNumber, uploadValue});
+    }
+
+    float VoxelChunkStreamer::horizontalDistance (const glm::ivec3 &chunkCoord) const {
+        auto dx = static_cast<float>(chunkCoord.x - viewerChunk->x);
+        auto dz = static_cast<float>(chunkCoord.z - viewerChunk->z);
+        return std::sqrt (dx * dx + dz * dz);
+    }
+
+    JobPriority VoxelChunkStreamer::priorityFor (float distance) const {
+        if (distance <= 1.5f)
+            return JobPriority::High;
+        if (distance <= static_cast<float>(settings.loadRadius) * 0.5f)
+            return JobPriority::Normal;
+        return JobPriority::Low;
+    }
+
+} // engine::voxel
@@ -0,0 +1,114 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_VOXEL_CHUNK_STREAMER_HPP
+#define VULKANENGINE_VOXEL_CHUNK_STREAMER_HPP
+
+#include "voxel_chunk_builder.hpp"
+#include "../engine_device.hpp"
+#include "../engine_game_object.hpp"
+#include "../engine_texture_registry.hpp"
+#include "../engine_upload_manager.hpp"
+
+// std
+#include <deque>
+#include <list>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace engine::voxel {
+
+    struct ChunkStreamingSettings {
+        int loadRadius = 4;             // horizontal radius in chunks kept loaded around the viewer
+        int unloadRadius = 6;           // chunks are only evicted past this radius so walking along a border does not thrash, has to be larger than loadRadius
+        int minChunkY = 0;
+        int maxChunkY = 1;
+        int maxUploadsPerFrame = 4;
+        int maxPendingMeshes = 32;      // keeps far away requests from piling up in front of near ones when moving fast
+        size_t maxPooledModels = 64;
+        // VoxelFaces pulls one record per quad in the vertex shader, PackedVoxel keeps indexed vertices
+        EngineModel::VertexFormat meshFormat = EngineModel::VertexFormat::VoxelFaces;
+    };
+
+    /**
+     * Keeps the chunks around the viewer loaded. Requests meshes nearest first as the viewer moves, uploads the
+     * results as game objects and evicts chunks past the unload radius. Evicted models go back into a pool once
+     * the frames that used them have finished, so new chunks reuse existing GPU buffers instead of allocating.
+     * A frame's uploads go out as one transfer batch and chunks only become game objects once that batch has finished.
+     */
+    class VoxelChunkStreamer {
+    public:
+        VoxelChunkStreamer (EngineDevice &device, EngineJobSystem &jobSystem, VoxelWorld &world, const VoxelTerrainGenerator &generator,
+                            const ChunkStreamingSettings &settings = ChunkStreamingSettings{});
+
+        VoxelChunkStreamer (const VoxelChunkStreamer &) = delete;
+        VoxelChunkStreamer &operator= (const VoxelChunkStreamer &) = delete;
+
+        // Call once per frame before recording, after the upload manager has been updated. Adds and removes chunk game objects
+        void update (const glm::vec3 &viewerPosition, EngineGameObject::Map &gameObjects);
+
+        [[nodiscard]] size_t getLoadedChunkCount () const { return loadedChunks.size(); }
+        [[nodiscard]] size_t getPooledModelCount () const { return freeModels.size() + retiredModels.size(); }
+        [[nodiscard]] const ChunkStreamingSettings &getSettings () const { return settings; }
+        // Registry slot of the block texture array, given to every chunk object created from now on
+        void setBlockTextureArray (uint32_t textureArrayIndex) { blockTextureArray = textureArrayIndex; }
+
+    private:
+        struct RetiredModel {
+            std::shared_ptr<EngineModel> model;
+            uint64_t retiredFrame;
+            uint64_t uploadValue;       // a model evicted before its upload finished can't be written to again until it has
+        };
+
+        struct PendingChunk {
+            glm::ivec3 chunkCoord;
+            EngineGameObject object;
+            uint64_t uploadValue;
+        };
+
+        void rebuildLoadQueue ();
+        void evictDistantChunks (EngineGameObject::Map &gameObjects);
+        void releaseEvictedChunks ();
+        void requestQueuedMeshes ();
+        void uploadFinishedMeshes ();
+        void publishUploadedChunks (EngineGameObject::Map &gameObjects);
+        void recycleRetiredModels ();
+
+        std::shared_ptr<EngineModel> acquireModel (const EngineModel::Builder &builder);
+        void retireModel (std::shared_ptr<EngineModel> model, uint64_t uploadValue = 0);
+
+        [[nodiscard]] float horizontalDistance (const glm::ivec3 &chunkCoord) const;
+        [[nodiscard]] JobPriority priorityFor (float distance) const;
+
+        EngineDevice &engineDevice;
+        EngineUploadManager &uploadManager;
+        VoxelWorld &world;
+        ChunkStreamingSettings settings;
+        VoxelChunkBuilder chunkBuilder;
+        // Chunks without one are drawn untextured with the registry's fallback texture
+        uint32_t blockTextureArray = EngineTextureRegistry::NO_TEXTURE_ARRAY;
+
+        uint64_t frameNumber = 0;
+        std::optional<glm::ivec3> viewerChunk{};
+
+        // Sorted furthest first so the nearest chunk is popped from the back
+        std::vector<glm::ivec3> loadQueue{};
+        std::unordered_set<glm::ivec3, ChunkCoordHash> requestedChunks{};
+        // Chunks with no visible faces are loaded without a game object
+        std::unordered_map<glm::ivec3, std::optional<EngineGameObject::id_t>, ChunkCoordHash> loadedChunks{};
+        // Loaded chunks whose upload batch has not finished yet, a list since game objects can't be move assigned
+        std::list<PendingChunk> pendingChunks{};
+        // Evicted chunks whose jobs were still running, their voxel data is dropped once those finish
+        std::unordered_set<glm::ivec3, ChunkCoordHash> unreleasedChunks{};
+
+        std::deque<RetiredModel> retiredModels{};
+        std::vector<std::shared_ptr<EngineModel>> freeModels{};
+    };
+
+} // engine::voxel
+
+#endif //VULKANENGINE_VOXEL_CHUNK_STREAMER_HPP
@@ -0,0 +1,62 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "voxel_generator.hpp"
+#include "voxel_world.hpp"
+
+// std
+#include <vector>
+
+namespace engine::voxel {
+
+    VoxelTerrainGenerator::VoxelTerrainGenerator (int seed, const std::string &encodedNoise) : seed{seed} {
+        fnGenerator = FastNoise::NewFromEncodedNodeTree (encodedNoise.c_str());
+    }
+
+    void VoxelTerrainGenerator::generateChunk (const glm::ivec3 &chunkCoord, VoxelChunk &chunk) const {
+        constexpr int SIZE = VoxelChunk::SIZE;
+        glm::ivec3 origin = VoxelWorld::chunkToWorld (chunkCoord);
+
+        // Sample a few rows above the chunk (-y) so surface blocks are chosen correctly at the top border
+        const int padding = dirtDepth + 1;
+        const int sampleHeight = SIZE + padding;
+        const int sampleStartY = origin.y - padding;
+        std::vector<float> noiseOutput (static_cast<size_t>(SIZE) * sampleHeight * SIZE);
+        fnGenerator->GenUniformGrid3D (noiseOutput.data(), origin.x, sampleStartY, origin.z, SIZE, sampleHeight, SIZE, frequency, seed);
+
+        // FastNoise output is x fastest, then y, then z
+        auto isSolid = [&] (int x, int sampleY, int z) {
+            float offset = noiseOutput[x + SIZE * (sampleY + sampleHeight * z)] * heightAmplitude;
+            return static_cast<float>(sampleStartY + sampleY) + offset > surfaceY;
+        };
+
+        std::vector<BlockId> blocks (VoxelChunk::VOLUME, BLOCK_AIR);
+        for (int z = 0; z < SIZE; z++) {
+            for (int x = 0; x < SIZE; x++) {
+                // Walk down each column counting solid blocks since the last air gap
+                int depth = 0;
+                for (int sampleY = 0; sampleY < sampleHeight; sampleY++) {
+                    if (!isSolid (x, sampleY, z)) {
+                        depth = 0;
+                        continue;
+                    }
+                    depth++;
+                    int y = sampleY - padding;
+                    if (y < 0)
+                        continue;
+
+                    BlockId block = BLOCK_STONE;
+                    if (depth == 1)
+                        block = BLOCK_GRASS;
+                    else if (depth <= dirtDepth + 1)
+                        block = BLOCK_DIRT;
+                    blocks[VoxelChunk::blockIndex (x, y, z)] = block;
+                }
+            }
+        }
+
+        chunk.assign (blocks.data());
+    }
+
+} // engine::voxel
@@ -0,0 +1,47 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_VOXEL_GENERATOR_HPP
+#define VULKANENGINE_VOXEL_GENERATOR_HPP
+
+#include "voxel_chunk.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+#include <FastNoise/FastNoise.h>
+
+// std
+#include <string>
+
+namespace engine::voxel {
+
+    /**
+     * Fills chunks from a 3D FastNoise2 density field biased by height. Generation only depends on the
+     * seed and chunk coordinate so any chunk can be generated independently and on any thread.
+     *
+     * Follows the engine convention of -y being up, so the ground is at larger y values than the sky.
+     */
+    class VoxelTerrainGenerator {
+    public:
+        static constexpr const char *DEFAULT_ENCODED_NOISE = "DQAFAAAAAAAAQAgAAAAAAD8AAAAAAA==";
+
+        explicit VoxelTerrainGenerator (int seed = 1337, const std::string &encodedNoise = DEFAULT_ENCODED_NOISE);
+
+        void generateChunk (const glm::ivec3 &chunkCoord, VoxelChunk &chunk) const;
+
+        int seed = 1337;
+        float frequency = 0.02f;
+        float surfaceY = 8.0f;          // world y where the density field crosses zero on average
+        float heightAmplitude = 16.0f;  // how far the noise can push the surface up or down
+        int dirtDepth = 3;
+
+    private:
+        FastNoise::SmartNode<> fnGenerator;
+    };
+
+} // engine::voxel
+
+#endif //VULKANENGINE_VOXEL_GENERATOR_HPP
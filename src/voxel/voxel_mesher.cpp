@@ -0,0 +1,246 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "voxel_mesher.hpp"
+
+// std
+#include <cassert>
+#include <vector>
+
+namespace engine::voxel {
+
+    namespace {
+        constexpr int SIZE = VoxelChunk::SIZE;
+        constexpr int PADDED = SIZE + 2;
+
+        // Padded block layout matches VoxelChunk::blockIndex, x fastest then z then y
+        constexpr int AXIS_STRIDE[3] = {1, PADDED * PADDED, PADDED};
+
+        int paddedIndex (int x, int y, int z) {
+            return ((y + 1) * PADDED + (z + 1)) * PADDED + (x + 1);
+        }
+
+        // Copies the chunk plus a one block border from its neighbours into a flat array, so the face
+        // visibility test never has to decode palette indices or branch on chunk borders
+        void fillPaddedBlocks (const ChunkNeighbourhood &neighbourhood, std::vector<BlockId> &padded) {
+            static thread_local std::vector<BlockId> centerBlocks (VoxelChunk::VOLUME);
+
+            padded.assign (static_cast<size_t>(PADDED) * PADDED * PADDED, BLOCK_AIR);
+            neighbourhood.center->copyTo (centerBlocks.data());
+            for (int y = 0; y < SIZE; y++) {
+                for (int z = 0; z < SIZE; z++) {
+                    const BlockId *row = &centerBlocks[VoxelChunk::blockIndex (0, y, z)];
+                    std::copy (row, row + SIZE, &padded[paddedIndex (0, y, z)]);
+                }
+            }
+
+            for (int face = 0; face < 6; face++) {
+                const auto &neighbour = neighbourhood.neighbours[face];
+                if (neighbour == nullptr || neighbour->isEmpty())
+                    continue;
+
+                glm::ivec3 offset = ChunkNeighbourhood::faceOffset (static_cast<ChunkFace>(face));
+                int axis = face / 2;
+                int u = (axis + 1) % 3;
+                int v = (axis + 2) % 3;
+                for (int j = 0; j < SIZE; j++) {
+                    for (int i = 0; i < SIZE; i++) {
+                        glm::ivec3 local{};
+                        local[axis] = offset[axis] < 0 ? SIZE - 1 : 0;
+                        local[u] = i;
+                        local[v] = j;
+
+                        glm::ivec3 target = local;
+                        target[axis] = offset[axis] < 0 ? -1 : SIZE;
+                        padded[paddedIndex (target.x, target.y, target.z)] = neighbour->get (local.x, local.y, local.z);
+                    }
+                }
+            }
+        }
+
+        bool isHiddenByNeighbours (const ChunkNeighbourhood &neighbourhood) {
+            const auto &center = neighbourhood.center;
+            if (!center->isUniform() || center->uniformBlock() == BLOCK_AIR)
+                return false;
+            for (const auto &neighbour : neighbourhood.neighbours) {
+                if (neighbour == nullptr || !neighbour->isUniform() || neighbour->uniformBlock() == BLOCK_AIR)
+                    return false;
+            }
+            return true;
+        }
+
+        void emitQuad (EngineModel::Builder &builder, int axis, int direction, int slice, int i, int j, int width, int height, BlockId block) {
+            using PackedVoxelVertex = EngineModel::PackedVoxelVertex;
+            int u = (axis + 1) % 3;
+            int v = (axis + 2) % 3;
+
+            glm::uvec3 origin{0u};
+            origin[axis] = static_cast<uint32_t>(slice + (direction > 0 ? 1 : 0));
+            origin[u] = static_cast<uint32_t>(i);
+            origin[v] = static_cast<uint32_t>(j);
+
+            glm::uvec3 du{0u};
+            du[u] = static_cast<uint32_t>(width);
+            glm::uvec3 dv{0u};
+            dv[v] = static_cast<uint32_t>(height);
+
+            // ChunkFace order, the shader turns it back into a normal
+            auto face = static_cast<uint32_t>(axis * 2 + (direction > 0 ? 1 : 0));
+            glm::vec3 color = VoxelMesher::blockColor (block);
+            uint32_t layer = VoxelMesher::blockTextureLayer (block);
+            // No occlusion yet, every corner is fully lit
+            constexpr uint32_t ambientOcclusion = PackedVoxelVertex::MAX_AMBIENT_OCCLUSION;
+
+            // UVs are derived from the position in the shader, tiling the texture once per block across a merged quad
+            auto base = static_cast<uint32_t>(builder.packedVertices.size());
+            builder.packedVertices.push_back (PackedVoxelVertex::pack (origin, face, ambientOcclusion, layer, color));
+            builder.packedVertices.push_back (PackedVoxelVertex::pack (origin + du, face, ambientOcclusion, layer, color));
+            builder.packedVertices.push_back (PackedVoxelVertex::pack (origin + du + dv, face, ambientOcclusion, layer, color));
+            builder.packedVertices.push_back (PackedVoxelVertex::pack (origin + dv, face, ambientOcclusion, layer, color));
+
+            // u x v points along +axis, flip the winding for faces looking down the negative axis
+            if (direction > 0) {
+                builder.indices.insert (builder.indices.end(), {base, base + 1, base + 2, base + 2, base + 3, base});
+            } else {
+                builder.indices.insert (builder.indices.end(), {base, base + 3, base + 2, base + 2, base + 1, base});
+            }
+        }
+
+        void emitFace (EngineModel::Builder &builder, int axis, int direction, int slice, int i, int j, int width, int height, BlockId block) {
+            int u = (axis + 1) % 3;
+            int v = (axis + 2) % 3;
+
+            // The block the face belongs to, the shader moves positive faces onto its far side
+            glm::uvec3 origin{0u};
+            origin[axis] = static_cast<uint32_t>(slice);
+            origin[u] = static_cast<uint32_t>(i);
+            origin[v] = static_cast<uint32_t>(j);
+
+            auto face = static_cast<uint32_t>(axis * 2 + (direction > 0 ? 1 : 0));
+            builder.faces.push_back (EngineModel::PackedVoxelFace::pack (origin, face, static_cast<uint32_t>(width), static_cast<uint32_t>(height),
+                                                                         VoxelMesher::blockTextureLayer (block), VoxelMesher::blockColor (block)));
+        }
+    }
+
+    ChunkNeighbourhood ChunkNeighbourhood::gather (const VoxelWorld &world, const glm::ivec3 &chunkCoord) {
+        ChunkNeighbourhood neighbourhood{};
+        neighbourhood.center = world.getChunk (chunkCoord);
+        for (int face = 0; face < 6; face++) {
+            neighbourhood.neighbours[face] = world.getChunk (chunkCoord + faceOffset (static_cast<ChunkFace>(face)));
+        }
+        return neighbourhood;
+    }
+
+    glm::ivec3 ChunkNeighbourhood::faceOffset (ChunkFace face) {
+        switch (face) {
+            case ChunkFace::NegativeX: return {-1, 0, 0};
+            case ChunkFace::PositiveX: return {1, 0, 0};
+            case ChunkFace::NegativeY: return {0, -1, 0};
+            case ChunkFace::PositiveY: return {0, 1, 0};
+            case ChunkFace::NegativeZ: return {0, 0, -1};
+            case ChunkFace::PositiveZ: return {0, 0, 1};
+        }
+        return {0, 0, 0};
+    }
+
+    void VoxelMesher::meshChunk (const ChunkNeighbourhood &neighbourhood, EngineModel::Builder &builder, EngineModel::VertexFormat format) {
+        assert(format != EngineModel::VertexFormat::Standard && "Chunks are meshed into one of the packed voxel formats");
+        builder.vertexFormat = format;
+        builder.vertices.clear();
+        builder.packedVertices.clear();
+        builder.faces.clear();
+        builder.indices.clear();
+        auto emit = format == EngineModel::VertexFormat::VoxelFaces ? emitFace : emitQuad;
+
+        if (neighbourhood.center == nullptr || neighbourhood.center->isEmpty() || isHiddenByNeighbours (neighbourhood)) {
+            builder.computeBounds();
+            return;
+        }
+
+        static thread_local std::vector<BlockId> padded{};
+        static thread_local std::vector<BlockId> mask (static_cast<size_t>(SIZE) * SIZE);
+        fillPaddedBlocks (neighbourhood, padded);
+
+        for (int axis = 0; axis < 3; axis++) {
+            int u = (axis + 1) % 3;
+            int v = (axis + 2) % 3;
+
+            for (int direction : {-1, 1}) {
+                int neighbourStep = direction * AXIS_STRIDE[axis];
+
+                for (int slice = 0; slice < SIZE; slice++) {
+                    // Mark every block in this slice whose face in direction is exposed to air
+                    glm::ivec3 pos{};
+                    pos[axis] = slice;
+                    for (int j = 0; j < SIZE; j++) {
+                        pos[v] = j;
+                        for (int i = 0; i < SIZE; i++) {
+                            pos[u] = i;
+                            int index = paddedIndex (pos.x, pos.y, pos.z);
+                            BlockId block = padded[index];
+                            mask[j * SIZE + i] = (block != BLOCK_AIR && padded[index + neighbourStep] == BLOCK_AIR) ? block : BLOCK_AIR;
+                        }
+                    }
+
+                    // Grow each face along u, then along v while the whole row matches, then clear what was used
+                    for (int j = 0; j < SIZE; j++) {
+                        for (int i = 0; i < SIZE;) {
+                            BlockId block = mask[j * SIZE + i];
+                            if (block == BLOCK_AIR) {
+                                i++;
+                                continue;
+                            }
+
+                            int width = 1;
+                            while (i + width < SIZE && mask[j * SIZE + i + width] == block)
+                                width++;
+
+                            int height = 1;
+                            bool rowMatches = true;
+                            while (j + height < SIZE && rowMatches) {
+                                for (int k = 0; k < width; k++) {
+                                    if (mask[(j + height) * SIZE + i + k] != block) {
+                                        rowMatches = false;
+                                        break;
+                                    }
+                                }
+                                if (rowMatches)
+                                    height++;
+                            }
+
+                            emit (builder, axis, direction, slice, i, j, width, height, block);
+
+                            for (int h = 0; h < height; h++) {
+                                std::fill_n (&mask[(j + h) * SIZE + i], width, BLOCK_AIR);
+                            }
+                            i += width;
+                        }
+                    }
+                }
+            }
+        }
+
+        // Past the shared quad pattern a face mesh can't be drawn, indexed vertices have no such limit
+        if (format == EngineModel::VertexFormat::VoxelFaces && builder.faces.size() > EngineMeshHeap::MAX_QUADS_PER_DRAW) {
+            meshChunk (neighbourhood, builder, EngineModel::VertexFormat::PackedVoxel);
+            return;
+        }
+
+        builder.computeBounds();
+    }
+
+    glm::vec3 VoxelMesher::blockColor (BlockId block) {
+        switch (block) {
+            case BLOCK_STONE: return {0.5f, 0.5f, 0.5f};
+            case BLOCK_DIRT: return {0.45f, 0.3f, 0.15f};
+            case BLOCK_GRASS: return {0.25f, 0.6f, 0.2f};
+            default: return {1.0f, 1.0f, 1.0f};
+        }
+    }
+
+    uint32_t VoxelMesher::blockTextureLayer (BlockId block) {
+        return block == BLOCK_AIR ? 0 : static_cast<uint32_t>(block - 1);
+    }
+
+} // engine::voxel
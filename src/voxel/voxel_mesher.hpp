@@ -0,0 +1,56 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_VOXEL_MESHER_HPP
+#define VULKANENGINE_VOXEL_MESHER_HPP
+
+#include "voxel_chunk.hpp"
+#include "voxel_world.hpp"
+#include "../engine_model.hpp"
+
+// std
+#include <array>
+#include <memory>
+
+namespace engine::voxel {
+
+    enum class ChunkFace : int {
+        NegativeX = 0,
+        PositiveX = 1,
+        NegativeY = 2,
+        PositiveY = 3,
+        NegativeZ = 4,
+        PositiveZ = 5
+    };
+
+    // A chunk plus the six chunks sharing a face with it, missing neighbours are treated as air
+    struct ChunkNeighbourhood {
+        std::shared_ptr<const VoxelChunk> center{};
+        std::array<std::shared_ptr<const VoxelChunk>, 6> neighbours{};
+
+        static ChunkNeighbourhood gather (const VoxelWorld &world, const glm::ivec3 &chunkCoord);
+        static glm::ivec3 faceOffset (ChunkFace face);
+    };
+
+    /**
+     * Greedy mesher, merges coplanar visible faces of the same block type into as few quads as possible.
+     * Meshes are in chunk local space, the owning game object is expected to translate to the chunk origin. Either
+     * indexed packed voxel vertices or one packed face per quad for the vertex pulling pipeline, which is about a
+     * seventh of the memory.
+     */
+    class VoxelMesher {
+    public:
+        // Replaces the contents of builder, leaves it empty if no face is visible. A VoxelFaces mesh with more than
+        // EngineMeshHeap::MAX_QUADS_PER_DRAW faces comes back as PackedVoxel instead, check builder.vertexFormat
+        static void meshChunk (const ChunkNeighbourhood &neighbourhood, EngineModel::Builder &builder,
+                               EngineModel::VertexFormat format = EngineModel::VertexFormat::VoxelFaces);
+
+        static glm::vec3 blockColor (BlockId block);
+        // Layer of the block texture array, tiles are loaded in filename order which follows the block ids
+        static uint32_t blockTextureLayer (BlockId block);
+    };
+
+} // engine::voxel
+
+#endif //VULKANENGINE_VOXEL_MESHER_HPP
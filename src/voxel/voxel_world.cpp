@@ -0,0 +1,99 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#include "voxel_world.hpp"
+#include "../engine_utils.hpp"
+
+namespace engine::voxel {
+
+    // Floor division so negative world positions land in the chunk below rather than chunk 0
+    static int floorDiv (int value, int divisor) {
+        int quotient = value / divisor;
+        if ((value % divisor != 0) && ((value < 0) != (divisor < 0)))
+            quotient--;
+        return quotient;
+    }
+
+    size_t ChunkCoordHash::operator() (const glm::ivec3 &coord) const {
+        size_t seed = 0;
+        hashCombine (seed, coord.x, coord.y, coord.z);
+        return seed;
+    }
+
+    std::shared_ptr<VoxelChunk> VoxelWorld::getChunk (const glm::ivec3 &chunkCoord) const {
+        std::shared_lock<std::shared_mutex> lock{chunksMutex};
+        auto it = chunks.find (chunkCoord);
+        if (it == chunks.end())
+            return nullptr;
+        return it->second;
+    }
+
+    std::shared_ptr<VoxelChunk> VoxelWorld::getOrCreateChunk (const glm::ivec3 &chunkCoord) {
+        std::unique_lock<std::shared_mutex> lock{chunksMutex};
+        auto &chunk = chunks[chunkCoord];
+        if (chunk == nullptr) {
+            chunk = std::make_shared<VoxelChunk>();
+        }
+        return chunk;
+    }
+
+    void VoxelWorld::setChunk (const glm::ivec3 &chunkCoord, std::shared_ptr<VoxelChunk> chunk) {
+        std::unique_lock<std::shared_mutex> lock{chunksMutex};
+        chunks[chunkCoord] = std::move (chunk);
+    }
+
+    bool VoxelWorld::removeChunk (const glm::ivec3 &chunkCoord) {
+        std::unique_lock<std::shared_mutex> lock{chunksMutex};
+        return chunks.erase (chunkCoord) > 0;
+    }
+
+    bool VoxelWorld::hasChunk (const glm::ivec3 &chunkCoord) const {
+        std::shared_lock<std::shared_mutex> lock{chunksMutex};
+        return chunks.count (chunkCoord) > 0;
+    }
+
+    size_t VoxelWorld::chunkCount () const {
+        std::shared_lock<std::shared_mutex> lock{chunksMutex};
+        return chunks.size();
+    }
+
+    BlockId VoxelWorld::getBlock (const glm::ivec3 &worldPos) const {
+        std::shared_lock<std::shared_mutex> lock{chunksMutex};
+        auto it = chunks.find (worldToChunk (worldPos));
+        if (it == chunks.end())
+            return BLOCK_AIR;
+        auto local = worldToLocal (worldPos);
+        return it->second->get (local.x, local.y, local.z);
+    }
+
+    void VoxelWorld::setBlock (const glm::ivec3 &worldPos, BlockId block) {
+        auto local = worldToLocal (worldPos);
+        getOrCreateChunk (worldToChunk (worldPos))->set (local.x, local.y, local.z, block);
+    }
+
+    size_t VoxelWorld::memoryUsage () const {
+        std::shared_lock<std::shared_mutex> lock{chunksMutex};
+
+        // Rough per node cost of the hash map on top of the chunks themselves
+        size_t total = chunks.bucket_count() * sizeof (void *);
+        for (const auto &kv : chunks) {
+            total += sizeof (ChunkMap::value_type) + 2 * sizeof (void *);
+            total += kv.second->memoryUsage();
+        }
+        return total;
+    }
+
+    glm::ivec3 VoxelWorld::worldToChunk (const glm::ivec3 &worldPos) {
+        return {
+            floorDiv (worldPos.x, VoxelChunk::SIZE),
+            floorDiv (worldPos.y, VoxelChunk::SIZE),
+            floorDiv (worldPos.z, VoxelChunk::SIZE)
+        };
+    }
+
+    glm::ivec3 VoxelWorld::worldToLocal (const glm::ivec3 &worldPos) {
+        return worldPos - worldToChunk (worldPos) * VoxelChunk::SIZE;
+    }
+
+} // engine::voxel
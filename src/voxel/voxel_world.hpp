@@ -0,0 +1,70 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+
+#ifndef VULKANENGINE_VOXEL_WORLD_HPP
+#define VULKANENGINE_VOXEL_WORLD_HPP
+
+#include "voxel_chunk.hpp"
+
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace engine::voxel {
+
+    struct ChunkCoordHash {
+        size_t operator() (const glm::ivec3 &coord) const;
+    };
+
+    /**
+     * Sparse collection of chunks keyed by chunk coordinate. Chunk (0, 0, 0) covers world blocks
+     * [0, VoxelChunk::SIZE) on every axis.
+     *
+     * The chunk map is guarded by a reader/writer lock so generation jobs can publish chunks while other
+     * threads read. Chunks themselves are not locked, a chunk should be fully built before setChunk and
+     * not edited while a mesh job may be reading it.
+     */
+    class VoxelWorld {
+    public:
+        using ChunkMap = std::unordered_map<glm::ivec3, std::shared_ptr<VoxelChunk>, ChunkCoordHash>;
+
+        VoxelWorld () = default;
+
+        VoxelWorld (const VoxelWorld &) = delete;
+        VoxelWorld &operator= (const VoxelWorld &) = delete;
+
+        [[nodiscard]] std::shared_ptr<VoxelChunk> getChunk (const glm::ivec3 &chunkCoord) const;
+        std::shared_ptr<VoxelChunk> getOrCreateChunk (const glm::ivec3 &chunkCoord);
+        void setChunk (const glm::ivec3 &chunkCoord, std::shared_ptr<VoxelChunk> chunk);
+        bool removeChunk (const glm::ivec3 &chunkCoord);
+        [[nodiscard]] bool hasChunk (const glm::ivec3 &chunkCoord) const;
+
+        // World block access, missing chunks read as air
+        [[nodiscard]] BlockId getBlock (const glm::ivec3 &worldPos) const;
+        void setBlock (const glm::ivec3 &worldPos, BlockId block);
+
+        [[nodiscard]] size_t chunkCount () const;
+        [[nodiscard]] size_t memoryUsage () const;
+
+        // Not locked, only use while no job can add or remove chunks
+        [[nodiscard]] const ChunkMap &getChunks () const { return chunks; }
+
+        static glm::ivec3 worldToChunk (const glm::ivec3 &worldPos);
+        static glm::ivec3 worldToLocal (const glm::ivec3 &worldPos);
+        static glm::ivec3 chunkToWorld (const glm::ivec3 &chunkCoord) { return chunkCoord * VoxelChunk::SIZE; }
+
+    private:
+        mutable std::shared_mutex chunksMutex{};
+        ChunkMap chunks{};
+    };
+
+} // engine::voxel
+
+#endif //VULKANENGINE_VOXEL_WORLD_HPP
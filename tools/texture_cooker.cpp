@@ -0,0 +1,453 @@
+//
+// Created by Peter Lewis on 2026-10-16.
+//
+// Offline texture cooker, decodes an image once at build time and writes it as block compressed .vtex with the full
+// mip chain, so the engine only has to copy blocks into a staging buffer.
+//
+//   Texture_Cooker <input image> <output.vtex> [bc1|bc3|bc7] [--linear]
+//
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "../src/engine_texture_file.hpp"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace engine;
+
+namespace {
+    using Format = texture_file::Format;
+
+    struct Image {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        // RGBA8, tightly packed
+        std::vector<uint8_t> pixels{};
+    };
+
+    // 4x4 texels, RGBA
+    using Block = std::array<std::array<float, 4>, 16>;
+
+    float srgbToLinear (uint8_t value) {
+        float c = static_cast<float>(value) / 255.0f;
+        return c <= 0.04045f ? c / 12.92f : std::pow ((c + 0.055f) / 1.055f, 2.4f);
+    }
+
+    uint8_t linearToSrgb (float value) {
+        float c = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow (value, 1.0f / 2.4f) - 0.055f;
+        return static_cast<uint8_t>(std::clamp (std::lround (c * 255.0f), 0l, 255l));
+    }
+
+    // 2x2 box filter, colour is averaged in linear space when it's sRGB so mips don't darken
+    Image downsample (const Image &source, bool srgb) {
+        Image result{};
+        result.width = std::max (source.width / 2, 1u);
+        result.height = std::max (source.height / 2, 1u);
+        result.pixels.resize (static_cast<size_t>(result.width) * result.height * 4);
+
+        for (uint32_t y = 0; y < result.height; y++) {
+            for (uint32_t x = 0; x < result.width; x++) {
+                std::array<float, 4> sum{};
+                for (uint32_t sy = 0; sy < 2; sy++) {
+                    for (uint32_t sx = 0; sx < 2; sx++) {
+                        uint32_t px = std::min (x * 2 + sx, source.width - 1);
+                        uint32_t py = std::min (y * 2 + sy, source.height - 1);
+                        const uint8_t *texel = &source.pixels[(static_cast<size_t>(py) * source.width + px) * 4];
+                        for (int c = 0; c < 3; c++)
+                            sum[c] += srgb ? srgbToLinear (texel[c]) : static_cast<float>(texel[c]);
+                        sum[3] += static_cast<float>(texel[3]);
+                    }
+                }
+
+                uint8_t *out = &result.pixels[(static_cast<size_t>(y) * result.width + x) * 4];
+                for (int c = 0; c < 3; c++)
+                    out[c] = srgb ? linearToSrgb (sum[c] / 4.0f) : static_cast<uint8_t>(std::lround (sum[c] / 4.0f));
+                out[3] = static_cast<uint8_t>(std::lround (sum[3] / 4.0f));
+            }
+        }
+        return result;
+    }
+
+    // Edge blocks of images that aren't a multiple of 4 repeat the last row and column
+    Block extractBlock (const Image &image, uint32_t blockX, uint32_t blockY) {
+        Block block{};
+        for (uint32_t i = 0; i < 16; i++) {
+            uint32_t px = std::min (blockX * 4 + i % 4, image.width - 1);
+            uint32_t py = std::min (blockY * 4 + i / 4, image.height - 1);
+            const uint8_t *texel = &image.pixels[(static_cast<size_t>(py) * image.width + px) * 4];
+            for (int c = 0; c < 4; c++)
+                block[i][c] = static_cast<float>(texel[c]);
+        }
+        return block;
+    }
+
+    /**
+     * Endpoints for a block, the two ends of the block's colours projected onto their principal axis.
+     * Only the first channelCount channels are considered.
+     */
+    void principalEndpoints (const Block &block, int channelCount, std::array<float, 4> &low, std::array<float, 4> &high) {
+        std::array<float, 4> mean{};
+        for (const auto &texel : block) {
+            for (int c = 0; c < channelCount; c++)
+                mean[c] += texel[c] / 16.0f;
+        }
+
+        float covariance[4][4]{};
+        for (const auto &texel : block) {
+            for (int i = 0; i < channelCount; i++) {
+                for (int j = 0; j < channelCount; j++)
+                    covariance[i][j] += (texel[i] - mean[i]) * (texel[j] - mean[j]);
+            }
+        }
+
+        // Power iteration, a handful of steps is plenty for a 4x4 block
+        std::array<float, 4> axis{1.0f, 1.0f, 1.0f, 1.0f};
+        for (int iteration = 0; iteration < 8; iteration++) {
+            std::array<float, 4> next{};
+            for (int i = 0; i < channelCount; i++) {
+                for (int j = 0; j < channelCount; j++)
+                    next[i] += covariance[i][j] * axis[j];
+            }
+            float length = 0.0f;
+            for (int c = 0; c < channelCount; c++)
+                length = std::max (length, std::abs (next[c]));
+            if (length < 1e-6f)
+                break;
+            for (int c = 0; c < channelCount; c++)
+                axis[c] = next[c] / length;
+        }
+
+        float axisLengthSquared = 0.0f;
+        for (int c = 0; c < channelCount; c++)
+            axisLengthSquared += axis[c] * axis[c];
+
+        float minProjection = 0.0f, maxProjection = 0.0f;
+        for (const auto &texel : block) {
+            float projection = 0.0f;
+            for (int c = 0; c < channelCount; c++)
+                projection += (texel[c] - mean[c]) * axis[c];
+            projection /= axisLengthSquared;
+            minProjection = std::min (minProjection, projection);
+            maxProjection = std::max (maxProjection, projection);
+        }
+
+        for (int c = 0; c < 4; c++) {
+            low[c] = c < channelCount ? std::clamp (mean[c] + axis[c] * minProjection, 0.0f, 255.0f) : 255.0f;
+            high[c] = c < channelCount ? std::clamp (mean[c] + axis[c] * maxProjection, 0.0f, 255.0f) : 255.0f;
+        }
+    }
+
+    float distanceSquared (const std::array<float, 4> &a, const std::array<float, 4> &b, int channelCount) {
+        float distance = 0.0f;
+        for (int c = 0; c < channelCount; c++)
+            distance += (a[c] - b[c]) * (a[c] - b[c]);
+        return distance;
+    }
+
+    uint16_t packRgb565 (const std::array<float, 4> &colour) {
+        auto r = static_cast<uint16_t>(std::lround (colour[0] * 31.0f / 255.0f));
+        auto g = static_cast<uint16_t>(std::lround (colour[1] * 63.0f / 255.0f));
+        auto b = static_cast<uint16_t>(std::lround (colour[2] * 31.0f / 255.0f));
+        return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+    }
+
+    std::array<float, 4> unpackRgb565 (uint16_t packed) {
+        uint32_t r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        return {static_cast<float>((r << 3) | (r >> 2)), static_cast<float>((g << 2) | (g >> 4)), static_cast<float>((b << 3) | (b >> 2)), 255.0f};
+    }
+
+    // Always four colour mode, which is also the only mode the colour half of BC3 has
+    void encodeBC1 (const Block &block, uint8_t *out) {
+        std::array<float, 4> low{}, high{};
+        principalEndpoints (block, 3, low, high);
+
+        uint16_t colour0 = packRgb565 (high);
+        uint16_t colour1 = packRgb565 (low);
+        if (colour0 < colour1)
+            std::swap (colour0, colour1);
+
+        uint32_t indices = 0;
+        if (colour0 != colour1) {
+            std::array<std::array<float, 4>, 4> palette{};
+            palette[0] = unpackRgb565 (colour0);
+            palette[1] = unpackRgb565 (colour1);
+            for (int c = 0; c < 3; c++) {
+                palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+                palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+            }
+
+            for (uint32_t i = 0; i < 16; i++) {
+                uint32_t best = 0;
+                float bestDistance = distanceSquared (block[i], palette[0], 3);
+                for (uint32_t p = 1; p < 4; p++) {
+                    float distance = distanceSquared (block[i], palette[p], 3);
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+                indices |= best << (i * 2);
+            }
+        }
+
+        out[0] = static_cast<uint8_t>(colour0 & 0xFF);
+        out[1] = static_cast<uint8_t>(colour0 >> 8);
+        out[2] = static_cast<uint8_t>(colour1 & 0xFF);
+        out[3] = static_cast<uint8_t>(colour1 >> 8);
+        for (int i = 0; i < 4; i++)
+            out[4 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+
+    // The alpha half of BC3, eight interpolated values between the block's min and max
+    void encodeAlphaBlock (const Block &block, uint8_t *out) {
+        float minAlpha = 255.0f, maxAlpha = 0.0f;
+        for (const auto &texel : block) {
+            minAlpha = std::min (minAlpha, texel[3]);
+            maxAlpha = std::max (maxAlpha, texel[3]);
+        }
+        auto alpha0 = static_cast<uint8_t>(std::lround (maxAlpha));
+        auto alpha1 = static_cast<uint8_t>(std::lround (minAlpha));
+
+        uint64_t indices = 0;
+        if (alpha0 != alpha1) {
+            std::array<float, 8> palette{static_cast<float>(alpha0), static_cast<float>(alpha1)};
+            for (int p = 2; p < 8; p++)
+                palette[p] = (static_cast<float>(8 - p) * alpha0 + static_cast<float>(p - 1) * alpha1) / 7.0f;
+
+            for (uint32_t i = 0; i < 16; i++) {
+                uint64_t best = 0;
+                float bestDistance = std::abs (block[i][3] - palette[0]);
+                for (uint64_t p = 1; p < 8; p++) {
+                    float distance = std::abs (block[i][3] - palette[p]);
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+                indices |= best << (i * 3);
+            }
+        }
+
+        out[0] = alpha0;
+        out[1] = alpha1;
+        for (int i = 0; i < 6; i++)
+            out[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+
+    void encodeBC3 (const Block &block, uint8_t *out) {
+        encodeAlphaBlock (block, out);
+        encodeBC1 (block, out + 8);
+    }
+
+    // Writes fields into a 128 bit block starting from the lowest bit
+    class BitWriter {
+    public:
+        explicit BitWriter (uint8_t *out) : out{out} { std::memset (out, 0, 16); }
+
+        void write (uint32_t value, uint32_t bitCount) {
+            for (uint32_t i = 0; i < bitCount; i++, position++) {
+                if ((value >> i) & 1)
+                    out[position / 8] |= static_cast<uint8_t>(1u << (position % 8));
+            }
+        }
+
+    private:
+        uint8_t *out;
+        uint32_t position = 0;
+    };
+
+    // BC7 mode 6 only, one subset with RGBA 7.7.7.7 endpoints plus a p-bit each and 4 bit indices.
+    // Not the best BC7 can do on blocks with several distinct colours, but fast and well above BC1 on gradients
+    void encodeBC7 (const Block &block, uint8_t *out) {
+        static constexpr std::array<uint32_t, 16> WEIGHTS{0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+        std::array<float, 4> low{}, high{};
+        principalEndpoints (block, 4, low, high);
+
+        // Each endpoint is 7 bits per channel plus a shared lowest bit, keep whichever p-bit lands closer
+        std::array<std::array<uint32_t, 4>, 2> endpoints{};
+        std::array<uint32_t, 2> pBits{};
+        const std::array<float, 4> *targets[2] = {&low, &high};
+        for (int e = 0; e < 2; e++) {
+            float bestError = -1.0f;
+            for (uint32_t p = 0; p < 2; p++) {
+                std::array<uint32_t, 4> quantized{};
+                float error = 0.0f;
+                for (int c = 0; c < 4; c++) {
+                    float target = (*targets[e])[c];
+                    quantized[c] = static_cast<uint32_t>(std::clamp (std::lround ((target - static_cast<float>(p)) / 2.0f), 0l, 127l));
+                    float reconstructed = static_cast<float>((quantized[c] << 1) | p);
+                    error += (reconstructed - target) * (reconstructed - target);
+                }
+                if (bestError < 0.0f || error < bestError) {
+                    bestError = error;
+                    endpoints[e] = quantized;
+                    pBits[e] = p;
+                }
+            }
+        }
+
+        std::array<std::array<float, 4>, 16> palette{};
+        for (uint32_t w = 0; w < 16; w++) {
+            for (int c = 0; c < 4; c++) {
+                uint32_t e0 = (endpoints[0][c] << 1) | pBits[0];
+                uint32_t e1 = (endpoints[1][c] << 1) | pBits[1];
+                palette[w][c] = static_cast<float>(((64 - WEIGHTS[w]) * e0 + WEIGHTS[w] * e1 + 32) >> 6);
+            }
+        }
+
+        std::array<uint32_t, 16> indices{};
+        for (uint32_t i = 0; i < 16; i++) {
+            float bestDistance = distanceSquared (block[i], palette[0], 4);
+            for (uint32_t w = 1; w < 16; w++) {
+                float distance = distanceSquared (block[i], palette[w], 4);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    indices[i] = w;
+                }
+            }
+        }
+
+        // The first index is stored without its top bit, flip the endpoints so it is always clear
+        if (indices[0] >= 8) {
+            std::swap (endpoints[0], endpoints[1]);
+            std::swap (pBits[0], pBits[1]);
+            for (auto &index : indices)
+                index = 15 - index;
+        }
+
+        BitWriter writer{out};
+        writer.write (1u << 6, 7);
+        for (int c = 0; c < 4; c++) {
+            writer.write (endpoints[0][c], 7);
+            writer.write (endpoints[1][c], 7);
+        }
+        writer.write (pBits[0], 1);
+        writer.write (pBits[1], 1);
+        writer.write (indices[0], 3);
+        for (uint32_t i = 1; i < 16; i++)
+            writer.write (indices[i], 4);
+    }
+
+    std::vector<uint8_t> compressLevel (const Image &image, Format format) {
+        uint32_t blocksWide = (image.width + texture_file::BLOCK_DIMENSION - 1) / texture_file::BLOCK_DIMENSION;
+        uint32_t blocksHigh = (image.height + texture_file::BLOCK_DIMENSION - 1) / texture_file::BLOCK_DIMENSION;
+        uint32_t blockSize = texture_file::bytesPerBlock (format);
+
+        std::vector<uint8_t> data (texture_file::levelSize (format, image.width, image.height));
+        for (uint32_t by = 0; by < blocksHigh; by++) {
+            for (uint32_t bx = 0; bx < blocksWide; bx++) {
+                Block block = extractBlock (image, bx, by);
+                uint8_t *out = &data[(static_cast<size_t>(by) * blocksWide + bx) * blockSize];
+                switch (format) {
+                    case Format::BC1: encodeBC1 (block, out); break;
+                    case Format::BC3: encodeBC3 (block, out); break;
+                    case Format::BC7: encodeBC7 (block, out); break;
+                }
+            }
+        }
+        return data;
+    }
+
+    bool parseFormat (const std::string &name, Format &format) {
+        if (name == "bc1") format = Format::BC1;
+        else if (name == "bc3") format = Format::BC3;
+        else if (name == "bc7") format = Format::BC7;
+        else return false;
+        return true;
+    }
+}
+
+int main (int argc, char *argv[]) {
+    auto consoleSink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+    auto logger = std::make_shared<spdlog::logger>("main", consoleSink);
+    logger->set_pattern ("%v");
+    spdlog::register_logger (logger);
+    spdlog::set_default_logger (logger);
+    auto log = spdlog::get ("main");
+
+    if (argc < 3) {
+        log->error ("Usage: {} <input image> <output.vtex> [bc1|bc3|bc7] [--linear]", argv[0]);
+        return EXIT_FAILURE;
+    }
+    std::string inputPath = argv[1];
+    std::string outputPath = argv[2];
+
+    Format format = Format::BC7;
+    bool srgb = true;
+    for (int i = 3; i < argc; i++) {
+        std::string argument = argv[i];
+        if (argument == "--linear") {
+            srgb = false;
+        } else if (!parseFormat (argument, format)) {
+            log->error ("Unknown option {}", argument);
+            return EXIT_FAILURE;
+        }
+    }
+
+    int width, height, channels;
+    stbi_uc *data = stbi_load (inputPath.c_str(), &width, &height, &channels, 4);
+    if (data == nullptr) {
+        log->error ("Failed to load {}: {}", inputPath, stbi_failure_reason());
+        return EXIT_FAILURE;
+    }
+
+    Image level{static_cast<uint32_t>(width), static_cast<uint32_t>(height), {}};
+    level.pixels.assign (data, data + static_cast<size_t>(width) * height * 4);
+    stbi_image_free (data);
+
+    texture_file::Header header{};
+    header.format = format;
+    header.flags = srgb ? static_cast<uint32_t>(texture_file::FLAG_SRGB) : 0u;
+    header.width = level.width;
+    header.height = level.height;
+    header.mipLevels = static_cast<uint32_t>(std::floor (std::log2 (std::max (width, height)))) + 1;
+
+    std::vector<texture_file::MipLevel> mipLevels (header.mipLevels);
+    std::vector<uint8_t> blocks{};
+    for (uint32_t mip = 0; mip < header.mipLevels; mip++) {
+        if (mip > 0)
+            level = downsample (level, srgb);
+
+        std::vector<uint8_t> compressed = compressLevel (level, format);
+        mipLevels[mip].offset = blocks.size();
+        mipLevels[mip].size = compressed.size();
+        mipLevels[mip].width = level.width;
+        mipLevels[mip].height = level.height;
+        blocks.insert (blocks.end(), compressed.begin(), compressed.end());
+    }
+
+    std::ofstream file{outputPath, std::ios::binary | std::ios::trunc};
+    if (!file) {
+        log->error ("Failed to open {} for writing", outputPath);
+        return EXIT_FAILURE;
+    }
+    file.write (reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write (reinterpret_cast<const char *>(mipLevels.data()), static_cast<std::streamsize>(mipLevels.size() * sizeof(texture_file::MipLevel)));
+    file.write (reinterpret_cast<const char *>(blocks.data()), static_cast<std::streamsize>(blocks.size()));
+    if (!file) {
+        log->error ("Failed to write {}", outputPath);
+        return EXIT_FAILURE;
+    }
+
+    // What the engine used to upload, mip 0 alone as RGBA8
+    auto uncompressedSize = static_cast<double>(width) * height * 4;
+    log->info ("Cooked {} ({}x{}, {} mips) to {}: {} KiB, {:.1f}x smaller than uncompressed RGBA8 without mips",
+               inputPath, width, height, header.mipLevels, outputPath, blocks.size() / 1024,
+               uncompressedSize / static_cast<double>(blocks.size()));
+    return EXIT_SUCCESS;
+}